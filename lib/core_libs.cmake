@@ -4,6 +4,7 @@
 
 set(CORE_LIBS)
 
+find_package(Threads REQUIRED)
 list(APPEND CORE_LIBS ${CMAKE_THREAD_LIBS_INIT})
 
 # Generates source for shared message data types using protobuf
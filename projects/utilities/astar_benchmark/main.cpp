@@ -0,0 +1,287 @@
+// Copyright 2022 UBC Sailbot
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <pathfinding/AStarPathfinder.h>
+#include <pathfinding/AStarSearch.h>
+#include <pathfinding/BasicCostCalculator.h>
+#include <pathfinding/BasicHexMap.h>
+#include <pathfinding/BidirectionalAStarPathfinder.h>
+#include <pathfinding/HaversineCostCalculator.h>
+#include <pathfinding/HaversineHeuristic.h>
+#include <pathfinding/LandmarkHeuristic.h>
+#include <pathfinding/WeatherCostCalculator.h>
+#include <pathfinding/WeatherHexMap.h>
+#include <planet/HexPlanet.h>
+
+namespace {
+
+/**
+ * The totals of a series of pathfinder runs.
+ */
+struct RunTotals {
+  double seconds = 0;
+  size_t expansions = 0;
+  size_t backward_expansions = 0;
+  uint64_t cost = 0;
+};
+
+template<typename Search>
+void HideProgress(Search *pathfinder) {
+  pathfinder->set_show_progress(false);
+}
+
+/**
+ * BidirectionalAStarPathfinder has no progress bar.
+ */
+void HideProgress(BidirectionalAStarPathfinder *) {}
+
+/**
+ * Run |Search| (AStarPathfinder, an AStarSearch or BidirectionalAStarPathfinder) on |query|, adding the time of the
+ * search alone to |totals|.
+ */
+template<typename Search, typename CostCalculatorType, typename HeuristicType>
+void RunQuery(const HexPlanet &planet,
+              const HeuristicType &heuristic,
+              const CostCalculatorType &cost_calculator,
+              const std::pair<HexVertexId, HexVertexId> &query,
+              bool use_indirect_neighbours,
+              RunTotals *totals) {
+  Search pathfinder(planet, heuristic, cost_calculator, query.first, query.second, use_indirect_neighbours);
+  HideProgress(&pathfinder);
+
+  const auto start_time = std::chrono::steady_clock::now();
+  const Pathfinder::Result result = pathfinder.Run();
+  const std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start_time;
+
+  totals->seconds += elapsed_seconds.count();
+  totals->expansions += pathfinder.stats().expansions;
+  totals->backward_expansions += pathfinder.stats().backward_expansions;
+  totals->cost += result.cost;
+}
+
+/**
+ * Run |Search| on every query with a HaversineHeuristic, see RunQuery().
+ */
+template<typename Search, typename CostCalculatorType>
+RunTotals RunQueries(const HexPlanet &planet,
+                     const CostCalculatorType &cost_calculator,
+                     const std::vector<std::pair<HexVertexId, HexVertexId>> &queries,
+                     bool use_indirect_neighbours) {
+  RunTotals totals;
+  for (const auto &query : queries) {
+    const HaversineHeuristic heuristic(planet, query.second);
+    RunQuery<Search>(planet, heuristic, cost_calculator, query, use_indirect_neighbours, &totals);
+  }
+  return totals;
+}
+
+/**
+ * Compare the virtual AStarPathfinder with the AStarSearch bound to CostCalculatorType on |queries|.
+ */
+template<typename CostCalculatorType>
+void Compare(const std::string &scenario,
+             const HexPlanet &planet,
+             const CostCalculatorType &cost_calculator,
+             const std::vector<std::pair<HexVertexId, HexVertexId>> &queries,
+             bool use_indirect_neighbours) {
+  const RunTotals virtual_totals = RunQueries<AStarPathfinder>(planet, cost_calculator, queries,
+                                                               use_indirect_neighbours);
+  const RunTotals static_totals = RunQueries<AStarSearch<HaversineHeuristic, CostCalculatorType>>(
+      planet, cost_calculator, queries, use_indirect_neighbours);
+
+  std::cout << scenario << (use_indirect_neighbours ? " (indirect neighbours)" : "") << std::endl
+            << "  Expansions:                " << virtual_totals.expansions << std::endl
+            << "  AStarPathfinder seconds:   " << virtual_totals.seconds << " ("
+            << virtual_totals.expansions / virtual_totals.seconds << " expansions/s)" << std::endl
+            << "  AStarSearch seconds:       " << static_totals.seconds << " ("
+            << static_totals.expansions / static_totals.seconds << " expansions/s)" << std::endl
+            << "  Speedup:                   " << virtual_totals.seconds / static_totals.seconds << std::endl;
+  if (virtual_totals.cost != static_totals.cost) {
+    std::cout << "  Path costs differ: " << virtual_totals.cost << " vs " << static_totals.cost << std::endl;
+  }
+}
+
+/**
+ * Compare the unidirectional AStarPathfinder with BidirectionalAStarPathfinder on |queries|.
+ */
+void CompareBidirectional(const std::string &scenario,
+                          const HexPlanet &planet,
+                          const CostCalculator &cost_calculator,
+                          const std::vector<std::pair<HexVertexId, HexVertexId>> &queries,
+                          bool use_indirect_neighbours) {
+  const RunTotals unidirectional_totals = RunQueries<AStarPathfinder>(planet, cost_calculator, queries,
+                                                                     use_indirect_neighbours);
+  const RunTotals bidirectional_totals = RunQueries<BidirectionalAStarPathfinder>(planet, cost_calculator, queries,
+                                                                                  use_indirect_neighbours);
+
+  std::cout << scenario << (use_indirect_neighbours ? " (indirect neighbours)" : "") << ", bidirectional" << std::endl
+            << "  Unidirectional expansions: " << unidirectional_totals.expansions << " in "
+            << unidirectional_totals.seconds << "s" << std::endl
+            << "  Bidirectional expansions:  " << bidirectional_totals.expansions << " ("
+            << bidirectional_totals.backward_expansions << " backward) in " << bidirectional_totals.seconds << "s"
+            << std::endl
+            << "  Expansions saved:          "
+            << 100.0 * (1.0 - static_cast<double>(bidirectional_totals.expansions) / unidirectional_totals.expansions)
+            << "%" << std::endl
+            << "  Speedup:                   " << unidirectional_totals.seconds / bidirectional_totals.seconds
+            << std::endl;
+  if (unidirectional_totals.cost != bidirectional_totals.cost) {
+    std::cout << "  Path costs differ: " << unidirectional_totals.cost << " vs " << bidirectional_totals.cost
+              << std::endl;
+  }
+}
+
+/**
+ * Compare the AStarSearch bound to CostCalculatorType with a HaversineHeuristic and with a LandmarkHeuristic of
+ * |landmark_count| landmarks picked among |candidates| on |queries|.
+ */
+template<typename CostCalculatorType>
+void CompareLandmarks(const std::string &scenario,
+                      const HexPlanet &planet,
+                      const CostCalculatorType &cost_calculator,
+                      const std::vector<std::pair<HexVertexId, HexVertexId>> &queries,
+                      bool use_indirect_neighbours,
+                      size_t landmark_count,
+                      const std::vector<HexVertexId> &candidates,
+                      unsigned thread_count) {
+  const auto build_start_time = std::chrono::steady_clock::now();
+  const LandmarkHeuristic::CostSurface surface(planet, cost_calculator, use_indirect_neighbours, thread_count);
+  const LandmarkHeuristic landmark_heuristic(
+      planet, surface, LandmarkHeuristic::SelectLandmarks(planet, landmark_count, candidates, thread_count),
+      thread_count);
+  const std::chrono::duration<double> build_seconds = std::chrono::steady_clock::now() - build_start_time;
+
+  const RunTotals haversine_totals = RunQueries<AStarSearch<HaversineHeuristic, CostCalculatorType>>(
+      planet, cost_calculator, queries, use_indirect_neighbours);
+  RunTotals landmark_totals;
+  for (const auto &query : queries) {
+    RunQuery<AStarSearch<LandmarkHeuristic, CostCalculatorType>>(planet, landmark_heuristic, cost_calculator, query,
+                                                                 use_indirect_neighbours, &landmark_totals);
+  }
+
+  std::cout << scenario << (use_indirect_neighbours ? " (indirect neighbours)" : "") << ", "
+            << landmark_heuristic.landmarks().size() << " landmarks" << std::endl
+            << "  Landmark tables built in:  " << build_seconds.count() << "s" << std::endl
+            << "  Haversine expansions:      " << haversine_totals.expansions << " in " << haversine_totals.seconds
+            << "s" << std::endl
+            << "  Landmark expansions:       " << landmark_totals.expansions << " in " << landmark_totals.seconds
+            << "s" << std::endl
+            << "  Expansions saved:          "
+            << 100.0 * (1.0 - static_cast<double>(landmark_totals.expansions) / haversine_totals.expansions) << "%"
+            << std::endl
+            << "  Speedup:                   " << haversine_totals.seconds / landmark_totals.seconds << std::endl;
+  if (haversine_totals.cost != landmark_totals.cost) {
+    std::cout << "  Path costs differ: " << haversine_totals.cost << " vs " << landmark_totals.cost << std::endl;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+  boost::program_options::options_description desc{"Options"};
+  desc.add_options()
+      ("help,h", "Help screen")
+      ("p,planet_size", boost::program_options::value<int>()->default_value(8), "Planet Size")
+      ("n,queries", boost::program_options::value<size_t>()->default_value(20), "Number of queries per scenario")
+      ("input_csvs", boost::program_options::value<std::string>()->default_value("input_csvs"),
+       "Relative path to folder from which to read in csvs as weather data")
+      ("grib", boost::program_options::value<std::string>(), "Relative path to grb file, used instead of csvs")
+      ("t,time_steps", boost::program_options::value<int>()->default_value(4), "Forecast time steps")
+      ("w,weather_factor", boost::program_options::value<int>()->default_value(1500), "Weather Factor")
+      ("threads", boost::program_options::value<unsigned>()->default_value(0),
+       "Number of threads building the cost and landmark tables, 0 to use all hardware threads")
+      ("landmarks", boost::program_options::value<size_t>()->default_value(16), "Number of landmarks")
+      ("region", boost::program_options::value<std::vector<int>>()->multitoken(),
+       "<north> <east> <south> <west> forecast region, defaults to the one of the checked in csvs");
+
+  boost::program_options::variables_map vm;
+  store(parse_command_line(argc, argv, desc), vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<int> region = {48, 235, 21, 203};
+  if (vm.count("region")) {
+    region = vm["region"].as<std::vector<int>>();
+    if (region.size() != 4) {
+      std::cerr << "The region requires four values: <north> <east> <south> <west>" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const bool use_csvs = vm.count("grib") == 0;
+  const std::string file_name = use_csvs ? vm["input_csvs"].as<std::string>() : vm["grib"].as<std::string>();
+  const size_t query_count = vm["n"].as<size_t>();
+  const HexPlanet planet(static_cast<uint8_t>(vm["p"].as<int>()));
+  std::mt19937 generator(0);
+
+  // Distance costs between any two vertices of the planet.
+  std::uniform_int_distribution<HexVertexId> vertex(0, static_cast<HexVertexId>(planet.vertex_count() - 1));
+  std::vector<std::pair<HexVertexId, HexVertexId>> haversine_queries(query_count);
+  for (auto &query : haversine_queries) {
+    query = {vertex(generator), vertex(generator)};
+  }
+  const HaversineCostCalculator haversine_cost_calculator(planet);
+  Compare("Haversine costs", planet, haversine_cost_calculator, haversine_queries, false);
+  Compare("Haversine costs", planet, haversine_cost_calculator, haversine_queries, true);
+  CompareBidirectional("Haversine costs", planet, haversine_cost_calculator, haversine_queries, true);
+
+  // Distance plus random vertex risks of up to twice an edge length, for which the distance heuristic is weak.
+  std::uniform_int_distribution<uint32_t> risk(0, 2 * planet.graph().neighbour_distances(0)[0]);
+  std::vector<uint32_t> risks(planet.vertex_count());
+  for (auto &vertex_risk : risks) {
+    vertex_risk = risk(generator);
+  }
+  auto basic_map = std::make_unique<BasicHexMap>(planet, risks);
+  const BasicCostCalculator basic_cost_calculator(planet, basic_map);
+  CompareBidirectional("Random risk costs", planet, basic_cost_calculator, haversine_queries, false);
+  CompareLandmarks("Random risk costs", planet, basic_cost_calculator, haversine_queries, false,
+                   vm["landmarks"].as<size_t>(), {}, vm["threads"].as<unsigned>());
+
+  // Weather costs between vertices of the forecast region, as in the pathfinder_cli.
+  auto map = std::make_unique<WeatherHexMap>(planet, static_cast<uint32_t>(vm["t"].as<int>()), region[0], region[1],
+                                             region[2], region[3], false, file_name, use_csvs);
+  std::vector<HexVertexId> region_vertices;
+  for (HexVertexId id = 0; id < planet.vertex_count(); id++) {
+    if (map->get(WeatherHexMap::Channel::kWindSpeed, id, 0) != WeatherHexMap::kOutOfRegionWindSpeed) {
+      region_vertices.push_back(id);
+    }
+  }
+  if (region_vertices.empty()) {
+    std::cerr << "No vertices in the forecast region" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::uniform_int_distribution<size_t> region_vertex(0, region_vertices.size() - 1);
+  std::vector<std::pair<HexVertexId, HexVertexId>> weather_queries(query_count);
+  for (auto &query : weather_queries) {
+    query = {region_vertices[region_vertex(generator)], region_vertices[region_vertex(generator)]};
+  }
+  const int weather_factor = static_cast<int>(vm["w"].as<int>() * std::pow(2, 10 - vm["p"].as<int>()));
+  WeatherCostCalculator weather_cost_calculator(planet, map, weather_factor);
+  Compare("Weather costs", planet, weather_cost_calculator, weather_queries, true);
+
+  const auto build_start_time = std::chrono::steady_clock::now();
+  weather_cost_calculator.BuildCostTables(vm["threads"].as<unsigned>());
+  const std::chrono::duration<double> build_seconds = std::chrono::steady_clock::now() - build_start_time;
+  std::cout << "Cost tables: " << weather_cost_calculator.cost_table_memory_usage() / (1024.0 * 1024.0) << " MB for "
+            << weather_cost_calculator.time_horizon() + 1 << " time steps, built in " << build_seconds.count() << "s"
+            << std::endl;
+  Compare("Weather costs from cost tables", planet, weather_cost_calculator, weather_queries, true);
+  CompareLandmarks("Weather costs from cost tables", planet, weather_cost_calculator, weather_queries, true,
+                   vm["landmarks"].as<size_t>(), region_vertices, vm["threads"].as<unsigned>());
+
+  return EXIT_SUCCESS;
+}
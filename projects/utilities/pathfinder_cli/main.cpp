@@ -8,9 +8,12 @@
 #include <boost/program_options.hpp>
 
 #include <pathfinding/HaversineHeuristic.h>
+#include <pathfinding/LandmarkHeuristic.h>
 #include <pathfinding/HaversineCostCalculator.h>
 #include <pathfinding/WeatherCostCalculator.h>
 #include <pathfinding/AStarPathfinder.h>
+#include <pathfinding/AStarSearch.h>
+#include <pathfinding/BatchPathfinder.h>
 #include <pathfinding/PathfinderResultPrinter.h>
 #include "pathfinding/WeatherHexMap.h"
 #include <logic/StandardCalc.h>
@@ -28,6 +31,14 @@ enum class OutputFormat {
 double start_lat, start_lon, end_lat, end_lon;
 int pointToPrint;
 bool preserveKml = false;
+WindKmlOptions wind_kml;
+WeatherHexMap::Interpolation weather_interpolation = WeatherHexMap::Interpolation::kNearest;
+uint32_t steps_per_forecast = 1;
+bool use_cost_tables = false;
+size_t landmark_count = 0;
+std::string cached_landmarks_path;
+bool store_landmarks = false;
+bool use_cached_landmarks = false;
 
 void find_neighbours(const HexPlanet &planet, HexVertexId id) {
   std::cout << "Finding neighbours for vertex ID: " << id << std::endl;
@@ -39,29 +50,108 @@ void find_neighbours(const HexPlanet &planet, HexVertexId id) {
   }
 }
 
-void find_coordinates(HexPlanet &planet, const std::vector<HexVertexId> &ids) {
+void find_coordinates(const HexPlanet &planet, const std::vector<HexVertexId> &ids) {
   std::cout << "Finding coordinates for vertices: <id> (<lat>, <lng>)" << std::endl;
   for (HexVertexId id : ids) {
     std::cout << id << " " << planet.vertex(id).coordinate.to_string() << std::endl;
   }
 }
 
-Pathfinder::Result run_pathfinder(HexPlanet &planet,
-                                  HexVertexId source,
-                                  HexVertexId target,
-                                  int weather_factor,
-                                  bool generate_new_grib,
-                                  const std::string & file_name,
-                                  int time_steps,
-                                  bool use_csvs,
-                                  const std::string & output_csvs_folder,
-                                  bool silent,
-                                  bool verbose) {
-  HaversineHeuristic heuristic = HaversineHeuristic(planet);
-  WeatherHexMap weather_map = WeatherHexMap(planet, time_steps, start_lat, start_lon, end_lat, end_lon, generate_new_grib, file_name, use_csvs, output_csvs_folder, preserveKml);
-  auto wmap_pointer = std::make_unique<WeatherHexMap>(weather_map);
-  WeatherCostCalculator cost_calculator = WeatherCostCalculator(planet, wmap_pointer, weather_factor);
-  AStarPathfinder pathfinder(planet, heuristic, cost_calculator, source, target, true);
+std::unique_ptr<WeatherCostCalculator> load_weather(const HexPlanet &planet,
+                                                    int weather_factor,
+                                                    bool generate_new_grib,
+                                                    const std::string & file_name,
+                                                    int time_steps,
+                                                    bool use_csvs,
+                                                    const std::string & output_csvs_folder,
+                                                    unsigned thread_count,
+                                                    bool verbose) {
+  auto wmap_pointer = std::make_unique<WeatherHexMap>(planet, time_steps, start_lat, start_lon, end_lat, end_lon,
+                                                      generate_new_grib, file_name, use_csvs, output_csvs_folder,
+                                                      wind_kml, weather_interpolation, steps_per_forecast);
+  auto cost_calculator = std::make_unique<WeatherCostCalculator>(planet, wmap_pointer, weather_factor);
+
+  if (use_cost_tables) {
+    auto start_time = std::chrono::system_clock::now();
+    cost_calculator->BuildCostTables(thread_count);
+    if (verbose) {
+      std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start_time;
+      std::cout << std::fixed
+                << "Cost tables: " << cost_calculator->cost_table_memory_usage() / (1024.0 * 1024.0) << " MB for "
+                << cost_calculator->time_horizon() + 1 << " time steps (" << elapsed_seconds.count() << "s)"
+                << std::endl;
+    }
+  }
+  return cost_calculator;
+}
+
+std::unique_ptr<LandmarkHeuristic> load_landmarks(const HexPlanet &planet,
+                                                  const WeatherCostCalculator &cost_calculator,
+                                                  unsigned thread_count,
+                                                  bool silent,
+                                                  bool verbose) {
+  auto start_time = std::chrono::system_clock::now();
+  // The tables are only valid for the weather they were computed with, which the fingerprint identifies without
+  // building the cost surface
+  const uint64_t fingerprint = LandmarkHeuristic::CostSurface::Fingerprint(planet, cost_calculator, true);
+  std::unique_ptr<LandmarkHeuristic> heuristic;
+
+  if (use_cached_landmarks && LandmarkHeuristic::IsLandmarkFile(cached_landmarks_path)) {
+    try {
+      heuristic = std::make_unique<LandmarkHeuristic>(planet, cached_landmarks_path, fingerprint);
+      if (heuristic->landmarks().size() != landmark_count) {
+        heuristic.reset();
+      }
+    } catch (const std::runtime_error &error) {
+      if (verbose) {
+        std::cout << error.what() << std::endl;
+      }
+    }
+  }
+
+  if (!heuristic) {
+    // Landmarks at the edges of the forecast region, outside of which paths are very expensive
+    std::vector<HexVertexId> candidates;
+    for (HexVertexId vertex = 0; vertex < planet.vertex_count(); vertex++) {
+      if (cost_calculator.map().get(WeatherHexMap::Channel::kWindSpeed, vertex, 0) <
+          WeatherHexMap::kOutOfRegionWindSpeed) {
+        candidates.push_back(vertex);
+      }
+    }
+    const LandmarkHeuristic::CostSurface surface(planet, cost_calculator, true, thread_count);
+    heuristic = std::make_unique<LandmarkHeuristic>(
+        planet, surface, LandmarkHeuristic::SelectLandmarks(planet, landmark_count, candidates, thread_count),
+        thread_count);
+
+    if (store_landmarks) {
+      if (!silent) {
+        std::cout << "Storing landmarks at " << cached_landmarks_path << std::endl;
+      }
+      heuristic->WriteToFile(cached_landmarks_path);
+    }
+  }
+
+  if (verbose) {
+    std::chrono::duration<double> elapsed_seconds = std::chrono::system_clock::now() - start_time;
+    std::cout << std::fixed
+              << "Landmarks: " << heuristic->landmarks().size() << " (" << elapsed_seconds.count() << "s)"
+              << std::endl;
+  }
+  return heuristic;
+}
+
+template<typename HeuristicType>
+Pathfinder::Result run_search(const HexPlanet &planet,
+                              const HeuristicType &heuristic,
+                              HexVertexId source,
+                              HexVertexId target,
+                              const WeatherCostCalculator &cost_calculator,
+                              AStarPathfinder::OpenSetType open_set_type,
+                              const Pathfinder::Limits &limits,
+                              bool silent,
+                              bool verbose) {
+  AStarSearch<HeuristicType, WeatherCostCalculator> pathfinder(planet, heuristic, cost_calculator, source, target,
+                                                               true, open_set_type, limits);
 
   if (!silent) {
     std::cout << "Pathfinding from " << source << " to " << target << std::endl;
@@ -80,7 +170,11 @@ Pathfinder::Result run_pathfinder(HexPlanet &planet,
       auto stats = pathfinder.stats();
       std::cout << std::fixed
                 << "Closed Set: " << stats.closed_set_size << std::endl
-                << "Open Set:   " << stats.open_set_size << " (on exit)" << std::endl;
+                << "Open Set:   " << stats.open_set_size << " (on exit)" << std::endl
+                << "Pushes:     " << stats.pushes << std::endl
+                << "Pops:       " << stats.pops << " (" << stats.stale_pops << " stale)" << std::endl
+                << "Decreases:  " << stats.decrease_keys << std::endl
+                << "Expansions: " << stats.expansions << std::endl;
     }
 
     std::cout << std::endl;
@@ -89,9 +183,107 @@ Pathfinder::Result run_pathfinder(HexPlanet &planet,
   return result;
 }
 
-HexPlanet generate_planet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth, bool silent, bool verbose, bool store_planet, bool use_cached_planet) {
+Pathfinder::Result run_pathfinder(const HexPlanet &planet,
+                                  HexVertexId source,
+                                  HexVertexId target,
+                                  const WeatherCostCalculator &cost_calculator,
+                                  AStarPathfinder::OpenSetType open_set_type,
+                                  const Pathfinder::Limits &limits,
+                                  unsigned thread_count,
+                                  bool silent,
+                                  bool verbose) {
+  if (landmark_count > 0) {
+    const auto heuristic = load_landmarks(planet, cost_calculator, thread_count, silent, verbose);
+    return run_search(planet, *heuristic, source, target, cost_calculator, open_set_type, limits, silent, verbose);
+  }
+  HaversineHeuristic heuristic = HaversineHeuristic(planet, target);
+  return run_search(planet, heuristic, source, target, cost_calculator, open_set_type, limits, silent, verbose);
+}
+
+std::vector<BatchPathfinder::Query> read_batch_queries(const std::string &file_name) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    throw std::runtime_error("Could not open batch file: " + file_name);
+  }
+
+  std::vector<BatchPathfinder::Query> queries;
+  BatchPathfinder::Query query;
+  while (file >> query.start >> query.target) {
+    queries.push_back(query);
+  }
+  if (!file.eof()) {
+    throw std::runtime_error("Batch file must contain <start> <end> vertex ID pairs: " + file_name);
+  }
+  return queries;
+}
+
+void run_batch_pathfinder(const HexPlanet &planet,
+                          const std::vector<BatchPathfinder::Query> &queries,
+                          int weather_factor,
+                          bool generate_new_grib,
+                          const std::string & file_name,
+                          int time_steps,
+                          bool use_csvs,
+                          const std::string & output_csvs_folder,
+                          AStarPathfinder::OpenSetType open_set_type,
+                          const Pathfinder::Limits &limits,
+                          unsigned thread_count,
+                          bool silent,
+                          bool verbose) {
+  // The weather is loaded once and shared by all queries.
+  const auto cost_calculator = load_weather(planet, weather_factor, generate_new_grib, file_name, time_steps, use_csvs,
+                                            output_csvs_folder, thread_count, verbose);
+  // Landmark tables don't depend on the target, so one heuristic serves all queries
+  std::unique_ptr<LandmarkHeuristic> landmark_heuristic;
+  if (landmark_count > 0) {
+    landmark_heuristic = load_landmarks(planet, *cost_calculator, thread_count, silent, verbose);
+  }
+  const auto batch_pathfinder = landmark_heuristic ?
+      BatchPathfinder(planet, *cost_calculator, *landmark_heuristic, true, open_set_type, limits, thread_count) :
+      BatchPathfinder(planet, *cost_calculator, [&planet](HexVertexId target) {
+        return std::unique_ptr<Heuristic>(new HaversineHeuristic(planet, target, 1));
+      }, true, open_set_type, limits, thread_count);
+
+  if (!silent) {
+    std::cout << "Pathfinding " << queries.size() << " queries" << std::endl;
+  }
+  auto start_time = std::chrono::system_clock::now();
+
+  const auto results = batch_pathfinder.Run(queries);
+
+  if (!silent) {
+    auto end_time = std::chrono::system_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
+    std::cout << std::fixed
+              << "Pathfinding Complete (" << elapsed_seconds.count() << "s)" << std::endl << std::endl;
+  }
+
+  for (size_t i = 0; i < queries.size(); i++) {
+    std::cout << "Query " << i << ": " << queries[i].start << " -> " << queries[i].target << std::endl;
+    if (!results[i].error.empty()) {
+      std::cout << "Error: " << results[i].error << std::endl << std::endl;
+      continue;
+    }
+
+    std::cout << PathfinderResultPrinter::PrintDefault(results[i].result);
+    if (verbose) {
+      const auto &stats = results[i].stats;
+      std::cout << "Closed Set: " << stats.closed_set_size << std::endl
+                << "Expansions: " << stats.expansions << std::endl;
+    }
+    std::cout << std::endl;
+  }
+}
+
+HexPlanet generate_planet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth, unsigned thread_count, bool silent, bool verbose, bool store_planet, bool use_cached_planet) {
   auto start_time = std::chrono::system_clock::now();
-  const std::string path_to_cached_planet = "cached_planets/size_" + std::to_string(subdivision_level) + ".txt";
+  const std::string cached_planet_prefix = "cached_planets/size_" + std::to_string(subdivision_level);
+  const std::string path_to_binary_planet = cached_planet_prefix + ".bin";
+  const std::string path_to_text_planet = cached_planet_prefix + ".txt";
+
+  // Prefer the memory-mappable binary cache, fall back to the legacy text format
+  const std::string path_to_cached_planet =
+      HexPlanet::IsBinaryFile(path_to_binary_planet) ? path_to_binary_planet : path_to_text_planet;
   if (!silent) {
     if (use_cached_planet) {
       std::cout << "Looking for cached planet at " << path_to_cached_planet << std::endl;
@@ -102,8 +294,8 @@ HexPlanet generate_planet(uint8_t subdivision_level, uint8_t indirect_neighbour_
   }
   HexPlanet planet = (use_cached_planet) ? HexPlanet(path_to_cached_planet) :
                      (indirect_neighbour_depth != kInvalidIndirectNeighbourDepth) ?
-                     HexPlanet(subdivision_level, indirect_neighbour_depth) :
-                     HexPlanet(subdivision_level);
+                     HexPlanet(subdivision_level, indirect_neighbour_depth, thread_count) :
+                     HexPlanet(subdivision_level, HexPlanet::kDefaultIndirectNeighbourDepth, thread_count);
 
   if (!silent) {
     auto end_time = std::chrono::system_clock::now();
@@ -114,7 +306,8 @@ HexPlanet generate_planet(uint8_t subdivision_level, uint8_t indirect_neighbour_
     if (verbose) {
       std::cout << std::fixed
                 << "Vertices:  " << planet.vertex_count() << std::endl
-                << "Triangles: " << planet.triangle_count() << std::endl;
+                << "Triangles: " << planet.triangle_count() << std::endl
+                << "Graph:     " << planet.graph().memory_usage() / (1024.0 * 1024.0) << " MB" << std::endl;
     }
 
     std::cout << std::endl;
@@ -123,9 +316,9 @@ HexPlanet generate_planet(uint8_t subdivision_level, uint8_t indirect_neighbour_
   if (store_planet)
   {
     if (!silent) {
-      std::cout << "Storing planet at " << path_to_cached_planet << std::endl;
+      std::cout << "Storing planet at " << path_to_binary_planet << std::endl;
     }
-    planet.WriteToFile(path_to_cached_planet);
+    planet.WriteBinaryToFile(path_to_binary_planet);
   }
 
   return planet;
@@ -144,26 +337,51 @@ int main(int argc, char const *argv[]) {
          "Relative path to folder from which to read in csvs as weather data.")
         ("output_csvs", boost::program_options::value<std::string>(),
          "Relative path to existing folder in which weather data csvs will be created")
+        ("snapshot", boost::program_options::value<std::string>(),
+         "Relative path to a binary weather snapshot (see weather_snapshot), used instead of grib or csvs.")
         ("p,planet_size", boost::program_options::value<int>()->default_value(1), "Planet Size")
         ("w,weather_factor", boost::program_options::value<int>()->default_value(1500), "Weather Factor")
         ("n,neighbour", boost::program_options::value<HexVertexId>(), "Vertex to find neighbours")
         ("i,indirect", boost::program_options::value<int>(), "Indirect neighbour depth")
         ("t,time_steps", boost::program_options::value<int>()->default_value(4), "Max time steps for wind speed")
+        ("threads", boost::program_options::value<unsigned>()->default_value(0),
+         "Number of worker threads, 0 to use all hardware threads")
+        ("open_set", boost::program_options::value<std::string>()->default_value("binary"),
+         "Pathfinder open set: binary, indexed (decrease-key heap) or radix")
+        ("max_time", boost::program_options::value<uint32_t>(), "Maximum time index of a path")
+        ("max_expansions", boost::program_options::value<size_t>(), "Maximum number of pathfinder state expansions")
+        ("max_seconds", boost::program_options::value<double>(), "Maximum pathfinder wall clock time in seconds")
+        ("max_memory_mb", boost::program_options::value<size_t>(), "Maximum pathfinder open and closed set memory in MB")
         ("c,coordinates",
          boost::program_options::value<std::vector<HexVertexId>>()->multitoken(),
          "Vertices for which to find GPS Coordinates")
         ("f,find_path",
          boost::program_options::value<std::vector<HexVertexId>>()->multitoken(),
          "<start> <end> Vertex IDs")
+        ("batch", boost::program_options::value<std::string>(),
+         "File of <start> <end> vertex ID pairs to find paths for concurrently, using --threads threads")
         ("table", "Connect to network table")
         ("navigate",
          boost::program_options::value<std::vector<double>>()->multitoken(),
          "<start_latitude> <start_longitude> <end_latitude> <end_longitude>")
         ("kml", "Output the a KML file for the pathfinding result")
-        ("store_planet", "Output the a file to store the planet as a cache")
-        ("use_cached_planet", "Use cached_planet in cached_planets/size_<size>.txt")
+        ("store_planet", "Output the a file to store the planet as a cache (cached_planets/size_<size>.bin)")
+        ("use_cached_planet", "Use cached_planet in cached_planets/size_<size>.bin, or size_<size>.txt if there is no .bin")
         ("printn", boost::program_options::value<int>(), "Output the nth coordinate pair at the end of the program, starting with 1")
-        ("save", "Save the current weather as a timestamped KML")
+        ("save", "Save the KMLs with timestamps in resultKMLs/")
+        ("wind_kml", "Write the wind overlay Wind.kml")
+        ("wind_kml_stride", boost::program_options::value<int>()->default_value(1),
+         "Only put every nth grid point along each row and column in Wind.kml")
+        ("wind_kml_min_speed", boost::program_options::value<double>()->default_value(0),
+         "Only put grid points with at least this wind speed (knots) in Wind.kml")
+        ("bilinear", "Interpolate the weather bilinearly between grid points instead of using the nearest one")
+        ("steps_per_forecast", boost::program_options::value<uint32_t>()->default_value(1),
+         "Pathfinder time steps per forecast time step, the weather is blended linearly in between")
+        ("landmarks", boost::program_options::value<size_t>(),
+         "Use a landmark heuristic with this many landmarks in the forecast region instead of distances. With "
+         "--store_planet/--use_cached_planet, the tables are cached in cached_planets/size_<size>_landmarks.bin. "
+         "With --batch, all queries share the tables")
+        ("cost_tables", "Precompute the weather cost of every edge and time step (4 bytes each, see --v for the total)")
         ("hardcoded", boost::program_options::value<std::string>(), "Default use: --hardcoded {Month}, {Month} = Oct, Nov, Dec etc.");
 
     boost::program_options::variables_map vm;
@@ -188,6 +406,11 @@ int main(int argc, char const *argv[]) {
       generate_new_grib = false;
       file_name = vm["input_csvs"].as<std::string>();
       use_csvs = true;
+    } else if (vm.count("snapshot")) {
+      // WeatherHexMap recognizes snapshots from their header
+      generate_new_grib = false;
+      file_name = vm["snapshot"].as<std::string>();
+      use_csvs = false;
     }
 
     bool silent = vm.count("s") > 0;
@@ -210,6 +433,22 @@ int main(int argc, char const *argv[]) {
       preserveKml = true;
     }
 
+    wind_kml.enabled = vm.count("wind_kml") > 0;
+    wind_kml.preserve = preserveKml;
+    wind_kml.stride = vm["wind_kml_stride"].as<int>();
+    wind_kml.min_wind_speed = vm["wind_kml_min_speed"].as<double>();
+
+    if (vm.count("bilinear") > 0) {
+      weather_interpolation = WeatherHexMap::Interpolation::kBilinear;
+    }
+
+    steps_per_forecast = vm["steps_per_forecast"].as<uint32_t>();
+    if (steps_per_forecast == 0) {
+      throw std::runtime_error("--steps_per_forecast must be at least 1");
+    }
+
+    use_cost_tables = vm.count("cost_tables") > 0;
+
     bool verbose = vm.count("v") > 0 && !silent;
 
     uint8_t planet_size = static_cast<uint8_t> (vm["p"].as<int>());
@@ -217,16 +456,53 @@ int main(int argc, char const *argv[]) {
                                                            : kInvalidIndirectNeighbourDepth;
     const bool store_planet = vm.count("store_planet") > 0;
     const bool use_cached_planet = vm.count("use_cached_planet") > 0;
-    HexPlanet planet = generate_planet(planet_size, indirect_neighbour_depth, silent, verbose, store_planet, use_cached_planet);
+    const unsigned thread_count = vm["threads"].as<unsigned>();
+    if (vm.count("landmarks")) {
+      landmark_count = vm["landmarks"].as<size_t>();
+      cached_landmarks_path = "cached_planets/size_" + std::to_string(planet_size) + "_landmarks.bin";
+      store_landmarks = store_planet;
+      use_cached_landmarks = use_cached_planet;
+    }
+    HexPlanet planet = generate_planet(planet_size, indirect_neighbour_depth, thread_count, silent, verbose, store_planet, use_cached_planet);
 
     int time_steps = vm["t"].as<int>();
 
+    const std::string open_set_name = vm["open_set"].as<std::string>();
+    AStarPathfinder::OpenSetType open_set_type;
+    if (open_set_name == "binary") {
+      open_set_type = AStarPathfinder::OpenSetType::kBinaryHeap;
+    } else if (open_set_name == "indexed") {
+      open_set_type = AStarPathfinder::OpenSetType::kIndexedHeap;
+    } else if (open_set_name == "radix") {
+      open_set_type = AStarPathfinder::OpenSetType::kRadixHeap;
+    } else {
+      throw std::runtime_error("Unknown open set: " + open_set_name);
+    }
+
+    Pathfinder::Limits limits;
+    if (vm.count("max_time")) {
+      limits.max_time = vm["max_time"].as<uint32_t>();
+    }
+    if (vm.count("max_expansions")) {
+      limits.max_expansions = vm["max_expansions"].as<size_t>();
+    }
+    if (vm.count("max_seconds")) {
+      limits.max_duration = std::chrono::milliseconds(static_cast<int64_t>(vm["max_seconds"].as<double>() * 1000));
+    }
+    if (vm.count("max_memory_mb")) {
+      limits.max_memory = vm["max_memory_mb"].as<size_t>() * 1024 * 1024;
+    }
+
     int weather_factor = vm["w"].as<int>() * std::pow(2,10-planet_size);
 
     if (vm.count("n")) {
       find_neighbours(planet, vm["n"].as<HexVertexId>());
     } else if (vm.count("c")) {
       find_coordinates(planet, vm["c"].as<std::vector<HexVertexId>>());
+    } else if (vm.count("batch")) {
+      const auto queries = read_batch_queries(vm["batch"].as<std::string>());
+      run_batch_pathfinder(planet, queries, weather_factor, generate_new_grib, file_name, time_steps, use_csvs,
+                           output_csvs_folder, open_set_type, limits, thread_count, silent, verbose);
     } else if (vm.count("f")) {
       auto points = vm["f"].as<std::vector<HexVertexId>>();
 
@@ -234,8 +510,10 @@ int main(int argc, char const *argv[]) {
         throw std::runtime_error("Pathfinding requires two hex IDs: <start> <end>");
       }
 
-      auto result = run_pathfinder(planet, points[0], points[1], weather_factor, generate_new_grib, file_name,
-                                   time_steps, use_csvs, output_csvs_folder, silent, verbose);
+      const auto cost_calculator = load_weather(planet, weather_factor, generate_new_grib, file_name, time_steps,
+                                                use_csvs, output_csvs_folder, thread_count, verbose);
+      auto result = run_pathfinder(planet, points[0], points[1], *cost_calculator, open_set_type, limits,
+                                   thread_count, silent, verbose);
 
       switch (format) {
         case OutputFormat::kDefault:
@@ -249,7 +527,7 @@ int main(int argc, char const *argv[]) {
           break;
         case OutputFormat::kKML:
           // Print KML
-          std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, file_name, time_steps, use_csvs, output_csvs_folder, pointToPrint, preserveKml, false);
+          std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, cost_calculator->map(), pointToPrint, preserveKml, false);
           break;
       }
     } else if (vm.count("navigate")) {
@@ -328,17 +606,13 @@ int main(int argc, char const *argv[]) {
       const GPSCoordinateFast start_coord(start_lat, adj_start_lon, true);
       const GPSCoordinateFast end_coord(end_lat, adj_end_lon, true);
 
-      Eigen::Vector3f start_point;
-      Eigen::Vector3f end_point;
-
-      standard_calc::CoordToPoint(start_coord, &start_point);
-      standard_calc::CoordToPoint(end_coord, &end_point);
-
-      HexVertexId start_vertex = planet.HexVertexFromPoint(start_point);
-      HexVertexId end_vertex = planet.HexVertexFromPoint(end_point);
+      HexVertexId start_vertex = planet.NearestVertex(start_coord);
+      HexVertexId end_vertex = planet.NearestVertex(end_coord);
 
-      auto result = run_pathfinder(planet, start_vertex, end_vertex, weather_factor, generate_new_grib, file_name,
-                                   time_steps, use_csvs, output_csvs_folder, silent, verbose);
+      const auto cost_calculator = load_weather(planet, weather_factor, generate_new_grib, file_name, time_steps,
+                                                use_csvs, output_csvs_folder, thread_count, verbose);
+      auto result = run_pathfinder(planet, start_vertex, end_vertex, *cost_calculator, open_set_type, limits,
+                                   thread_count, silent, verbose);
 
       std::vector<std::pair<double, double>> waypoints;
 
@@ -365,9 +639,9 @@ int main(int argc, char const *argv[]) {
           std::cout << "Could not set waypoint values" << std::endl;
         }
       } if (vm.count("hardcoded")) {
-        std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, file_name, time_steps, use_csvs, output_csvs_folder, pointToPrint, preserveKml, true);
+        std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, cost_calculator->map(), pointToPrint, preserveKml, true);
       } else {
-        std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, file_name, time_steps, use_csvs, output_csvs_folder, pointToPrint, preserveKml, false);
+        std::cout << PathfinderResultPrinter::PrintKML(planet, result, weather_factor, cost_calculator->map(), pointToPrint, preserveKml, false);
       }
 
     } else {
@@ -0,0 +1,185 @@
+// Copyright 2022 UBC Sailbot
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include <grib/gribParse.h>
+#include <pathfinding/WeatherHexMap.h>
+#include <planet/HexPlanet.h>
+
+namespace {
+
+/**
+ * Time |lookup_count| wind speed lookups at random in-region vertices and times.
+ * @return The number of lookups per second.
+ */
+double BenchmarkLookups(const WeatherHexMap &map,
+                        const std::vector<HexVertexId> &vertices,
+                        const std::vector<uint32_t> &times,
+                        size_t lookup_count) {
+  // Map every tile first so only the lookups themselves are timed.
+  for (HexVertexId vertex : vertices) {
+    map.get(WeatherHexMap::Channel::kWindSpeed, vertex, 0);
+  }
+
+  double sum = 0;
+  const auto start_time = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < lookup_count; i++) {
+    sum += map.get(WeatherHexMap::Channel::kWindSpeed, vertices[i % vertices.size()], times[i % times.size()]);
+  }
+  const std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start_time;
+
+  // Keep the lookups from being optimized out.
+  if (sum < 0) {
+    std::cout << sum << std::endl;
+  }
+  return lookup_count / elapsed_seconds.count();
+}
+
+/**
+ * Time the conversion of |point_count| random wind components to magnitudes and angles, point by point and with
+ * gribParse::convertWind.
+ * @return The number of million points per second of the point by point loop and of convertWind.
+ */
+std::pair<double, double> BenchmarkWindConversion(size_t point_count) {
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> component(-30, 30);
+  std::vector<double> u_comp(point_count), v_comp(point_count);
+  for (size_t i = 0; i < point_count; i++) {
+    u_comp[i] = component(generator);
+    v_comp[i] = component(generator);
+  }
+  std::vector<double> magnitudes(point_count), angles(point_count);
+  constexpr int kRepetitions = 10;
+
+  auto point_by_point = [&]() {
+    for (size_t i = 0; i < point_count; i++) {
+      angles[i] = gribParse::calcAngle(u_comp[i], v_comp[i]);
+      magnitudes[i] = gribParse::calcMagnitude(u_comp[i], v_comp[i]);
+    }
+  };
+  auto kernel = [&]() {
+    gribParse::convertWind(u_comp.data(), v_comp.data(), point_count, magnitudes.data(), angles.data());
+  };
+  auto time = [](const std::function<void()> &conversion, std::chrono::duration<double> *seconds) {
+    const auto start_time = std::chrono::steady_clock::now();
+    conversion();
+    *seconds += std::chrono::steady_clock::now() - start_time;
+  };
+
+  // Warm up the buffers untimed, then alternate which conversion runs first so neither gets the warmer caches
+  point_by_point();
+  kernel();
+  std::chrono::duration<double> point_seconds(0), kernel_seconds(0);
+  for (int repetition = 0; repetition < kRepetitions; repetition++) {
+    if (repetition % 2 == 0) {
+      time(point_by_point, &point_seconds);
+      time(kernel, &kernel_seconds);
+    } else {
+      time(kernel, &kernel_seconds);
+      time(point_by_point, &point_seconds);
+    }
+  }
+
+  const double million_points = kRepetitions * point_count / 1e6;
+  return {million_points / point_seconds.count(), million_points / kernel_seconds.count()};
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+  boost::program_options::options_description desc{"Options"};
+  desc.add_options()
+      ("help,h", "Help screen")
+      ("p,planet_size", boost::program_options::value<int>()->default_value(8), "Planet Size")
+      ("input_csvs", boost::program_options::value<std::string>()->default_value("input_csvs"),
+       "Relative path to folder from which to read in csvs as weather data")
+      ("grib", boost::program_options::value<std::string>(), "Relative path to grb file, used instead of csvs")
+      ("t,time_steps", boost::program_options::value<int>()->default_value(4), "Forecast time steps")
+      ("steps_per_forecast", boost::program_options::value<int>()->default_value(3),
+       "Pathfinder time steps per forecast step for the interpolated map")
+      ("n,lookups", boost::program_options::value<size_t>()->default_value(50000000), "Number of lookups to time")
+      ("grid_points", boost::program_options::value<size_t>()->default_value(1000000),
+       "Number of grid points for the wind conversion benchmark")
+      ("region", boost::program_options::value<std::vector<int>>()->multitoken(),
+       "<north> <east> <south> <west> forecast region, defaults to the one of the checked in csvs");
+
+  boost::program_options::variables_map vm;
+  store(parse_command_line(argc, argv, desc), vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help")) {
+    std::cout << desc;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<int> region = {48, 235, 21, 203};
+  if (vm.count("region")) {
+    region = vm["region"].as<std::vector<int>>();
+    if (region.size() != 4) {
+      std::cerr << "The region requires four values: <north> <east> <south> <west>" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  const bool use_csvs = vm.count("grib") == 0;
+  const std::string file_name = use_csvs ? vm["input_csvs"].as<std::string>() : vm["grib"].as<std::string>();
+  const uint32_t time_steps = static_cast<uint32_t>(vm["t"].as<int>());
+  const uint32_t steps_per_forecast = static_cast<uint32_t>(vm["steps_per_forecast"].as<int>());
+  const size_t lookup_count = vm["n"].as<size_t>();
+
+  const HexPlanet planet(static_cast<uint8_t>(vm["p"].as<int>()), 0);
+  const WeatherHexMap nearest_map(planet, time_steps, region[0], region[1], region[2], region[3], false, file_name,
+                                  use_csvs);
+  const WeatherHexMap bilinear_map(planet, time_steps, region[0], region[1], region[2], region[3], false, file_name,
+                                   use_csvs, "", WindKmlOptions(), WeatherHexMap::Interpolation::kBilinear,
+                                   steps_per_forecast);
+
+  // Only benchmark vertices inside the region, the others are answered by a constant.
+  std::vector<HexVertexId> vertices;
+  for (HexVertexId vertex = 0; vertex < planet.vertex_count(); vertex++) {
+    if (nearest_map.get(WeatherHexMap::Channel::kWindSpeed, vertex, 0) != WeatherHexMap::kOutOfRegionWindSpeed) {
+      vertices.push_back(vertex);
+    }
+  }
+  if (vertices.empty()) {
+    std::cerr << "No vertices in the forecast region" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 generator(0);
+  std::shuffle(vertices.begin(), vertices.end(), generator);
+  std::uniform_int_distribution<uint32_t> forecast_time(0, time_steps - 1);
+  std::uniform_int_distribution<uint32_t> pathfinder_time(0, bilinear_map.time_horizon());
+  std::vector<uint32_t> forecast_times(4093), pathfinder_times(4093);
+  for (size_t i = 0; i < forecast_times.size(); i++) {
+    forecast_times[i] = forecast_time(generator);
+    pathfinder_times[i] = pathfinder_time(generator);
+  }
+
+  std::cout << std::fixed
+            << "Vertices in region: " << vertices.size() << " of " << planet.vertex_count() << std::endl
+            << "Nearest lookups/s:            " << BenchmarkLookups(nearest_map, vertices, forecast_times, lookup_count)
+            << std::endl
+            << "Bilinear lookups/s:           " << BenchmarkLookups(bilinear_map, vertices, forecast_times, lookup_count)
+            << std::endl
+            << "Bilinear + temporal lookups/s: "
+            << BenchmarkLookups(bilinear_map, vertices, pathfinder_times, lookup_count) << std::endl
+            << "Nearest memory:  " << nearest_map.memory_usage() << " bytes" << std::endl
+            << "Bilinear memory: " << bilinear_map.memory_usage() << " bytes" << std::endl;
+
+  const std::pair<double, double> conversion = BenchmarkWindConversion(vm["grid_points"].as<size_t>());
+  std::cout << "Point by point wind conversion Mpoints/s: " << conversion.first << std::endl
+            << "convertWind Mpoints/s:                    " << conversion.second << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+// Copyright 2022 UBC Sailbot
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/program_options.hpp>
+
+#include <grib/gribParse.h>
+
+/**
+ * Converts weather from a csvs folder (the input_csvs layout) or a GRIB file to a binary weather snapshot, which
+ * WeatherHexMap memory-maps instead of parsing.
+ */
+int main(int argc, char const *argv[]) {
+  boost::program_options::options_description desc{"Options"};
+  desc.add_options()
+      ("help,h", "Help screen")
+      ("input_csvs", boost::program_options::value<std::string>(),
+       "Relative path to folder from which to read in csvs as weather data")
+      ("grib", boost::program_options::value<std::string>(), "Relative path to grb file, used instead of csvs")
+      ("t,time_steps", boost::program_options::value<int>()->default_value(4), "Forecast time steps")
+      ("o,output", boost::program_options::value<std::string>()->default_value("weather.snap"),
+       "Path of the snapshot to write");
+
+  boost::program_options::variables_map vm;
+  store(parse_command_line(argc, argv, desc), vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help") || (vm.count("input_csvs") == 0) == (vm.count("grib") == 0)) {
+    std::cout << "Requires exactly one of --input_csvs or --grib" << std::endl << desc;
+    return EXIT_FAILURE;
+  }
+
+  const bool use_csvs = vm.count("input_csvs") > 0;
+  const std::string file_name = use_csvs ? vm["input_csvs"].as<std::string>() : vm["grib"].as<std::string>();
+  const std::string output = vm["o"].as<std::string>();
+
+  try {
+    gribParse(file_name, vm["t"].as<int>(), use_csvs).saveSnapshot(output);
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wrote " << output << std::endl;
+  return EXIT_SUCCESS;
+}
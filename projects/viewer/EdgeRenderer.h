@@ -3,6 +3,7 @@
 #ifndef EDGERENDERER_H_
 #define EDGERENDERER_H_
 
+#include <boost/unordered_map.hpp>
 #include <planet/HexPlanet.h>
 
 #include "Program.h"
@@ -0,0 +1,47 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef COMMON_FNV1AHASH_H_
+#define COMMON_FNV1AHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Incremental FNV-1a hash, used to tell whether cached data was computed from the same inputs.
+ * Not cryptographic, only meant to catch inputs that changed.
+ */
+class Fnv1aHash {
+ public:
+  /**
+   * Add |value|, byte by byte from the least significant one.
+   */
+  void add(uint64_t value) {
+    for (int byte = 0; byte < 8; byte++) {
+      hash_ = (hash_ ^ ((value >> (8 * byte)) & 0xff)) * kPrime;
+    }
+  }
+
+  /**
+   * Add the bit patterns of |count| floats.
+   */
+  void add(const float *values, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      uint32_t bits;
+      std::memcpy(&bits, &values[i], sizeof(bits));
+      add(bits);
+    }
+  }
+
+  /**
+   * @return The hash of everything added so far.
+   */
+  uint64_t value() const { return hash_; }
+
+ private:
+  static constexpr uint64_t kPrime = 1099511628211ull;
+
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
+#endif  // COMMON_FNV1AHASH_H_
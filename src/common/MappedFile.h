@@ -0,0 +1,72 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef COMMON_MAPPEDFILE_H_
+#define COMMON_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief A read-only memory mapping of an entire file.
+ * The mapping is released when the object is destroyed.
+ */
+class MappedFile {
+ public:
+  /**
+   * Map |filename| into memory.
+   * @param filename Path of the file to map.
+   * @throw std::runtime_error If the file can't be opened or mapped.
+   */
+  explicit MappedFile(const std::string &filename);
+
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  /// Class can't be copied
+  MappedFile(const MappedFile &) = delete;
+
+  /// Class can't be copy assigned
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @return Pointer to the first byte of the file.
+   */
+  const uint8_t *data() const { return data_; }
+
+  /**
+   * @return Size of the file in bytes.
+   */
+  size_t size() const { return size_; }
+
+  /**
+   * Get a typed pointer into the file, checking that the whole range lies within the mapping.
+   * @tparam T Element type.
+   * @param offset Byte offset from the start of the file.
+   * @param count Number of elements of type T.
+   * @throw std::runtime_error If the range isn't contained in the file.
+   * @return Pointer to the first element.
+   */
+  template<typename T>
+  const T *at(uint64_t offset, uint64_t count) const {
+    if (offset > size_ || count > (size_ - offset) / sizeof(T)) {
+      throw std::runtime_error("Mapped file range is out of bounds.");
+    }
+    return reinterpret_cast<const T *>(data_ + offset);
+  }
+
+  /**
+   * @param filename Path of the file.
+   * @return Whether a regular file exists at |filename|.
+   */
+  static bool Exists(const std::string &filename);
+
+ private:
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+#endif  // COMMON_MAPPEDFILE_H_
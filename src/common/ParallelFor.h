@@ -0,0 +1,115 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef COMMON_PARALLELFOR_H_
+#define COMMON_PARALLELFOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+/**
+ * @return The number of threads to use when the caller doesn't specify one (the number of hardware threads).
+ */
+inline unsigned DefaultThreadCount() {
+  const unsigned hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads == 0 ? 1 : hardware_threads;
+}
+
+/**
+ * @param thread_count Requested thread count, 0 for the default.
+ * @return The thread count to use.
+ */
+inline unsigned ResolveThreadCount(unsigned thread_count) {
+  return thread_count == 0 ? DefaultThreadCount() : thread_count;
+}
+
+/**
+ * Split [0, count) into contiguous chunks and call body(begin, end) for each chunk on its own thread.
+ * Chunks are assigned statically, so the work done for each index doesn't depend on the thread count. The calling
+ * thread processes the first chunk. If a body throws, the first exception is rethrown once all threads are joined.
+ * @param count Number of indices.
+ * @param thread_count Number of threads to use, 0 for DefaultThreadCount().
+ * @param body Callable taking (size_t begin, size_t end).
+ */
+template<typename Body>
+void ForRange(size_t count, unsigned thread_count, const Body &body) {
+  const size_t chunk_count = std::min<size_t>(ResolveThreadCount(thread_count), count);
+  if (chunk_count <= 1) {
+    if (count > 0) {
+      body(size_t{0}, count);
+    }
+    return;
+  }
+
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto run_chunk = [&](size_t chunk) {
+    const size_t begin = count * chunk / chunk_count;
+    const size_t end = count * (chunk + 1) / chunk_count;
+    try {
+      body(begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(chunk_count - 1);
+  for (size_t chunk = 1; chunk < chunk_count; chunk++) {
+    threads.emplace_back(run_chunk, chunk);
+  }
+  run_chunk(0);
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * Call body(i) for every i in [0, count), spread across threads as in ForRange().
+ * @param count Number of indices.
+ * @param thread_count Number of threads to use, 0 for DefaultThreadCount().
+ * @param body Callable taking (size_t i).
+ */
+template<typename Body>
+void For(size_t count, unsigned thread_count, const Body &body) {
+  ForRange(count, thread_count, [&body](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      body(i);
+    }
+  });
+}
+
+/**
+ * Call body(i) for every i in [0, count) on up to |thread_count| threads, each taking the next unprocessed index when
+ * it's done with its last one. Unlike For(), this balances work items of very different cost, but the thread that
+ * processes an index is arbitrary. Exceptions are handled as in ForRange().
+ * @param count Number of indices.
+ * @param thread_count Number of threads to use, 0 for DefaultThreadCount().
+ * @param body Callable taking (size_t i).
+ */
+template<typename Body>
+void ForDynamic(size_t count, unsigned thread_count, const Body &body) {
+  std::atomic<size_t> next_index(0);
+  ForRange(std::min<size_t>(ResolveThreadCount(thread_count), count), thread_count, [&](size_t, size_t) {
+    for (size_t i = next_index++; i < count; i = next_index++) {
+      body(i);
+    }
+  });
+}
+
+}  // namespace parallel
+
+#endif  // COMMON_PARALLELFOR_H_
@@ -1,34 +1,255 @@
 // Copyright 2017 UBC Sailbot
 #include "UrlDownloader.h"
 #include <stdio.h>
+#include <sys/stat.h>
 #include <curl/curl.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+
+constexpr const char *UrlDownloader::kDefaultCacheDirectory;
+constexpr int UrlDownloader::kForecastCycleHours;
+
+namespace {
 
 /**
- * Downloads a file based off the URL given
- * @param download URL
- * @return
+ * @return The size of |file_name|, 0 if it doesn't exist.
  */
+curl_off_t FileSize(const std::string & file_name) {
+  struct stat file_stat;
+  return stat(file_name.c_str(), &file_stat) == 0 ? file_stat.st_size : 0;
+}
 
-void UrlDownloader::Downloader(const std::string & url) {
+/**
+ * @return The value of the header |name| if |line| is that header, otherwise an empty string.
+ */
+std::string HeaderValue(const std::string & line, const std::string & name) {
+  if (line.size() <= name.size() || line[name.size()] != ':' ||
+      strncasecmp(line.c_str(), name.c_str(), name.size()) != 0) {
+    return "";
+  }
+  const size_t begin = line.find_first_not_of(" \t", name.size() + 1);
+  const size_t end = line.find_last_not_of(" \t\r\n");
+  return begin == std::string::npos || end < begin ? "" : line.substr(begin, end - begin + 1);
+}
+
+/// The state of one request, shared with the curl callbacks.
+struct Transfer {
   CURL *curl;
-  CURLcode res;
+  FILE *file;
+  /// Where the validator of the body written to |file| is saved.
+  std::string validator_file_name;
+  bool body_started;
+  /// The validators of the response, reset on each status line as redirects have their own headers.
+  std::string etag;
+  std::string last_modified;
+};
+
+/**
+ * @return The validator identifying the version of the resource, empty if the server sent none. Weak ETags can't be
+ *    used in If-Range.
+ */
+std::string Validator(const Transfer & transfer) {
+  if (!transfer.etag.empty() && transfer.etag.compare(0, 2, "W/") != 0) {
+    return transfer.etag;
+  }
+  return transfer.last_modified;
+}
+
+size_t ReadHeader(char *data, size_t size, size_t count, void *user_data) {
+  Transfer *transfer = static_cast<Transfer *>(user_data);
+  const std::string line(data, size * count);
+  if (line.compare(0, 5, "HTTP/") == 0) {
+    transfer->etag.clear();
+    transfer->last_modified.clear();
+  } else if (!HeaderValue(line, "ETag").empty()) {
+    transfer->etag = HeaderValue(line, "ETag");
+  } else if (!HeaderValue(line, "Last-Modified").empty()) {
+    transfer->last_modified = HeaderValue(line, "Last-Modified");
+  }
+  return size * count;
+}
+
+/**
+ * Prepares the part file for the body of the response. Anything but partial content is the whole resource, which
+ * replaces the part file, and its validator is saved so an interrupted download can be resumed.
+ * @return False if the part file can't be written.
+ */
+bool StartBody(Transfer *transfer) {
+  long response_code = 0;  // NOLINT(runtime/int) curl API type
+  curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &response_code);
+  if (response_code == 206) {
+    return true;
+  }
+  if (fflush(transfer->file) != 0 || ftruncate(fileno(transfer->file), 0) != 0) {
+    return false;
+  }
+  const std::string validator = Validator(*transfer);
+  if (validator.empty()) {
+    remove(transfer->validator_file_name.c_str());
+    return true;
+  }
+  std::ofstream validator_file(transfer->validator_file_name, std::ios::trunc);
+  validator_file << validator;
+  return static_cast<bool>(validator_file.flush());
+}
+
+size_t WriteBody(char *data, size_t size, size_t count, void *user_data) {
+  Transfer *transfer = static_cast<Transfer *>(user_data);
+  if (!transfer->body_started) {
+    transfer->body_started = true;
+    if (!StartBody(transfer)) {
+      return 0;
+    }
+  }
+  return fwrite(data, 1, size * count, transfer->file);
+}
+
+/**
+ * @return The validator saved in |validator_file_name|, empty if there is none.
+ */
+std::string ReadValidator(const std::string & validator_file_name) {
+  std::ifstream validator_file(validator_file_name);
+  std::string validator;
+  std::getline(validator_file, validator);
+  return validator;
+}
+
+}  // namespace
+
+void UrlDownloader::Downloader(const std::string & url) {
+  try {
+    Download(url, "data.grb");
+    std::cout << "Downloaded data.grb" << std::endl;
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << std::endl;
+  }
+}
+
+bool UrlDownloader::Download(const std::string & url, const std::string & file_name, std::time_t if_modified_since) {
+  const std::string part_file_name = file_name + ".part";
+  const std::string validator_file_name = part_file_name + ".validator";
+
+  // A partial file that can't be resumed (complete already) is restarted once
+  for (int attempt = 0; attempt < 2; attempt++) {
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+      throw std::runtime_error("Unable to initialize curl");
+    }
+
+    // Without a validator there's no telling whether the server still has the same file, so start over
+    curl_off_t resume_from = FileSize(part_file_name);
+    const std::string validator = ReadValidator(validator_file_name);
+    if (resume_from > 0 && validator.empty()) {
+      remove(part_file_name.c_str());
+      resume_from = 0;
+    }
+    FILE *file = fopen(part_file_name.c_str(), "ab");
+    if (file == nullptr) {
+      curl_easy_cleanup(curl);
+      throw std::runtime_error("Unable to open " + part_file_name);
+    }
+    Transfer transfer = {curl, file, validator_file_name, false, "", ""};
 
-  curl = curl_easy_init();
-  if (curl) {
-    char out_file_name[FILENAME_MAX] = "data.grb";
-    FILE *fp;
-    fp = fopen(out_file_name, "wb");
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, NULL);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-    res = curl_easy_perform(curl);
-    if (res != CURLE_OK)
-      fprintf(stderr, "curl_easy_perform() failed: %s\n",
-              curl_easy_strerror(res));
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &ReadHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &WriteBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+
+    // The range is only sent if the resource is unchanged (If-Range), otherwise the whole new file comes back
+    curl_slist *headers = nullptr;
+    const std::string range = std::to_string(resume_from) + "-";
+    if (resume_from > 0) {
+      headers = curl_slist_append(headers, ("If-Range: " + validator).c_str());
+      curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+      curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+    if (if_modified_since != 0) {
+      curl_easy_setopt(curl, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_IFMODSINCE));  // NOLINT
+      curl_easy_setopt(curl, CURLOPT_TIMEVALUE, static_cast<long>(if_modified_since));  // NOLINT
+    }
+
+    const CURLcode res = curl_easy_perform(curl);
+    long response_code = 0;  // NOLINT(runtime/int) curl API type
+    long condition_unmet = 0;  // NOLINT(runtime/int) curl API type
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &condition_unmet);
+    // An empty new file has no body to start
+    const bool started = res != CURLE_OK || condition_unmet || transfer.body_started || StartBody(&transfer);
     curl_easy_cleanup(curl);
-    fclose(fp);
-    std::cout << "Downloaded data.grb" << std::endl;
+    curl_slist_free_all(headers);
+    const bool closed = fclose(file) == 0;
+
+    const bool unresumable = res == CURLE_HTTP_RETURNED_ERROR && response_code == 416;
+    if (unresumable && resume_from > 0 && attempt == 0) {
+      remove(part_file_name.c_str());
+      remove(validator_file_name.c_str());
+      continue;
+    }
+    if (res != CURLE_OK) {
+      if (res == CURLE_HTTP_RETURNED_ERROR) {
+        remove(part_file_name.c_str());
+        remove(validator_file_name.c_str());
+      }
+      throw std::runtime_error("Downloading " + url + " failed: " + curl_easy_strerror(res));
+    }
+    if (!closed || !started) {
+      throw std::runtime_error("Unable to write " + part_file_name);
+    }
+    remove(validator_file_name.c_str());
+    if (condition_unmet) {
+      remove(part_file_name.c_str());
+      return false;
+    }
+    if (rename(part_file_name.c_str(), file_name.c_str()) != 0) {
+      throw std::runtime_error("Unable to rename " + part_file_name + " to " + file_name);
+    }
+    return true;
   }
+  throw std::runtime_error("Downloading " + url + " failed: the partial download can't be resumed");
 }
 
+std::string UrlDownloader::CachedDownload(const std::string & url, const std::string & region_key, std::time_t now,
+                                          const std::string & cache_directory) {
+  const std::string file_name = cache_directory + "/" + region_key + "-" + ForecastCycle(now) + ".grb";
+  struct stat file_stat;
+  if (stat(file_name.c_str(), &file_stat) == 0) {
+    return file_name;
+  }
+
+  mkdir(cache_directory.c_str(), 0755);
+
+  // Forecasts are often published late, the previous cycle's file is reused if the server has nothing newer
+  const std::string previous_file_name = cache_directory + "/" + region_key + "-" +
+      ForecastCycle(now - kForecastCycleHours * 3600) + ".grb";
+  if (stat(previous_file_name.c_str(), &file_stat) == 0) {
+    if (!Download(url, file_name, file_stat.st_mtime)) {
+      if (rename(previous_file_name.c_str(), file_name.c_str()) != 0) {
+        throw std::runtime_error("Unable to rename " + previous_file_name + " to " + file_name);
+      }
+      std::cout << "Reusing unmodified " << previous_file_name << std::endl;
+    } else {
+      remove(previous_file_name.c_str());
+      std::cout << "Downloaded " << file_name << std::endl;
+    }
+    return file_name;
+  }
+
+  Download(url, file_name);
+  std::cout << "Downloaded " << file_name << std::endl;
+  return file_name;
+}
+
+std::string UrlDownloader::ForecastCycle(std::time_t time) {
+  std::time_t cycle_start = time - time % (kForecastCycleHours * 3600);
+  std::tm utc;
+  gmtime_r(&cycle_start, &utc);
+  char cycle[16];
+  strftime(cycle, sizeof(cycle), "%Y%m%d%H", &utc);
+  return cycle;
+}
@@ -2,11 +2,50 @@
 #ifndef GRIB_URLDOWNLOADER_H_
 #define GRIB_URLDOWNLOADER_H_
 
+#include <ctime>
 #include <string>
 
 class UrlDownloader {
  public:
+  /// The directory forecasts are cached in by default.
+  static constexpr const char *kDefaultCacheDirectory = "grib_cache";
+  /// The hours between forecast cycles (model runs).
+  static constexpr int kForecastCycleHours = 6;
+
+  /**
+   * Downloads |url| to data.grb, printing errors instead of throwing.
+   */
   static void Downloader(const std::string & url);
+
+  /**
+   * Downloads |url| to |file_name|. The body is written to |file_name|.part, and atomically renamed to |file_name|
+   * once complete. The resource's ETag or Last-Modified is kept in |file_name|.part.validator, so an interrupted
+   * download is resumed with a range request only if the resource is unchanged (If-Range), and restarted otherwise.
+   * @param if_modified_since If not 0, only download if the resource changed after this time.
+   * @throw std::runtime_error The download failed. The partial file is kept for resuming, unless the server refused
+   *    the request.
+   * @return False if the resource wasn't modified since |if_modified_since| (nothing is written).
+   */
+  static bool Download(const std::string & url, const std::string & file_name, std::time_t if_modified_since = 0);
+
+  /**
+   * Downloads the forecast at |url| into the cache, unless it's already cached for the current forecast cycle.
+   * Files are keyed by |region_key| (e.g. the bounding box) and the forecast cycle, so repeated runs in a cycle don't
+   * use the network. The first run in a new cycle only re-fetches if the previous cycle's file is outdated.
+   * @param region_key Identifies the requested region, must be usable in a file name.
+   * @param now The current time.
+   * @param cache_directory The cache directory, created if needed.
+   * @throw std::runtime_error The download failed.
+   * @return The path of the cached file.
+   */
+  static std::string CachedDownload(const std::string & url, const std::string & region_key, std::time_t now,
+                                    const std::string & cache_directory = kDefaultCacheDirectory);
+
+  /**
+   * @param time A time.
+   * @return The forecast cycle |time| belongs to, as UTC YYYYMMDDHH.
+   */
+  static std::string ForecastCycle(std::time_t time);
 };
 
 #endif  // GRIB_URLDOWNLOADER_H_
@@ -0,0 +1,71 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef GRIB_WEATHERSNAPSHOTFORMAT_H_
+#define GRIB_WEATHERSNAPSHOTFORMAT_H_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Layout of the binary weather snapshot, a cache of decoded weather that replaces the csv round trip.
+ *
+ * The file is a Header followed by flat, 8-byte aligned arrays stored in native (little-endian) byte order, located
+ * through their offsets (in bytes from the start of the file) so that a memory-mapped file can be used directly.
+ * The grid has one point per integer degree over [south, north] x [west, east], in rows of increasing latitude and
+ * columns of increasing longitude. Channel values are stored time-major: all grid points of time step 0, then all of
+ * time step 1, ...
+ */
+namespace weather_snapshot_format {
+
+/// Identifies a weather snapshot file.
+constexpr char kMagic[8] = {'W', 'T', 'H', 'R', 'S', 'N', 'A', 'P'};
+
+/// Bumped whenever the layout changes.
+constexpr uint32_t kVersion = 1;
+
+/// Alignment of each array in the file.
+constexpr uint64_t kAlignment = 8;
+
+/// The number of channels: wind speed, wind direction, current speed, current direction and wave height, in
+/// WeatherHexMap::Channel order.
+constexpr uint32_t kChannelCount = 5;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t channel_count;
+  /// The grid bounds in integer degrees, longitudes in [0, 360).
+  int32_t north;
+  int32_t south;
+  int32_t east;
+  int32_t west;
+  uint64_t grid_point_count;
+  uint32_t time_step_count;
+  uint32_t reserved;
+  /// int64_t[time_step_count], the forecast step of each time step (hours for GRIB sources, the index for csvs), -1
+  /// for time steps missing from the source.
+  uint64_t steps_offset;
+  /// float[time_step_count * grid_point_count] per channel, 0 for channels that aren't stored.
+  uint64_t channel_offsets[kChannelCount];
+};
+
+/**
+ * @param offset Byte offset.
+ * @return |offset| rounded up to kAlignment.
+ */
+inline uint64_t Align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/**
+ * @param header Header read from the start of a file.
+ * @return Whether the header identifies a weather snapshot of the current version.
+ */
+inline bool IsValidHeader(const Header &header) {
+  return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+      header.channel_count == kChannelCount;
+}
+
+}  // namespace weather_snapshot_format
+
+#endif  // GRIB_WEATHERSNAPSHOTFORMAT_H_
@@ -0,0 +1,22 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef GRIB_WINDKMLOPTIONS_H_
+#define GRIB_WINDKMLOPTIONS_H_
+
+/**
+ * Options of the wind overlay KML written by gribParse::saveKML.
+ * The overlay has one arrow per grid point, so large forecast regions are decimated with |stride| and
+ * |min_wind_speed|.
+ */
+struct WindKmlOptions {
+  /// Whether to write the overlay at all.
+  bool enabled = false;
+  /// Write to a timestamped file in resultKMLs/ instead of Wind.kml.
+  bool preserve = false;
+  /// Only write every |stride|th grid point along each row and column.
+  int stride = 1;
+  /// Only write grid points with at least this wind speed, in knots.
+  double min_wind_speed = 0;
+};
+
+#endif  // GRIB_WINDKMLOPTIONS_H_
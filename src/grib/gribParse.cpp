@@ -7,8 +7,17 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <ctime>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include "common/ParallelFor.h"
+#include "grib/WeatherSnapshotFormat.h"
 
 /**
  * Translates GRIB file into array of lattitudes, longitudes, and corresponding values
@@ -17,7 +26,7 @@
  */
 
 gribParse::gribParse(const std::string & filename, int time_steps, bool use_csvs,
-                     const std::string & output_csvs_folder) {
+                     const std::string & output_csvs_folder, unsigned parameters) : number_of_points_(0) {
   if (use_csvs) {
     // Read saved csv files to get weather information
     // Need to reverse columns because lats ordering issue described below
@@ -39,6 +48,9 @@ gribParse::gribParse(const std::string & filename, int time_steps, bool use_csvs
       std::vector<double> angles_at_time = convert2Dto1D(reverseColumns(readCsv(angle_filename)));
       angles[i] = angles_at_time;
     }
+    for (int i = 0; i < time_steps; i++) {
+      steps.push_back(i);
+    }
     for (int i = 0; i < time_steps; i++) {
       std::string magnitude_filename = input_csvs_directory + "/magnitudes2d-" + std::to_string(i) + ".csv";
       std::vector<double> magnitudes_at_time = convert2Dto1D(reverseColumns(readCsv(magnitude_filename)));
@@ -54,86 +66,11 @@ gribParse::gribParse(const std::string & filename, int time_steps, bool use_csvs
     // Parse grb file
     std::vector<std::vector<double>> u_values;
     std::vector<std::vector<double>> v_values;
-    err = 0;
-    for (int code_handle_iteration = 1;
-          ((lib_handle = codes_handle_new_from_file(0, in, PRODUCT_GRIB, &err)) != NULL) && code_handle_iteration <= 32;
-          code_handle_iteration++) {
-        CODES_CHECK(err, 0);
-        CODES_CHECK(codes_get_long(lib_handle, "numberOfPoints", &number_of_points_), 0);
-        CODES_CHECK(codes_set_double(lib_handle, "missingValue", kMissing), 0);
-        lats.resize(number_of_points_);
-        lons.resize(number_of_points_);
-
-
-        switch (code_handle_iteration) {
-            case 1:
-                cape.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), cape.data()), 0);
-                break;
-            case 2:
-                wind_gust.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), wind_gust.data()), 0);
-                break;
-            case 3:
-                precipitation.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), precipitation.data()), 0);
-                break;
-            case 4:
-                pressure.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), pressure.data()), 0);
-                break;
-            case 5:
-                cloudcover.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), cloudcover.data()), 0);
-                break;
-            case 6:
-                temperature.resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), temperature.data()), 0);
-                break;
-            case 7:
-                u_values.resize(time_steps);
-                u_values[0].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), u_values[0].data()), 0);
-                break;
-            case 8:
-                v_values.resize(time_steps);
-                v_values[0].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), v_values[0].data()), 0);
-                break;
-            case 15:
-                u_values.resize(time_steps);
-                u_values[1].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), u_values[1].data()), 0);
-                break;
-            case 16:
-                v_values.resize(time_steps);
-                v_values[1].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), v_values[1].data()), 0);
-                break;
-            case 23:
-                u_values.resize(time_steps);
-                u_values[2].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), u_values[2].data()), 0);
-                break;
-            case 24:
-                v_values.resize(time_steps);
-                v_values[2].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), v_values[2].data()), 0);
-                break;
-            case 31:
-                u_values.resize(time_steps);
-                u_values[3].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), u_values[3].data()), 0);
-                break;
-            case 32:
-                v_values.resize(time_steps);
-                v_values[3].resize(number_of_points_);
-                CODES_CHECK(codes_grib_get_data(lib_handle, lats.data(), lons.data(), v_values[3].data()), 0);
-                break;
-            default:
-                break;
-        }
-        codes_handle_delete(lib_handle);
+    if (in) {
+      decodeGrib(time_steps, parameters, &u_values, &v_values);
+    }
+    if (static_cast<int>(u_values.size()) < time_steps) {
+      std::cout << "Warning: " << filename << " has fewer than " << time_steps << " wind forecast steps" << std::endl;
     }
 
     // Setup storing vectors
@@ -143,29 +80,28 @@ gribParse::gribParse(const std::string & filename, int time_steps, bool use_csvs
     u_values.resize(time_steps);
     v_values.resize(time_steps);
 
-  //  CODES_CHECK(codes_set_double(lib_handle, "missingValue", kMissing), 0);
+    // Normalize the grid coordinates once, they're shared by all time steps
+    for (int j = 0; j < number_of_points_; j++) {
+      lats[j] = standard_calc::BoundTo180(lats[j]);
+      lons[j] = standard_calc::BoundTo180(lons[j]);
+    }
 
-    // adjust latitude and longitude, and generate resultant angles and magnitudes
+    // Generate resultant angles and magnitudes
     for (int i = 0; i < time_steps; i++) {
       angles[i].resize(number_of_points_);
       magnitudes[i].resize(number_of_points_);
       missing[i].resize(number_of_points_);
       u_values[i].resize(number_of_points_);
       v_values[i].resize(number_of_points_);
+      convertWind(u_values[i].data(), v_values[i].data(), number_of_points_, magnitudes[i].data(), angles[i].data());
       for (int j = 0; j < number_of_points_; j++) {
-        if (u_values[i][j] == kMissing)
-          missing[i][j] = true;
-        else
-          missing[i][j] = false;
-
-        angles[i][j] = calcAngle(u_values[i][j], v_values[i][j]);
-        magnitudes[i][j] = calcMagnitude(u_values[i][j], v_values[i][j]);
-        lats[j] = standard_calc::BoundTo180(lats[j]);
-        lons[j] = standard_calc::BoundTo180(lons[j]);
+        missing[i][j] = u_values[i][j] == kMissing;
       }
     }
 
-    fclose(in);
+    if (in) {
+      fclose(in);
+    }
   }
 
   // Write to output directory
@@ -202,6 +138,165 @@ gribParse::gribParse(const std::string & filename, int time_steps, bool use_csvs
   }
 }
 
+unsigned gribParse::parameterOf(const std::string & short_name) {
+  // Providers name some quantities differently, accept all of them. The level-generic names ("u", "v", "t") are left
+  // out: a file with several levels would decode all of them into the same step.
+  static const std::map<std::string, unsigned> kParameters = {
+      {"10u", kWind}, {"10v", kWind},
+      {"cape", kCape},
+      {"gust", kWindGust}, {"i10fg", kWindGust},
+      {"tp", kPrecipitation}, {"prate", kPrecipitation},
+      {"prmsl", kPressure}, {"msl", kPressure},
+      {"tcc", kCloudCover},
+      {"2t", kTemperature}};
+
+  auto parameter = kParameters.find(short_name);
+  return parameter == kParameters.end() ? 0 : parameter->second;
+}
+
+int64_t gribParse::stepOf(const std::string & step_range) {
+  const std::size_t dash = step_range.find('-');
+  return std::stoll(dash == std::string::npos ? step_range : step_range.substr(dash + 1));
+}
+
+namespace {
+
+/// Owns an ecCodes handle.
+using Handle = std::unique_ptr<codes_handle, int (*)(codes_handle *)>;
+
+Handle MakeHandle(codes_handle *handle) {
+  return Handle(handle, &codes_handle_delete);
+}
+
+}  // namespace
+
+void gribParse::decodeGrib(int time_steps, unsigned parameters, std::vector<std::vector<double>> *u_values,
+                           std::vector<std::vector<double>> *v_values) {
+  // Index the messages to decode, reading only their keys. Wind components are kept by step until the earliest
+  // time_steps steps with both components are known, other parameters only at their earliest step.
+  std::map<int64_t, std::pair<Handle, Handle>> wind_messages;
+  std::set<int64_t> paired_steps;
+  std::map<unsigned, std::pair<int64_t, Handle>> parameter_messages;
+
+  err = 0;
+  while ((lib_handle = codes_handle_new_from_file(0, in, PRODUCT_GRIB, &err)) != NULL) {
+    Handle handle = MakeHandle(lib_handle);
+    CODES_CHECK(err, 0);
+
+    char short_name[64];
+    char step_range[64];
+    size_t short_name_length = sizeof(short_name);
+    size_t step_range_length = sizeof(step_range);
+    CODES_CHECK(codes_get_string(handle.get(), "shortName", short_name, &short_name_length), 0);
+    CODES_CHECK(codes_get_string(handle.get(), "stepRange", step_range, &step_range_length), 0);
+    const std::string name(short_name);
+    const unsigned parameter = parameterOf(name);
+    const int64_t step = stepOf(step_range);
+
+    // Messages of parameters that weren't requested are dropped without decoding their data.
+    if ((parameter & parameters) == 0) {
+      continue;
+    }
+
+    if (parameter == kWind) {
+      // Once time_steps steps are paired, later steps can't be kept whether or not they get both components.
+      if (time_steps <= 0 ||
+          (static_cast<int>(paired_steps.size()) >= time_steps && step > *paired_steps.rbegin())) {
+        continue;
+      }
+      auto indexed = wind_messages.find(step);
+      if (indexed == wind_messages.end()) {
+        indexed = wind_messages.emplace(step, std::make_pair(MakeHandle(nullptr), MakeHandle(nullptr))).first;
+      }
+      std::pair<Handle, Handle> &components = indexed->second;
+      (name.back() == 'u' ? components.first : components.second) = std::move(handle);
+
+      // Only evict a paired step, for an earlier one that was just paired.
+      if (components.first && components.second && paired_steps.insert(step).second &&
+          static_cast<int>(paired_steps.size()) > time_steps) {
+        const int64_t latest_step = *paired_steps.rbegin();
+        paired_steps.erase(latest_step);
+        wind_messages.erase(latest_step);
+      }
+    } else {
+      auto indexed = parameter_messages.find(parameter);
+      if (indexed == parameter_messages.end()) {
+        parameter_messages.emplace(parameter, std::make_pair(step, std::move(handle)));
+      } else if (step < indexed->second.first) {
+        indexed->second = std::make_pair(step, std::move(handle));
+      }
+    }
+  }
+
+  // Pair each message with the buffer it's decoded into. Steps missing a wind component are dropped.
+  std::vector<std::pair<codes_handle *, std::vector<double> *>> messages;
+  u_values->resize(paired_steps.size());
+  v_values->resize(paired_steps.size());
+  size_t wind_step = 0;
+  for (int64_t step : paired_steps) {
+    const std::pair<Handle, Handle> &components = wind_messages.at(step);
+    messages.emplace_back(components.first.get(), &(*u_values)[wind_step]);
+    messages.emplace_back(components.second.get(), &(*v_values)[wind_step]);
+    steps.push_back(step);
+    wind_step++;
+  }
+  for (const auto &parameter_message : parameter_messages) {
+    std::vector<double> *values = nullptr;
+    switch (parameter_message.first) {
+      case kCape:
+        values = &cape;
+        break;
+      case kWindGust:
+        values = &wind_gust;
+        break;
+      case kPrecipitation:
+        values = &precipitation;
+        break;
+      case kPressure:
+        values = &pressure;
+        break;
+      case kCloudCover:
+        values = &cloudcover;
+        break;
+      case kTemperature:
+        values = &temperature;
+        break;
+      default:
+        continue;
+    }
+    messages.emplace_back(parameter_message.second.second.get(), values);
+  }
+  if (messages.empty()) {
+    return;
+  }
+
+  // All messages share the grid, so the coordinates are only decoded once, with the first message.
+  CODES_CHECK(codes_get_long(messages[0].first, "numberOfPoints", &number_of_points_), 0);
+  lats.resize(number_of_points_);
+  lons.resize(number_of_points_);
+  for (const auto &message : messages) {
+    message.second->resize(number_of_points_);
+  }
+  CODES_CHECK(codes_set_double(messages[0].first, "missingValue", kMissing), 0);
+  CODES_CHECK(codes_grib_get_data(messages[0].first, lats.data(), lons.data(), messages[0].second->data()), 0);
+
+  // The remaining messages are independent, decode them in parallel into their preallocated buffers.
+  parallel::ForDynamic(messages.size() - 1, 0, [&](size_t i) {
+    decodeValues(messages[i + 1].first, messages[i + 1].second);
+  });
+}
+
+void gribParse::decodeValues(codes_handle *handle, std::vector<double> *values) const {
+  int64_t message_points = 0;
+  CODES_CHECK(codes_get_long(handle, "numberOfPoints", &message_points), 0);
+  if (message_points != number_of_points_) {
+    throw std::runtime_error("GRIB messages have different grids");
+  }
+  CODES_CHECK(codes_set_double(handle, "missingValue", kMissing), 0);
+  size_t size = values->size();
+  CODES_CHECK(codes_get_double_array(handle, "values", values->data(), &size), 0);
+}
+
 /**
  * Calculates angle, relative to an origin at the 12 o'clock position
  * @param u and v vector component of the wind
@@ -217,61 +312,133 @@ double gribParse::calcAngle(double u_comp, double v_comp) {
  * @return magnitude of vector in knots/s
  */
 double gribParse::calcMagnitude(double u_comp, double v_comp) {
-    return (sqrt(pow(u_comp, 2) + pow(v_comp, 2)))/0.514444;
+    return (sqrt(u_comp * u_comp + v_comp * v_comp))/0.514444;
 }
 
-void gribParse::saveKML(bool preserveKml) {
-    std::ofstream ss;
+namespace {
 
-    if (preserveKml) {
+/**
+ * atan(x) to within an ulp, using Cephes' rational approximation with selects instead of branches and no library
+ * calls, so that loops over it vectorize (std::atan can't without a vector math library).
+ * Infinities map to +-pi/2 and NaN stays NaN, as with std::atan.
+ */
+inline double atanWithoutBranches(double x) {
+    // Reduce |x| to [0, 0.66] using atan(a) = pi/2 + atan(-1/a) = pi/4 + atan((a-1)/(a+1)). Both quotients are
+    // computed for every x so that picking one is a select.
+    const double a = std::fabs(x);
+    const double inverse = -1.0 / a;
+    const double shifted = (a - 1.0) / (a + 1.0);
+    const bool large = a > 2.41421356237309504880;  // tan(3pi/8)
+    const bool medium = a > 0.66;
+    const double r = large ? inverse : medium ? shifted : a;
+    const double more_bits = 6.123233995736765886130e-17;  // pi/2 - double(pi/2)
+    const double offset = large ? 1.57079632679489661923 + more_bits
+                        : medium ? 0.78539816339744830962 + 0.5 * more_bits : 0.0;
+
+    const double z = r * r;
+    const double p = (((-8.750608600031904122785e-1 * z - 1.615753718733365076637e1) * z
+                       - 7.500855792314704667340e1) * z - 1.228866684490136173410e2) * z - 6.485021904942025371773e1;
+    const double q = ((((z + 2.485846490142306297962e1) * z + 1.650270098316988542046e2) * z
+                       + 4.328810604912902668951e2) * z + 4.853903996359136964868e2) * z + 1.945506571482613964425e2;
+    return std::copysign(offset + (r * z * p / q + r), x);
+}
+
+}  // namespace
+
+void gribParse::convertWind(const double *u_comp, const double *v_comp, size_t count,
+                            double *magnitudes, double *angles) {
+    // Separate branch free loops over contiguous arrays, so each one can be vectorized.
+    for (size_t i = 0; i < count; i++) {
+        magnitudes[i] = calcMagnitude(u_comp[i], v_comp[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        angles[i] = 270 - (atanWithoutBranches(v_comp[i] / u_comp[i]) * 180 / PI);
+    }
+}
+
+void gribParse::saveKML(const WindKmlOptions & options) const {
+    std::string fileName = "Wind.kml";
+    if (options.preserve) {
       std::time_t currentTime = std::time(0);
       std::string kmlName = std::ctime(&currentTime);
-      std::string fileName = "resultKMLs/" + kmlName.substr(0, kmlName.length()-9) + "-Wind.kml";
-      ss.open(fileName);
-    } else {
-      ss.open("Wind.kml");
+      fileName = "resultKMLs/" + kmlName.substr(0, kmlName.length()-9) + "-Wind.kml";
     }
+    saveKML(options, fileName);
+}
+
+void gribParse::saveKML(const WindKmlOptions & options, const std::string & fileName) const {
+    if (lats.empty() || magnitudes.empty()) {
+      return;
+    }
+
+    // Stream the overlays through a large buffer, flushed only when full
+    static constexpr size_t kBufferSize = 1 << 20;
+    std::unique_ptr<char[]> buffer(new char[kBufferSize]);
+    std::ofstream ss;
+    ss.rdbuf()->pubsetbuf(buffer.get(), kBufferSize);
+    ss.open(fileName);
 
     ss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
           "<kml xmlns=\"http://earth.google.com/kml/2.0\">\n"
           "<Document><name>Wind</name><Folder>\n";
-    std::string color;
-    std::string yellowArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/6/66/"
-                              "Arrow-180%28ff0%29.svg/200px-Arrow-180%28ff0%29.svg.png</href>";
-    std::string redArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/c/ce/"
-                           "Arrow-180%28f00%29.svg/200px-Arrow-180%28f00%29.svg.png</href>";
-    std::string greenArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/5/5b/"
-                             "Arrow-180%28080%29.svg/200px-Arrow-180%28080%29.svg.png</href>";
-    std::string orangeArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/0/03/"
-                              "Arrow-180%28f80%29.svg/200px-Arrow-180%28f80%29.svg.png</href>";
-    std::string whiteArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/f/f8/"
-                             "Arrow-180%28fff%29.svg/200px-Arrow-180%28fff%29.svg.png</href>";
-
-    for (size_t i = 0; i < angles[0].size(); i++) {
-      double dist = sqrt(pow(lats[i]-lats[angles[0].size()-1], 2) + pow(lons[i]-lons[angles[0].size()-1], 2));
+    static const char *const kYellowArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/6/66/"
+                                            "Arrow-180%28ff0%29.svg/200px-Arrow-180%28ff0%29.svg.png</href>";
+    static const char *const kRedArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/c/ce/"
+                                         "Arrow-180%28f00%29.svg/200px-Arrow-180%28f00%29.svg.png</href>";
+    static const char *const kGreenArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/5/5b/"
+                                           "Arrow-180%28080%29.svg/200px-Arrow-180%28080%29.svg.png</href>";
+    static const char *const kOrangeArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/0/03/"
+                                            "Arrow-180%28f80%29.svg/200px-Arrow-180%28f80%29.svg.png</href>";
+    static const char *const kWhiteArrow = "<href>https://upload.wikimedia.org/wikipedia/commons/thumb/f/f8/"
+                                           "Arrow-180%28fff%29.svg/200px-Arrow-180%28fff%29.svg.png</href>";
+
+    // Grid points are in rows of increasing latitude, decimate along both rows and columns. The columns are counted
+    // along the first row, as longitudes wrap around in regions across the antimeridian.
+    const size_t point_count = angles[0].size();
+    const size_t stride = static_cast<size_t>(std::max(options.stride, 1));
+    size_t column_count = 1;
+    while (column_count < point_count && lats[column_count] == lats[0]) {
+      column_count++;
+    }
+    const int last_time_step = static_cast<int>(magnitudes.size()) - 1;
+
+    for (size_t i = 0; i < point_count; i++) {
+      if ((i / column_count) % stride != 0 || (i % column_count) % stride != 0) {
+        continue;
+      }
+
+      // Show the forecast further in time the further the point is from the last grid point (compared squared)
+      const double lat_delta = lats[i] - lats[point_count - 1];
+      const double lon_delta = standard_calc::BoundTo180(lons[i] - lons[point_count - 1]);
+      const double squared_dist = lat_delta * lat_delta + lon_delta * lon_delta;
       int time_step;
-      if (dist < 2) {
+      if (squared_dist < 2 * 2) {
         time_step = 0;
-      } else if (dist < 4) {
+      } else if (squared_dist < 4 * 4) {
         time_step = 1;
-      } else if (dist < 6) {
+      } else if (squared_dist < 6 * 6) {
         time_step = 2;
       } else {
         time_step = 3;
       }
+      time_step = std::min(time_step, last_time_step);
 
-      int wind_speed = magnitudes[time_step][i];
+      if (magnitudes[time_step][i] < options.min_wind_speed) {
+        continue;
+      }
 
+      int wind_speed = magnitudes[time_step][i];
+      const char *color;
       if (wind_speed < 6) {
-        color = whiteArrow;
+        color = kWhiteArrow;
       } else if (wind_speed < 11) {
-        color = yellowArrow;
+        color = kYellowArrow;
       } else if (wind_speed < 16) {
-        color = greenArrow;
+        color = kGreenArrow;
       } else if (wind_speed < 21) {
-        color = orangeArrow;
+        color = kOrangeArrow;
       } else {
-        color = redArrow;
+        color = kRedArrow;
       }
 
       // See https://www.desmos.com/calculator/q8j19sq6ay
@@ -293,14 +460,90 @@ void gribParse::saveKML(bool preserveKml) {
             "<west>" << lons[i] - windAdjusted << "</west>"
             "<rotation>" << 360-angles[time_step][i] << "</rotation>"
             "</LatLonBox>"
-            "</GroundOverlay>" << std::endl;
+            "</GroundOverlay>\n";
     }
     ss << "</Folder>\n</Document>\n</kml>" << std::endl;
 
     ss.close();
 }
 
-double gribParse::windSigmoid(double windMagnitude) {
+void gribParse::saveSnapshot(const std::string & filename) const {
+  using weather_snapshot_format::Align;
+
+  // Snapshots use the WeatherHexMap convention of longitudes in [0, 360)
+  std::vector<double> positive_lons(lons.size());
+  for (size_t i = 0; i < lons.size(); i++) {
+    positive_lons[i] = lons[i] < 0 ? lons[i] + 360 : lons[i];
+  }
+
+  weather_snapshot_format::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, weather_snapshot_format::kMagic, sizeof(header.magic));
+  header.version = weather_snapshot_format::kVersion;
+  header.channel_count = weather_snapshot_format::kChannelCount;
+  if (!lats.empty()) {
+    header.north = static_cast<int32_t>(round(*std::max_element(lats.begin(), lats.end())));
+    header.south = static_cast<int32_t>(round(*std::min_element(lats.begin(), lats.end())));
+    header.east = static_cast<int32_t>(round(*std::max_element(positive_lons.begin(), positive_lons.end())));
+    header.west = static_cast<int32_t>(round(*std::min_element(positive_lons.begin(), positive_lons.end())));
+  }
+  header.grid_point_count = lats.size();
+  header.time_step_count = static_cast<uint32_t>(magnitudes.size());
+  if (!lats.empty() && static_cast<uint64_t>(header.north - header.south + 1) *
+      static_cast<uint64_t>(header.east - header.west + 1) != header.grid_point_count) {
+    throw std::runtime_error("Weather grid of " + filename + " isn't a one degree grid");
+  }
+
+  // Only the wind is known
+  std::vector<int64_t> snapshot_steps(header.time_step_count, -1);
+  std::copy(steps.begin(), steps.begin() + std::min(steps.size(), snapshot_steps.size()), snapshot_steps.begin());
+  std::vector<float> wind_speeds, wind_directions;
+  wind_speeds.reserve(header.time_step_count * header.grid_point_count);
+  wind_directions.reserve(header.time_step_count * header.grid_point_count);
+  for (uint32_t i = 0; i < header.time_step_count; i++) {
+    wind_speeds.insert(wind_speeds.end(), magnitudes[i].begin(), magnitudes[i].end());
+    wind_directions.insert(wind_directions.end(), angles[i].begin(), angles[i].end());
+  }
+
+  uint64_t offset = Align(sizeof(header));
+  auto place = [&offset](uint64_t bytes) {
+    uint64_t placed = offset;
+    offset = Align(offset + bytes);
+    return placed;
+  };
+  header.steps_offset = place(snapshot_steps.size() * sizeof(int64_t));
+  constexpr size_t kWindSpeedChannel = 0, kWindDirectionChannel = 1;
+  header.channel_offsets[kWindSpeedChannel] = place(wind_speeds.size() * sizeof(float));
+  header.channel_offsets[kWindDirectionChannel] = place(wind_directions.size() * sizeof(float));
+
+  std::ofstream os(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os) {
+    throw std::runtime_error("Unable to open " + filename + " for writing");
+  }
+
+  // Write the header and each array, padding up to the next offset
+  uint64_t written = 0;
+  auto write_at = [&os, &written](uint64_t at, const void *data, uint64_t bytes) {
+    static const char kPadding[weather_snapshot_format::kAlignment] = {0};
+    while (written < at) {
+      uint64_t padding = std::min<uint64_t>(at - written, sizeof(kPadding));
+      os.write(kPadding, padding);
+      written += padding;
+    }
+    os.write(static_cast<const char *>(data), bytes);
+    written += bytes;
+  };
+  write_at(0, &header, sizeof(header));
+  write_at(header.steps_offset, snapshot_steps.data(), snapshot_steps.size() * sizeof(int64_t));
+  write_at(header.channel_offsets[kWindSpeedChannel], wind_speeds.data(), wind_speeds.size() * sizeof(float));
+  write_at(header.channel_offsets[kWindDirectionChannel], wind_directions.data(),
+           wind_directions.size() * sizeof(float));
+  if (!os) {
+    throw std::runtime_error("Failed to write " + filename);
+  }
+}
+
+double gribParse::windSigmoid(double windMagnitude) const {
   double exponent = std::exp(-0.15*(windMagnitude-23));
 
   return 0.375 / (1 + exponent) + 0.1;
@@ -6,21 +6,84 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include "grib/WindKmlOptions.h"
 #include "logic/StandardCalc.h"
 
 #define PI 3.14159265
 
 class gribParse {
  public:
+        /**
+         * The GRIB parameters that can be decoded, combined as a bit mask.
+         */
+        enum Parameter : unsigned {
+            kWind = 1 << 0,
+            kCape = 1 << 1,
+            kWindGust = 1 << 2,
+            kPrecipitation = 1 << 3,
+            kPressure = 1 << 4,
+            kCloudCover = 1 << 5,
+            kTemperature = 1 << 6,
+            kAllParameters = (1 << 7) - 1
+        };
+
+        /**
+         * @param filename GRIB file, or csvs folder if use_csvs is set.
+         * @param time_steps The number of wind forecast steps to decode (the earliest ones in the file).
+         * @param parameters The Parameters to decode, messages of other parameters are skipped without decoding.
+         */
         explicit gribParse(const std::string & filename, int time_steps = 4, bool use_csvs = false,
-                           const std::string & output_csvs_folder = "");
+                           const std::string & output_csvs_folder = "", unsigned parameters = kWind);
         static double calcMagnitude(const double u_comp, const double v_comp);
         static double calcAngle(const double u_comp, const double v_comp);
-        void saveKML(bool preserveKml);
+
+        /**
+         * Converts |count| wind components to magnitudes and angles, as calcMagnitude and calcAngle do for each point.
+         * The angles use a vectorizable atan, so they can differ from calcAngle's in the last bits.
+         * @param u_comp The u components.
+         * @param v_comp The v components.
+         * @param magnitudes Filled with |count| magnitudes in knots.
+         * @param angles Filled with |count| angles in degrees.
+         */
+        static void convertWind(const double *u_comp, const double *v_comp, size_t count,
+                                double *magnitudes, double *angles);
+
+        /**
+         * @param short_name The GRIB shortName of a message, e.g. "10u".
+         * @return The Parameter the message belongs to, or 0 if it isn't one we decode. Names that don't identify a
+         *    single level, such as "u" on isobaric levels, are 0.
+         */
+        static unsigned parameterOf(const std::string & short_name);
+
+        /**
+         * @param step_range The GRIB stepRange of a message, either a single step ("6") or a range ("0-6").
+         * @return The forecast step the message is valid at, the end of the range.
+         */
+        static int64_t stepOf(const std::string & step_range);
+        /**
+         * Writes the wind overlay KML (Wind.kml, or a timestamped file in resultKMLs/), streamed through a buffer.
+         * |options|.enabled isn't checked, callers decide whether to write it.
+         */
+        void saveKML(const WindKmlOptions & options) const;
+
+        /**
+         * Writes the wind overlay KML to |fileName|, ignoring |options|.enabled and |options|.preserve.
+         */
+        void saveKML(const WindKmlOptions & options, const std::string & fileName) const;
+
+        /**
+         * Saves the wind as a binary weather snapshot (see WeatherSnapshotFormat.h), which WeatherHexMap memory-maps
+         * instead of parsing csvs or GRIB files.
+         * @param filename The snapshot file.
+         * @throw std::runtime_error The grid isn't a one degree grid or the file can't be written.
+         */
+        void saveSnapshot(const std::string & filename) const;
 
         int64_t number_of_points_;
         std::vector<double> lats;
         std::vector<double> lons;
+        /// The forecast step of each decoded wind time step, in hours for GRIB files and the index for csvs.
+        std::vector<int64_t> steps;
         std::vector<double> wind_gust;
         std::vector<double> cloudcover;
         std::vector<double> precipitation;
@@ -38,7 +101,25 @@ class gribParse {
         std::vector<double> convert2Dto1D(const std::vector<std::vector<double>> & array2D);
         std::vector<std::vector<double>> readCsv(const std::string & csvfilename);
         std::vector<std::vector<double>> reverseColumns(const std::vector<std::vector<double>> & array2D);
-        double windSigmoid(double windMagnitude);
+        double windSigmoid(double windMagnitude) const;
+
+        /**
+         * Decodes the requested parameters of every message in the open GRIB file |in|.
+         * Messages are identified by their shortName and stepRange keys, so their order doesn't matter. The file is
+         * first indexed by reading only these keys, then the selected messages are decoded in parallel.
+         * @param time_steps The number of wind forecast steps to keep, the earliest ones with both wind components.
+         * @param u_values Filled with the u wind component of each kept forecast step.
+         * @param v_values Filled with the v wind component of each kept forecast step.
+         */
+        void decodeGrib(int time_steps, unsigned parameters, std::vector<std::vector<double>> *u_values,
+                        std::vector<std::vector<double>> *v_values);
+
+        /**
+         * Decodes the values of a message into |values|, already sized to number_of_points_.
+         * Safe to call concurrently for different messages.
+         * @throw std::runtime_error The message isn't on the same grid as the first one.
+         */
+        void decodeValues(codes_handle *handle, std::vector<double> *values) const;
 
         int err;
         FILE *in;
@@ -3,18 +3,38 @@
 #ifndef PATHFINDING_ASTARPATHFINDER_H_
 #define PATHFINDING_ASTARPATHFINDER_H_
 
-#include <boost/unordered_map.hpp>
-#include <queue>
+#include <vector>
 
 #include "pathfinding/Pathfinder.h"
-#include "pathfinding/AStarVertex.h"
 
+/**
+ * @brief A* pathfinder for any Heuristic and CostCalculator.
+ *
+ * Runs AStarSearch with virtual heuristic and cost calculator calls. When their classes are known at compile time,
+ * using AStarSearch with those classes directly avoids the virtual calls in the expansion loop.
+ */
 class AStarPathfinder : public Pathfinder {
  public:
   /// The number of states for which to reserve the closed set for to avoid rehashing.
   static constexpr size_t kClosedSetReserveSize = 5000000;
   /// The minimum planet subdivision number for the closed set reservation to be active.
   static constexpr int kClosedSetReservePlanetSize = 9;
+  /// The largest state space (vertices * (time horizon + 1)) stored in a dense closed set rather than a hash map.
+  static constexpr size_t kMaxDenseClosedSetSize = size_t{1} << 31;
+  /// The number of expansions between checks of the wall clock and memory limits.
+  static constexpr size_t kLimitCheckInterval = 1024;
+
+  /**
+   * The priority queue used for the open set. All of them find a lowest cost path; paths of equal cost may differ.
+   */
+  enum class OpenSetType {
+    /// Binary heap (std::priority_queue) that pushes improved states again and skips the stale copies.
+    kBinaryHeap,
+    /// Indexed 4-ary heap with decrease-key, every state is queued at most once.
+    kIndexedHeap,
+    /// Radix heap exploiting the integer costs. Best suited to consistent heuristics.
+    kRadixHeap
+  };
 
   /**
    * Creates a Pathfinder instance. Each instance pertains to a specific pathfinding scenario.
@@ -27,54 +47,48 @@ class AStarPathfinder : public Pathfinder {
    * @param use_indirect_neighbours Whether to use indirect neighbours for pathfinding. Be aware that this will
    * change the output. Though it improves the output path and is recommended, it isn't always desired. It's off by
    * default to avoid unexpected behaviour.
+   * @param open_set_type The priority queue to use for the open set.
+   * @param limits Bounds on the search, unlimited by default.
    * @throw std::runtime_error If use_indirect_neighbours is true but cost_calculator doesn't support it.
    */
-  AStarPathfinder(HexPlanet &planet,
+  AStarPathfinder(const HexPlanet &planet,
                   const Heuristic &heuristic,
                   const CostCalculator &cost_calculator,
                   HexVertexId start,
                   HexVertexId target,
-                  bool use_indirect_neighbours = false);
+                  bool use_indirect_neighbours = false,
+                  OpenSetType open_set_type = OpenSetType::kBinaryHeap,
+                  const Limits &limits = Limits());
 
   /**
    * Find the path from start to target.
+   * If the cost calculator has a bounded time horizon, states are kept in a dense closed set in which all time steps
+   * from the horizon on are a single state. With a maximum time, the dense closed set instead has a state per time
+   * step up to it. Otherwise, or if the dense closed set would be too large, they are kept in a hash map.
+   * Note: with an unbounded time horizon and no limits, the search never ends if the target can't be reached.
    * @throw std::runtime_error Pathfinding error.
-   * @return The path from start_ to target_.
+   * @return The path from start_ to target_, or the best partial path if the target is unreachable within the limits.
    */
-  Result Run();
-
- private:
-  struct VisitedStateData {
-    /// The cost to this vertex (and time) from the start.
-    uint32_t cost;
-    /// The ancestor to this node.
-    AStarVertex::IdTimeIndex parent;
-  };
+  Result Run() override;
 
-  typedef std::priority_queue<AStarVertex, std::vector<AStarVertex>, std::greater<AStarVertex>> VertexQueue;
-  typedef boost::unordered_map<AStarVertex::IdTimeIndex, VisitedStateData> TimeIndexValueMap;
+  /**
+   * @param show_progress Whether Run() prints a progress bar to stdout (on by default). Turn it off when running
+   * several pathfinders at once.
+   */
+  void set_show_progress(bool show_progress) { show_progress_ = show_progress; }
 
+ private:
   /// Whether to use indirect neighbours for pathfinding.
   bool use_indirect_neighbours_;
 
-  /**
-   * If a neighbour state expansion provides a new lowest cost to the neighbour, add it to the open set and visited
-   * state data.
-   * @param open_set The open set.
-   * @param visited Visited state data.
-   * @param current_id_time_index IdTimeIndex of the "current" state.
-   * @param neighbour_id_time_index IdTimeIndex of the "neighbour" state.
-   * @param neighbour_cost The cost from start to the neighbour state. Note: this is not just cost from "current".
-   * @param heuristic_cost The heuristic cost to the target.
-   */
-  void AddNeighbour(VertexQueue &open_set,
-                    TimeIndexValueMap &visited,
-                    const AStarVertex::IdTimeIndex &current_id_time_index,
-                    const AStarVertex::IdTimeIndex &neighbour_id_time_index,
-                    uint32_t neighbour_cost,
-                    uint32_t heuristic_cost);
+  /// The priority queue to use for the open set.
+  OpenSetType open_set_type_;
+
+  /// Bounds on the search.
+  Limits limits_;
 
-  std::vector<HexVertexId> ConstructPath(AStarVertex::IdTimeIndex vertex, const TimeIndexValueMap &visited);
+  /// Whether to print a progress bar.
+  bool show_progress_ = true;
 };
 
 #endif  // PATHFINDING_ASTARPATHFINDER_H_
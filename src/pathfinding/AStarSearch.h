@@ -0,0 +1,409 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_ASTARSEARCH_H_
+#define PATHFINDING_ASTARSEARCH_H_
+
+#include <chrono>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "common/ProgressBar.h"
+#include "pathfinding/AStarPathfinder.h"
+#include "pathfinding/AStarVertex.h"
+#include "pathfinding/ClosedSet.h"
+#include "pathfinding/OpenSet.h"
+
+/**
+ * @brief The A* search, templated on the heuristic and cost calculator types.
+ *
+ * With concrete heuristic and cost calculator classes, their methods are called without virtual dispatch, so the
+ * compiler can inline them (and whatever they define in their headers) into the expansion loop. The objects must then
+ * be of exactly those classes, not of classes derived from them, which the constructor checks. With the abstract
+ * Heuristic and CostCalculator classes, calls are virtual; AStarPathfinder runs this search for any heuristic and cost
+ * calculator that way.
+ *
+ * Searches are configured and behave exactly like AStarPathfinder.
+ * @tparam HeuristicType A Heuristic class.
+ * @tparam CostCalculatorType A CostCalculator class.
+ */
+template<typename HeuristicType, typename CostCalculatorType>
+class AStarSearch : public Pathfinder {
+  static_assert(std::is_base_of<Heuristic, HeuristicType>::value, "HeuristicType must be a Heuristic");
+  static_assert(std::is_base_of<CostCalculator, CostCalculatorType>::value,
+                "CostCalculatorType must be a CostCalculator");
+
+ public:
+  /**
+   * See AStarPathfinder::AStarPathfinder.
+   * @throw std::runtime_error If use_indirect_neighbours is true but cost_calculator doesn't support it, or
+   *    heuristic or cost_calculator is of a class derived from a concrete HeuristicType or CostCalculatorType.
+   */
+  AStarSearch(const HexPlanet &planet,
+              const HeuristicType &heuristic,
+              const CostCalculatorType &cost_calculator,
+              HexVertexId start,
+              HexVertexId target,
+              bool use_indirect_neighbours = false,
+              AStarPathfinder::OpenSetType open_set_type = AStarPathfinder::OpenSetType::kBinaryHeap,
+              const Limits &limits = Limits())
+      : Pathfinder(planet, heuristic, cost_calculator, start, target),
+        heuristic_type_(heuristic),
+        cost_calculator_type_(cost_calculator),
+        use_indirect_neighbours_(use_indirect_neighbours),
+        open_set_type_(open_set_type),
+        limits_(limits) {
+    if (use_indirect_neighbours_ && !cost_calculator_.is_indirect_neighbour_safe()) {
+      throw std::runtime_error("This cost calculator cannot be safely used with indirect neighbours");
+    }
+    // Statically bound calls would silently skip the overrides of a derived class.
+    if (StaticHeuristic::value && typeid(heuristic) != typeid(HeuristicType)) {
+      throw std::runtime_error("The heuristic is not of the search's heuristic type");
+    }
+    if (StaticCostCalculator::value && typeid(cost_calculator) != typeid(CostCalculatorType)) {
+      throw std::runtime_error("The cost calculator is not of the search's cost calculator type");
+    }
+  }
+
+  /**
+   * See AStarPathfinder::Run.
+   */
+  Result Run() override {
+    stats_ = Stats();
+
+    // With a maximum time, states past the cost calculator's horizon still differ in the time they have left, so
+    // each time step up to max_time needs its own slot.
+    const uint32_t time_horizon = limits_.max_time != Limits().max_time
+                                  ? limits_.max_time : cost_calculator_.time_horizon();
+    if (time_horizon != CostCalculator::kUnboundedTimeHorizon &&
+        planet_.vertex_count() * (static_cast<size_t>(time_horizon) + 1) <= AStarPathfinder::kMaxDenseClosedSetSize) {
+      closed_set::DensePaged<VisitedStateData> visited(planet_.vertex_count(), time_horizon);
+      return Search(visited);
+    }
+
+    const size_t reserve_size = planet_.subdivision_level() >= AStarPathfinder::kClosedSetReservePlanetSize
+                                ? AStarPathfinder::kClosedSetReserveSize : 0;
+    closed_set::HashMap<VisitedStateData> visited(reserve_size);
+    return Search(visited);
+  }
+
+  /**
+   * @param show_progress Whether Run() prints a progress bar to stdout (on by default).
+   */
+  void set_show_progress(bool show_progress) { show_progress_ = show_progress; }
+
+ private:
+  struct VisitedStateData {
+    /// The vertex and time of this state.
+    AStarVertex::IdTimeIndex id_time_index;
+    /// The cost to this vertex (and time) from the start.
+    uint32_t cost;
+    /// The open set key (cost + heuristic) this state was last queued with.
+    uint32_t key;
+    /// The ancestor to this node.
+    AStarVertex::IdTimeIndex parent;
+    /// Position in an open_set::IndexedHeap.
+    uint32_t open_set_index;
+  };
+
+  /// Whether heuristic calls bypass virtual dispatch.
+  using StaticHeuristic = std::integral_constant<bool, !std::is_abstract<HeuristicType>::value>;
+  /// Whether cost calculator calls bypass virtual dispatch.
+  using StaticCostCalculator = std::integral_constant<bool, !std::is_abstract<CostCalculatorType>::value>;
+
+  const HeuristicType &heuristic_type_;
+  const CostCalculatorType &cost_calculator_type_;
+
+  /// Whether to use indirect neighbours for pathfinding.
+  bool use_indirect_neighbours_;
+
+  /// The priority queue to use for the open set.
+  AStarPathfinder::OpenSetType open_set_type_;
+
+  /// Bounds on the search.
+  Limits limits_;
+
+  /// Whether to print a progress bar.
+  bool show_progress_ = true;
+
+  /// The edges out of the state being expanded, reused between expansions.
+  CostCalculator::EdgeResults edge_results_;
+
+  uint32_t HeuristicCost(HexVertexId source, std::true_type) const {
+    return heuristic_type_.HeuristicType::calculate(source, target_);
+  }
+
+  uint32_t HeuristicCost(HexVertexId source, std::false_type) const {
+    return heuristic_type_.calculate(source, target_);
+  }
+
+  /**
+   * @return The heuristic cost from |source| to the target.
+   */
+  uint32_t HeuristicCost(HexVertexId source) const { return HeuristicCost(source, StaticHeuristic()); }
+
+  void EdgeCosts(HexVertexId source, uint32_t start_time, std::true_type) {
+    cost_calculator_type_.CostCalculatorType::calculate_all(source, start_time, use_indirect_neighbours_,
+                                                            &edge_results_);
+  }
+
+  void EdgeCosts(HexVertexId source, uint32_t start_time, std::false_type) {
+    cost_calculator_type_.calculate_all(source, start_time, use_indirect_neighbours_, &edge_results_);
+  }
+
+  /**
+   * Fill edge_results_ with the costs and ending time steps of the edges out of |source|.
+   */
+  void EdgeCosts(HexVertexId source, uint32_t start_time) {
+    EdgeCosts(source, start_time, StaticCostCalculator());
+  }
+
+  /**
+   * Find the path from start to target using |visited| and the open set chosen at construction.
+   * @tparam ClosedSet One of the closed_set containers of VisitedStateData.
+   * @param visited An empty closed set.
+   * @return The path from start_ to target_.
+   */
+  template<typename ClosedSet>
+  Result Search(ClosedSet &visited) {
+    switch (open_set_type_) {
+      case AStarPathfinder::OpenSetType::kIndexedHeap: {
+        open_set::IndexedHeap<VisitedStateData> open_set;
+        return Search(open_set, visited);
+      }
+      case AStarPathfinder::OpenSetType::kRadixHeap: {
+        open_set::RadixHeap<VisitedStateData> open_set;
+        return Search(open_set, visited);
+      }
+      case AStarPathfinder::OpenSetType::kBinaryHeap:
+      default: {
+        open_set::BinaryHeap<VisitedStateData> open_set;
+        return Search(open_set, visited);
+      }
+    }
+  }
+
+  /**
+   * Find the path from start to target using |open_set| and |visited|.
+   * @tparam OpenSet One of the open_set priority queues over VisitedStateData.
+   * @tparam ClosedSet One of the closed_set containers of VisitedStateData.
+   * @param open_set An empty open set.
+   * @param visited An empty closed set.
+   * @return The path from start_ to target_.
+   */
+  template<typename OpenSet, typename ClosedSet>
+  Result Search(OpenSet &open_set, ClosedSet &visited);
+
+  /**
+   * If a neighbour state expansion provides a new lowest cost to the neighbour, add it to the open set and visited
+   * state data.
+   * @param open_set The open set.
+   * @param visited Visited state data.
+   * @param current_id_time_index IdTimeIndex of the "current" state.
+   * @param neighbour_id_time_index IdTimeIndex of the "neighbour" state.
+   * @param neighbour_cost The cost from start to the neighbour state. Note: this is not just cost from "current".
+   * @param heuristic_cost The heuristic cost to the target.
+   */
+  template<typename OpenSet, typename ClosedSet>
+  void AddNeighbour(OpenSet &open_set,
+                    ClosedSet &visited,
+                    const AStarVertex::IdTimeIndex &current_id_time_index,
+                    const AStarVertex::IdTimeIndex &neighbour_id_time_index,
+                    uint32_t neighbour_cost,
+                    uint32_t heuristic_cost);
+
+  /**
+   * @param times Filled with the time step at which each vertex of the path is reached.
+   * @return The path from the start to |vertex|.
+   */
+  template<typename ClosedSet>
+  std::vector<HexVertexId> ConstructPath(AStarVertex::IdTimeIndex vertex, ClosedSet &visited,
+                                         std::vector<uint32_t> *times);
+};
+
+template<typename HeuristicType, typename CostCalculatorType>
+template<typename OpenSet, typename ClosedSet>
+Pathfinder::Result AStarSearch<HeuristicType, CostCalculatorType>::Search(OpenSet &open_set, ClosedSet &visited) {
+  const HexGraph &graph = planet_.graph();
+
+  // Add start state.
+  const uint32_t max_h_cost = HeuristicCost(start_);
+  const AStarVertex::IdTimeIndex start_id_time_index(start_, 0);
+  VisitedStateData &start_data = visited.insert(start_id_time_index, {start_id_time_index, 0, max_h_cost,
+                                                                      std::make_pair(kInvalidHexVertexId, 0),
+                                                                      open_set::kNotQueued});
+  open_set.push(&start_data, max_h_cost);
+
+  uint32_t min_h_cost = max_h_cost;
+  // The state closest to the target, the end of the partial path if the target isn't reached.
+  AStarVertex::IdTimeIndex closest_id_time_index = start_id_time_index;
+  ProgressBar progress_bar;
+  int progressCount = 0;
+
+  const auto search_start_time = std::chrono::steady_clock::now();
+
+  // Finishes the stats and builds the result ending at |end| (the target, or the closest state to it).
+  auto make_result = [&](const AStarVertex::IdTimeIndex &end, Status status) -> Result {
+    if (show_progress_) {
+      progress_bar.flush();
+    }
+
+    stats_.closed_set_size = visited.size();
+    stats_.open_set_size = open_set.size();
+    stats_.pushes = open_set.pushes();
+    stats_.decrease_keys = open_set.decrease_keys();
+
+    const VisitedStateData &end_data = *visited.find(end);
+    Result result;
+    result.path = ConstructPath(end, visited, &result.times);
+    result.cost = end_data.cost;
+    result.time = end_data.id_time_index.second;
+    result.status = status;
+    return result;
+  };
+
+  // The state space is only finite if the time is bounded, by limits_.max_time or a cost calculator time horizon.
+  // Otherwise, an unreachable target is only detected through the other limits.
+  while (!open_set.empty()) {
+    const open_set::Item<VisitedStateData> item = open_set.pop();
+    stats_.pops++;
+
+    // A cheaper path to this state was found after this item was queued, the newer item has already been expanded.
+    if (item.key != item.entry->key) {
+      stats_.stale_pops++;
+      continue;
+    }
+
+    stats_.expansions++;
+
+    // The best data for this IdTimeIndex up until now.
+    const VisitedStateData current_data = *item.entry;
+    const AStarVertex current(current_data.id_time_index, current_data.key);
+
+    // Show on progress bar the closest we have gotten to goal
+    const uint32_t h_cost = HeuristicCost(current.hex_vertex_id());
+    if (h_cost < min_h_cost) {
+      min_h_cost = h_cost;
+      closest_id_time_index = current.id_time_index();
+    }
+
+    if (show_progress_ && progressCount > 10000) {
+      const double progress = 1.0 - static_cast<double>(min_h_cost) / max_h_cost;
+      progress_bar.update(progress);
+      const std::string text_after_progress_bar = " | Path cost = " + std::to_string(current.cost());
+      progress_bar.print(text_after_progress_bar);
+      progressCount = 0;
+    }
+
+    progressCount++;
+
+    if (current.hex_vertex_id() == target_) {
+      return make_result(current.id_time_index(), Status::kFound);
+    }
+
+    if (limits_.max_expansions != 0 && stats_.expansions >= limits_.max_expansions) {
+      return make_result(closest_id_time_index, Status::kExpansionLimitExceeded);
+    }
+
+    if (stats_.expansions % AStarPathfinder::kLimitCheckInterval == 0) {
+      if (limits_.max_duration.count() != 0 &&
+          std::chrono::steady_clock::now() - search_start_time >= limits_.max_duration) {
+        return make_result(closest_id_time_index, Status::kTimeLimitExceeded);
+      }
+
+      if (limits_.max_memory != 0 &&
+          visited.memory_usage() + open_set.size() * sizeof(open_set::Item<VisitedStateData>) >= limits_.max_memory) {
+        return make_result(closest_id_time_index, Status::kMemoryLimitExceeded);
+      }
+    }
+
+    const HexVertexId current_id = current.hex_vertex_id();
+    const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(current_id);
+
+    // Calculate the cost and time between the current vertex and all its neighbours.
+    EdgeCosts(current_id, current.time());
+
+    // Process edges to direct neighbours, followed by the indirect ones if used.
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(current_id);
+    for (size_t i = 0; i < edge_results_.costs.size(); i++) {
+      HexVertexId neighbour_id = i < neighbours.size() ? neighbours[i] : indirect_neighbours[i - neighbours.size()];
+
+      // Total cost from the start to this neighbour.
+      uint32_t neighbour_cost = current_data.cost + edge_results_.costs[i];
+
+      // Heuristic cost from this neighbour to the target.
+      uint32_t heuristic_cost = HeuristicCost(neighbour_id);
+
+      AStarVertex::IdTimeIndex neighbour_id_time_index(neighbour_id, edge_results_.times[i]);
+      AddNeighbour(open_set, visited, current.id_time_index(), neighbour_id_time_index, neighbour_cost, heuristic_cost);
+    }
+  }
+
+  // Every state within the time bounds was visited.
+  return make_result(closest_id_time_index, Status::kUnreachable);
+}
+
+template<typename HeuristicType, typename CostCalculatorType>
+template<typename OpenSet, typename ClosedSet>
+void AStarSearch<HeuristicType, CostCalculatorType>::AddNeighbour(
+    OpenSet &open_set,
+    ClosedSet &visited,
+    const AStarVertex::IdTimeIndex &current_id_time_index,
+    const AStarVertex::IdTimeIndex &neighbour_id_time_index,
+    uint32_t neighbour_cost,
+    uint32_t heuristic_cost) {
+  if (neighbour_id_time_index.second > limits_.max_time) {
+    return;
+  }
+
+  VisitedStateData *data = visited.find(neighbour_id_time_index);
+  const uint32_t key = neighbour_cost + heuristic_cost;
+
+  if (data == nullptr) {
+    // Create the VisitedData instance.
+    data = &visited.insert(neighbour_id_time_index, {neighbour_id_time_index, neighbour_cost, key,
+                                                     current_id_time_index, open_set::kNotQueued});
+  } else if (neighbour_cost < data->cost) {
+    // Update the members of the existing VisitedData instance (keeping its place in the open set, if any).
+    // The closed set may merge time steps, so the time of the state can change too.
+    data->id_time_index = neighbour_id_time_index;
+    data->cost = neighbour_cost;
+    data->key = key;
+    data->parent = current_id_time_index;
+  } else {
+    return;
+  }
+
+  // Queue the neighbour, or lower its key if the open set supports it. Outdated items are skipped when popped.
+  open_set.push(data, key);
+}
+
+template<typename HeuristicType, typename CostCalculatorType>
+template<typename ClosedSet>
+std::vector<HexVertexId> AStarSearch<HeuristicType, CostCalculatorType>::ConstructPath(
+    AStarVertex::IdTimeIndex vertex, ClosedSet &visited, std::vector<uint32_t> *times) {
+  auto path = std::deque<HexVertexId>();
+  auto path_times = std::deque<uint32_t>();
+
+  const VisitedStateData *data = visited.find(vertex);
+
+  while (data != nullptr) {
+    vertex = data->id_time_index;
+    path.push_front(vertex.first);
+    path_times.push_front(vertex.second);
+
+    if (vertex.first == start_) {
+      break;
+    }
+
+    data = visited.find(data->parent);
+  }
+
+  times->assign(path_times.begin(), path_times.end());
+  return {path.begin(), path.end()};
+}
+
+#endif  // PATHFINDING_ASTARSEARCH_H_
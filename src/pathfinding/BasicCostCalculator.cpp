@@ -4,7 +4,7 @@
 
 #include <iostream>
 
-BasicCostCalculator::BasicCostCalculator(HexPlanet &planet, std::unique_ptr<BasicHexMap> &map)
+BasicCostCalculator::BasicCostCalculator(const HexPlanet &planet, std::unique_ptr<BasicHexMap> &map)
     : HaversineCostCalculator(planet), map_(std::move(map)) {}
 
 CostCalculator::Result BasicCostCalculator::calculate_neighbour(HexVertexId source,
@@ -13,7 +13,7 @@ CostCalculator::Result BasicCostCalculator::calculate_neighbour(HexVertexId sour
   Result result = HaversineCostCalculator::calculate_neighbour(source, neighbour, start_time);
 
   // Get neighbour vertex ID; |neighbour| is valid because otherwise an exception would have been thrown earlier.
-  HexVertexId target = planet_.vertex(source).neighbours[neighbour];
+  HexVertexId target = planet_.graph().neighbours(source)[neighbour];
 
   result.cost += calculate_map_cost(source, target, start_time);
 
@@ -30,6 +30,24 @@ CostCalculator::Result BasicCostCalculator::calculate_target(HexVertexId source,
   return result;
 }
 
+void BasicCostCalculator::calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                                        EdgeResults *results) const {
+  HaversineCostCalculator::calculate_all(source, start_time, include_indirect, results);
+
+  const HexGraph &graph = planet_.graph();
+  const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(source);
+  const uint32_t source_risk = map_->get_risk(source);
+  for (size_t i = 0; i < neighbours.size(); i++) {
+    results->costs[i] += source_risk + map_->get_risk(neighbours[i]);
+  }
+  if (include_indirect) {
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+    for (size_t i = 0; i < indirect_neighbours.size(); i++) {
+      results->costs[neighbours.size() + i] += source_risk + map_->get_risk(indirect_neighbours[i]);
+    }
+  }
+}
+
 uint32_t BasicCostCalculator::calculate_map_cost(HexVertexId target, HexVertexId source, uint32_t) const {
   return map_->get_risk(source) + map_->get_risk(target);
 }
@@ -3,6 +3,8 @@
 #ifndef PATHFINDING_BASICCOSTCALCULATOR_H_
 #define PATHFINDING_BASICCOSTCALCULATOR_H_
 
+#include <memory>
+
 #include "pathfinding/BasicHexMap.h"
 #include "pathfinding/HaversineCostCalculator.h"
 
@@ -15,7 +17,7 @@ class BasicCostCalculator : public HaversineCostCalculator {
    * @param planet The planet.
    * @param map The risk map for the planet.
    */
-  explicit BasicCostCalculator(HexPlanet &planet, std::unique_ptr<BasicHexMap> &map);
+  explicit BasicCostCalculator(const HexPlanet &planet, std::unique_ptr<BasicHexMap> &map);
 
   /**
    * Calculate the cost to an immediate neighbour of |source| using the Haversine formula and the BasicHexMap.
@@ -39,6 +41,13 @@ class BasicCostCalculator : public HaversineCostCalculator {
    */
   Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override;
 
+  /**
+   * Calculate the costs to all neighbours of |source| at once, see CostCalculator::calculate_all(). The risk
+   * of |source| is only looked up once.
+   */
+  void calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                     EdgeResults *results) const override;
+
   /// Class can't be copied
   BasicCostCalculator(const BasicCostCalculator &) = delete;
 
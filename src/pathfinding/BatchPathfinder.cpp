@@ -0,0 +1,63 @@
+// Copyright 2022 UBC Sailbot
+
+#include "pathfinding/BatchPathfinder.h"
+#include "common/ParallelFor.h"
+
+#include <stdexcept>
+#include <utility>
+
+BatchPathfinder::BatchPathfinder(const HexPlanet &planet,
+                                 const CostCalculator &cost_calculator,
+                                 HeuristicFactory heuristic_factory,
+                                 bool use_indirect_neighbours,
+                                 AStarPathfinder::OpenSetType open_set_type,
+                                 const Pathfinder::Limits &limits,
+                                 unsigned thread_count)
+    : planet_(planet),
+      cost_calculator_(cost_calculator),
+      heuristic_factory_(std::move(heuristic_factory)),
+      use_indirect_neighbours_(use_indirect_neighbours),
+      open_set_type_(open_set_type),
+      limits_(limits),
+      thread_count_(thread_count) {
+  if (use_indirect_neighbours_ && !cost_calculator_.is_indirect_neighbour_safe()) {
+    throw std::runtime_error("This cost calculator cannot be safely used with indirect neighbours");
+  }
+}
+
+BatchPathfinder::BatchPathfinder(const HexPlanet &planet,
+                                 const CostCalculator &cost_calculator,
+                                 const Heuristic &heuristic,
+                                 bool use_indirect_neighbours,
+                                 AStarPathfinder::OpenSetType open_set_type,
+                                 const Pathfinder::Limits &limits,
+                                 unsigned thread_count)
+    : BatchPathfinder(planet, cost_calculator, HeuristicFactory(), use_indirect_neighbours, open_set_type, limits,
+                      thread_count) {
+  shared_heuristic_ = &heuristic;
+}
+
+std::vector<BatchPathfinder::QueryResult> BatchPathfinder::Run(const std::vector<Query> &queries) const {
+  std::vector<QueryResult> results(queries.size());
+
+  parallel::ForDynamic(queries.size(), thread_count_, [&](size_t i) {
+    const Query &query = queries[i];
+    QueryResult &query_result = results[i];
+    try {
+      if (query.target >= planet_.vertex_count()) {
+        throw std::runtime_error("Target is not a valid vertex.");
+      }
+      const std::unique_ptr<Heuristic> own_heuristic = shared_heuristic_ ? nullptr : heuristic_factory_(query.target);
+      const Heuristic &heuristic = shared_heuristic_ ? *shared_heuristic_ : *own_heuristic;
+      AStarPathfinder pathfinder(planet_, heuristic, cost_calculator_, query.start, query.target,
+                                 use_indirect_neighbours_, open_set_type_, limits_);
+      pathfinder.set_show_progress(false);
+      query_result.result = pathfinder.Run();
+      query_result.stats = pathfinder.stats();
+    } catch (const std::exception &e) {
+      query_result.error = e.what();
+    }
+  });
+
+  return results;
+}
@@ -0,0 +1,101 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_BATCHPATHFINDER_H_
+#define PATHFINDING_BATCHPATHFINDER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pathfinding/AStarPathfinder.h"
+
+/**
+ * Runs many AStarPathfinder queries over one planet and cost calculator on a pool of threads.
+ *
+ * The planet, cost calculator and heuristics are shared between threads and must only be read during Run(). All of
+ * them are read-only after construction, so this holds as long as nothing modifies them concurrently.
+ */
+class BatchPathfinder {
+ public:
+  /**
+   * A start/target pair to find a path for.
+   */
+  struct Query {
+    HexVertexId start;
+    HexVertexId target;
+  };
+
+  /**
+   * The outcome of a single query.
+   */
+  struct QueryResult {
+    /// The pathfinding result, only meaningful if error is empty.
+    Pathfinder::Result result = {{}, 0, 0, Pathfinder::Status::kFound, {}};
+    /// The stats of the query's pathfinder run.
+    Pathfinder::Stats stats;
+    /// The message of the exception thrown by the query, empty on success.
+    std::string error;
+  };
+
+  /// Creates the heuristic for a query target. Called concurrently from the worker threads.
+  typedef std::function<std::unique_ptr<Heuristic>(HexVertexId target)> HeuristicFactory;
+
+  /**
+   * @param planet Planet to use.
+   * @param cost_calculator CostCalculator shared by all queries.
+   * @param heuristic_factory Creates the heuristic of each query (e.g. a HaversineHeuristic with a target table).
+   * @param use_indirect_neighbours Whether to use indirect neighbours for pathfinding.
+   * @param open_set_type The priority queue to use for the open set.
+   * @param limits Bounds on each query.
+   * @param thread_count The number of worker threads. 0 for one per hardware thread.
+   * @throw std::runtime_error If use_indirect_neighbours is true but cost_calculator doesn't support it.
+   */
+  BatchPathfinder(const HexPlanet &planet,
+                  const CostCalculator &cost_calculator,
+                  HeuristicFactory heuristic_factory,
+                  bool use_indirect_neighbours = false,
+                  AStarPathfinder::OpenSetType open_set_type = AStarPathfinder::OpenSetType::kBinaryHeap,
+                  const Pathfinder::Limits &limits = Pathfinder::Limits(),
+                  unsigned thread_count = 0);
+
+  /**
+   * @param planet Planet to use.
+   * @param cost_calculator CostCalculator shared by all queries.
+   * @param heuristic Heuristic shared by all queries, which must not depend on a fixed target (e.g. a
+   *    LandmarkHeuristic). It must outlive the BatchPathfinder.
+   * @param use_indirect_neighbours Whether to use indirect neighbours for pathfinding.
+   * @param open_set_type The priority queue to use for the open set.
+   * @param limits Bounds on each query.
+   * @param thread_count The number of worker threads. 0 for one per hardware thread.
+   * @throw std::runtime_error If use_indirect_neighbours is true but cost_calculator doesn't support it.
+   */
+  BatchPathfinder(const HexPlanet &planet,
+                  const CostCalculator &cost_calculator,
+                  const Heuristic &heuristic,
+                  bool use_indirect_neighbours = false,
+                  AStarPathfinder::OpenSetType open_set_type = AStarPathfinder::OpenSetType::kBinaryHeap,
+                  const Pathfinder::Limits &limits = Pathfinder::Limits(),
+                  unsigned thread_count = 0);
+
+  /**
+   * Find the paths of all queries. Queries are handed out to the threads one at a time, so long queries don't hold
+   * up the others. A query that throws only fails itself.
+   * @param queries The start/target pairs.
+   * @return The result of each query, in the order of |queries|.
+   */
+  std::vector<QueryResult> Run(const std::vector<Query> &queries) const;
+
+ private:
+  const HexPlanet &planet_;
+  const CostCalculator &cost_calculator_;
+  HeuristicFactory heuristic_factory_;
+  /// The heuristic of every query if not null, otherwise heuristic_factory_ creates one per query.
+  const Heuristic *shared_heuristic_ = nullptr;
+  bool use_indirect_neighbours_;
+  AStarPathfinder::OpenSetType open_set_type_;
+  Pathfinder::Limits limits_;
+  unsigned thread_count_;
+};
+
+#endif  // PATHFINDING_BATCHPATHFINDER_H_
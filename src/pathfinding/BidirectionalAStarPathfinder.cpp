@@ -0,0 +1,252 @@
+// Copyright 2022 UBC Sailbot
+
+#include "pathfinding/BidirectionalAStarPathfinder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+#include "pathfinding/AStarPathfinder.h"
+
+BidirectionalAStarPathfinder::BidirectionalAStarPathfinder(const HexPlanet &planet,
+                                                           const Heuristic &heuristic,
+                                                           const CostCalculator &cost_calculator,
+                                                           HexVertexId start,
+                                                           HexVertexId target,
+                                                           bool use_indirect_neighbours,
+                                                           const Limits &limits)
+    : Pathfinder(planet, heuristic, cost_calculator, start, target),
+      use_indirect_neighbours_(use_indirect_neighbours),
+      limits_(limits),
+      best_cost_(std::numeric_limits<uint32_t>::max()),
+      meeting_vertex_(kInvalidHexVertexId) {
+  if (!cost_calculator_.is_time_independent()) {
+    throw std::runtime_error("Bidirectional search requires a time-independent cost calculator");
+  }
+  if (use_indirect_neighbours_ && !cost_calculator_.is_indirect_neighbour_safe()) {
+    throw std::runtime_error("This cost calculator cannot be safely used with indirect neighbours");
+  }
+  if (limits_.max_time != Limits().max_time) {
+    throw std::runtime_error("Bidirectional search doesn't support a maximum time");
+  }
+}
+
+Pathfinder::Result BidirectionalAStarPathfinder::Run() {
+  stats_ = Stats();
+  best_cost_ = std::numeric_limits<uint32_t>::max();
+  meeting_vertex_ = kInvalidHexVertexId;
+
+  Direction forward(true, planet_.vertex_count());
+  Direction backward(false, planet_.vertex_count());
+
+  // Add the start and target states, which meet right away if they're the same vertex.
+  const AStarVertex::IdTimeIndex no_parent(kInvalidHexVertexId, 0);
+  AddNeighbour(&forward, &backward, no_parent, AStarVertex::IdTimeIndex(start_, 0), 0);
+  AddNeighbour(&backward, &forward, no_parent, AStarVertex::IdTimeIndex(target_, 0), 0);
+
+  uint32_t min_h_cost = heuristic_.calculate(start_, target_);
+  // The forward state closest to the target, the end of the partial path if the target isn't reached.
+  HexVertexId closest_id = start_;
+
+  const auto search_start_time = std::chrono::steady_clock::now();
+
+  // Finishes the stats and builds the result: the best path through meeting_vertex_ if the searches met, the forward
+  // path to the closest state otherwise.
+  auto make_result = [&](Status status) -> Result {
+    stats_.closed_set_size = forward.visited.size() + backward.visited.size();
+    stats_.open_set_size = forward.open_set.size() + backward.open_set.size();
+    stats_.pushes = forward.open_set.pushes() + backward.open_set.pushes();
+
+    const bool found = status == Status::kFound;
+    const std::vector<const VisitedStateData *> forward_chain = ParentChain(found ? meeting_vertex_ : closest_id,
+                                                                            &forward);
+    Result result;
+    result.status = status;
+    for (auto i = forward_chain.rbegin(); i != forward_chain.rend(); ++i) {
+      result.path.push_back((*i)->id_time_index.first);
+      result.times.push_back((*i)->id_time_index.second);
+    }
+    result.cost = forward_chain.front()->cost;
+    result.time = forward_chain.front()->id_time_index.second;
+
+    if (found) {
+      // Continue from the meeting vertex to the target, the backward states hold the time left to the target.
+      const std::vector<const VisitedStateData *> backward_chain = ParentChain(meeting_vertex_, &backward);
+      result.cost = best_cost_;
+      result.time += backward_chain.front()->id_time_index.second;
+      for (size_t i = 1; i < backward_chain.size(); i++) {
+        result.path.push_back(backward_chain[i]->id_time_index.first);
+        result.times.push_back(result.time - backward_chain[i]->id_time_index.second);
+      }
+    }
+    return result;
+  };
+
+  // Once either search runs out of states, no path cheaper than the best one found (if any) remains.
+  while (!forward.open_set.empty() && !backward.open_set.empty()) {
+    // Expand the smaller frontier, which keeps the two searches balanced.
+    Direction *direction = forward.open_set.size() <= backward.open_set.size() ? &forward : &backward;
+    Direction *other = direction == &forward ? &backward : &forward;
+
+    const open_set::Item<VisitedStateData> item = direction->open_set.pop();
+    stats_.pops++;
+
+    // A cheaper path to this state was found after this item was queued, the newer item has already been expanded.
+    if (item.key != item.entry->key) {
+      stats_.stale_pops++;
+      continue;
+    }
+
+    // Keys only grow, so a path not found yet costs at least the sum of the keys last expanded in each direction.
+    direction->last_key = item.key;
+    if (static_cast<uint64_t>(item.key) + other->last_key >= best_cost_) {
+      return make_result(Status::kFound);
+    }
+
+    stats_.expansions++;
+    if (!direction->forward) {
+      stats_.backward_expansions++;
+    }
+
+    const VisitedStateData current = *item.entry;
+    if (direction->forward) {
+      const uint32_t h_cost = heuristic_.calculate(current.id_time_index.first, target_);
+      if (h_cost < min_h_cost) {
+        min_h_cost = h_cost;
+        closest_id = current.id_time_index.first;
+      }
+    }
+
+    if (limits_.max_expansions != 0 && stats_.expansions >= limits_.max_expansions) {
+      return make_result(Status::kExpansionLimitExceeded);
+    }
+
+    if (stats_.expansions % AStarPathfinder::kLimitCheckInterval == 0) {
+      if (limits_.max_duration.count() != 0 &&
+          std::chrono::steady_clock::now() - search_start_time >= limits_.max_duration) {
+        return make_result(Status::kTimeLimitExceeded);
+      }
+
+      const size_t memory_usage = forward.visited.memory_usage() + backward.visited.memory_usage() +
+          (forward.open_set.size() + backward.open_set.size()) * sizeof(open_set::Item<VisitedStateData>);
+      if (limits_.max_memory != 0 && memory_usage >= limits_.max_memory) {
+        return make_result(Status::kMemoryLimitExceeded);
+      }
+    }
+
+    Expand(direction, other, current);
+  }
+
+  return make_result(best_cost_ != std::numeric_limits<uint32_t>::max() ? Status::kFound : Status::kUnreachable);
+}
+
+void BidirectionalAStarPathfinder::SetHeuristicCosts(const Direction &direction, VisitedStateData *data) const {
+  const HexVertexId vertex = data->id_time_index.first;
+  const int64_t target_h_cost = heuristic_.calculate(vertex, target_);
+  const int64_t start_h_cost = heuristic_.calculate(start_, vertex);
+  // Rounded down, which keeps the reduced edge costs non-negative.
+  const int64_t difference = target_h_cost - start_h_cost;
+  const int64_t potential = difference >= 0 ? difference / 2 : -((1 - difference) / 2);
+
+  data->h_cost = static_cast<uint32_t>(direction.forward ? target_h_cost : start_h_cost);
+  data->potential = direction.forward ? potential : -potential;
+}
+
+void BidirectionalAStarPathfinder::Expand(Direction *direction, Direction *other, const VisitedStateData &current) {
+  const HexGraph &graph = planet_.graph();
+  const HexVertexId current_id = current.id_time_index.first;
+  const uint32_t current_time = current.id_time_index.second;
+  const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(current_id);
+  const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(current_id);
+
+  if (direction->forward) {
+    // Calculate the cost and time between the current vertex and all its neighbours.
+    cost_calculator_.calculate_all(current_id, current_time, use_indirect_neighbours_, &edge_results_);
+    for (size_t i = 0; i < edge_results_.costs.size(); i++) {
+      HexVertexId neighbour_id = i < neighbours.size() ? neighbours[i] : indirect_neighbours[i - neighbours.size()];
+      AddNeighbour(direction, other, current.id_time_index,
+                   AStarVertex::IdTimeIndex(neighbour_id, edge_results_.times[i]),
+                   current.cost + edge_results_.costs[i]);
+    }
+    return;
+  }
+
+  // The backward search follows the edges from each neighbour to the current vertex. Their cost doesn't depend on the
+  // start time, so the edge duration is its ending time when starting at time step 0.
+  for (const HexVertexId neighbour_id : neighbours) {
+    const HexGraph::Span<HexVertexId> neighbour_neighbours = graph.neighbours(neighbour_id);
+    const auto edge = std::find(neighbour_neighbours.begin(), neighbour_neighbours.end(), current_id);
+    if (edge == neighbour_neighbours.end()) {
+      throw std::runtime_error("Vertex neighbours aren't symmetric");
+    }
+    const CostCalculator::Result result = cost_calculator_.calculate_neighbour(
+        neighbour_id, static_cast<size_t>(edge - neighbour_neighbours.begin()), 0);
+    AddNeighbour(direction, other, current.id_time_index,
+                 AStarVertex::IdTimeIndex(neighbour_id, current_time + result.time), current.cost + result.cost);
+  }
+
+  if (use_indirect_neighbours_) {
+    for (const HexVertexId neighbour_id : indirect_neighbours) {
+      const CostCalculator::Result result = cost_calculator_.calculate_target(neighbour_id, current_id, 0);
+      AddNeighbour(direction, other, current.id_time_index,
+                   AStarVertex::IdTimeIndex(neighbour_id, current_time + result.time), current.cost + result.cost);
+    }
+  }
+}
+
+void BidirectionalAStarPathfinder::AddNeighbour(Direction *direction,
+                                                Direction *other,
+                                                const AStarVertex::IdTimeIndex &current_id_time_index,
+                                                const AStarVertex::IdTimeIndex &neighbour_id_time_index,
+                                                uint32_t neighbour_cost) {
+  VisitedStateData *data = direction->visited.find(neighbour_id_time_index);
+  VisitedStateData neighbour_data;
+
+  if (data == nullptr) {
+    neighbour_data.id_time_index = neighbour_id_time_index;
+    SetHeuristicCosts(*direction, &neighbour_data);
+  } else if (neighbour_cost < data->cost) {
+    neighbour_data = *data;
+  } else {
+    return;
+  }
+
+  // Every path through the state costs at least this, it can't improve on the best path found so far.
+  if (static_cast<uint64_t>(neighbour_cost) + neighbour_data.h_cost >= best_cost_) {
+    return;
+  }
+
+  // Keys are non-negative as the heuristic is a lower bound on the cost of either side.
+  neighbour_data.id_time_index = neighbour_id_time_index;
+  neighbour_data.cost = neighbour_cost;
+  neighbour_data.key = static_cast<uint32_t>(std::max<int64_t>(0, neighbour_cost + neighbour_data.potential));
+  neighbour_data.parent = current_id_time_index;
+
+  // Update the existing VisitedData instance in place, keeping its address in the open set.
+  if (data == nullptr) {
+    data = &direction->visited.insert(neighbour_id_time_index, neighbour_data);
+  } else {
+    *data = neighbour_data;
+  }
+
+  direction->open_set.push(data, data->key);
+
+  // The searches meet if the other one reached this vertex too.
+  const VisitedStateData *other_data = other->visited.find(neighbour_id_time_index);
+  if (other_data != nullptr && neighbour_cost + other_data->cost < best_cost_) {
+    best_cost_ = neighbour_cost + other_data->cost;
+    meeting_vertex_ = neighbour_id_time_index.first;
+  }
+}
+
+std::vector<const BidirectionalAStarPathfinder::VisitedStateData *> BidirectionalAStarPathfinder::ParentChain(
+    HexVertexId vertex, Direction *direction) {
+  std::vector<const VisitedStateData *> chain;
+  const VisitedStateData *data = direction->visited.find(AStarVertex::IdTimeIndex(vertex, 0));
+  while (data != nullptr) {
+    chain.push_back(data);
+    data = data->parent.first == kInvalidHexVertexId ? nullptr : direction->visited.find(data->parent);
+  }
+  return chain;
+}
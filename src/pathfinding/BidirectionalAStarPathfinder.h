@@ -0,0 +1,132 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_BIDIRECTIONALASTARPATHFINDER_H_
+#define PATHFINDING_BIDIRECTIONALASTARPATHFINDER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "pathfinding/AStarVertex.h"
+#include "pathfinding/ClosedSet.h"
+#include "pathfinding/OpenSet.h"
+#include "pathfinding/Pathfinder.h"
+
+/**
+ * @brief Bidirectional A* pathfinder for time-independent cost calculators.
+ *
+ * Runs one A* search forward from the start and one backward from the target over reversed edges, always expanding
+ * the side with the smaller open set. Every time a vertex is reached by both searches, the path through it is a
+ * candidate. Both searches use the average of the two heuristics, (heuristic(vertex, target) - heuristic(start,
+ * vertex)) / 2 forward and its opposite backward, which keeps their keys consistent with each other: the search stops
+ * once the keys last expanded in each direction add up to at least the cost of the best candidate, which is then a
+ * lowest cost path. This requires a consistent heuristic (never decreasing by more than an edge's cost along it),
+ * which admissible distance heuristics usually are.
+ *
+ * The two searches usually meet after exploring far fewer states than a single one does, especially with weak
+ * heuristics. Stats::backward_expansions tells how the expansions were split.
+ *
+ * Only usable with time-independent cost calculators (see CostCalculator::is_time_independent()): the backward search
+ * doesn't know when it reaches a vertex, and every vertex is a single state. Edges are reversed through the planet's
+ * neighbour relations, which are symmetric, but edge costs don't need to be.
+ */
+class BidirectionalAStarPathfinder : public Pathfinder {
+ public:
+  /**
+   * See AStarPathfinder::AStarPathfinder, limits other than Limits::max_time are supported.
+   * @throw std::runtime_error If cost_calculator isn't time-independent, use_indirect_neighbours is true but
+   *    cost_calculator doesn't support it, or limits has a max_time.
+   */
+  BidirectionalAStarPathfinder(const HexPlanet &planet,
+                               const Heuristic &heuristic,
+                               const CostCalculator &cost_calculator,
+                               HexVertexId start,
+                               HexVertexId target,
+                               bool use_indirect_neighbours = false,
+                               const Limits &limits = Limits());
+
+  /**
+   * Find the path from start to target.
+   * @throw std::runtime_error The planet's neighbour relations aren't symmetric.
+   * @return The path from start_ to target_, or the best partial path of the forward search if the target is
+   *    unreachable within the limits.
+   */
+  Result Run() override;
+
+ private:
+  struct VisitedStateData {
+    /// The vertex of this state, and the time from the start (forward) or to the target (backward).
+    AStarVertex::IdTimeIndex id_time_index;
+    /// The cost from the start (forward) or to the target (backward).
+    uint32_t cost;
+    /// The open set key (cost + potential) this state was last queued with.
+    uint32_t key;
+    /// The previous state on the path from the start (forward) or the next one on the path to the target (backward).
+    AStarVertex::IdTimeIndex parent;
+    /// The heuristic cost to the target (forward) or from the start (backward).
+    uint32_t h_cost;
+    /// The average of the heuristic costs towards this search's end and from the other one's, added to the cost to
+    /// get the key.
+    int64_t potential;
+  };
+
+  /**
+   * The states of one of the two searches.
+   */
+  struct Direction {
+    Direction(bool forward, size_t vertex_count) : forward(forward), visited(vertex_count, 0) {}
+
+    /// Whether this is the search from the start.
+    bool forward;
+    /// The key of the last expanded state.
+    uint32_t last_key = 0;
+    /// All time steps are one state, so the closed set is indexed by vertex.
+    closed_set::DensePaged<VisitedStateData> visited;
+    open_set::BinaryHeap<VisitedStateData> open_set;
+  };
+
+  /// Whether to use indirect neighbours for pathfinding.
+  bool use_indirect_neighbours_;
+
+  /// Bounds on the search.
+  Limits limits_;
+
+  /// The edges out of the state being expanded forward, reused between expansions.
+  CostCalculator::EdgeResults edge_results_;
+
+  /// The cost of the best path found so far, UINT32_MAX until the searches meet.
+  uint32_t best_cost_;
+  /// The vertex at which the best path found so far joins the two searches.
+  HexVertexId meeting_vertex_;
+
+  /**
+   * Set the heuristic costs of a new state of |direction|, whose id_time_index is set.
+   */
+  void SetHeuristicCosts(const Direction &direction, VisitedStateData *data) const;
+
+  /**
+   * Add the neighbours of |current| to |direction|, along the edges out of it (forward) or into it (backward).
+   */
+  void Expand(Direction *direction, Direction *other, const VisitedStateData &current);
+
+  /**
+   * If the expansion provides a new lowest cost to a neighbour state, add it to the open set and visited state data,
+   * and check whether that improves the best path through it.
+   * @param direction The search expanding |current_id_time_index|.
+   * @param other The opposite search.
+   * @param current_id_time_index IdTimeIndex of the "current" state.
+   * @param neighbour_id_time_index IdTimeIndex of the "neighbour" state.
+   * @param neighbour_cost The cost between the neighbour state and the start (forward) or target (backward).
+   */
+  void AddNeighbour(Direction *direction,
+                    Direction *other,
+                    const AStarVertex::IdTimeIndex &current_id_time_index,
+                    const AStarVertex::IdTimeIndex &neighbour_id_time_index,
+                    uint32_t neighbour_cost);
+
+  /**
+   * @return The chain of parents from |vertex| to the start (forward) or target (backward), starting with |vertex|.
+   */
+  static std::vector<const VisitedStateData *> ParentChain(HexVertexId vertex, Direction *direction);
+};
+
+#endif  // PATHFINDING_BIDIRECTIONALASTARPATHFINDER_H_
@@ -0,0 +1,143 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_CLOSEDSET_H_
+#define PATHFINDING_CLOSEDSET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include "pathfinding/AStarVertex.h"
+
+/**
+ * Storage for the search states (vertex & time) visited by the A* pathfinder.
+ *
+ * Closed sets map an AStarVertex::IdTimeIndex to an Entry, which stays at a fixed address once inserted so that open
+ * sets can refer to it. They share the same interface:
+ *  - find(id_time_index): the entry of a state, or nullptr,
+ *  - insert(id_time_index, entry): add a state that isn't in the set yet and return its stored entry,
+ *  - size(): the number of states in the set,
+ *  - memory_usage(): the (estimated) memory used by the set in bytes.
+ */
+namespace closed_set {
+
+/**
+ * Hash map backed closed set, usable for any time range.
+ */
+template<typename Entry>
+class HashMap {
+ public:
+  /**
+   * @param reserve_size The number of states to reserve space for.
+   */
+  explicit HashMap(size_t reserve_size = 0) {
+    if (reserve_size > 0) {
+      map_.reserve(reserve_size);
+    }
+  }
+
+  Entry *find(const AStarVertex::IdTimeIndex &id_time_index) {
+    auto it = map_.find(id_time_index);
+    return it == map_.end() ? nullptr : &it->second;
+  }
+
+  Entry &insert(const AStarVertex::IdTimeIndex &id_time_index, const Entry &entry) {
+    return map_.emplace(id_time_index, entry).first->second;
+  }
+
+  size_t size() const { return map_.size(); }
+
+  /**
+   * @return An estimate of the memory used by the nodes and buckets in bytes.
+   */
+  size_t memory_usage() const {
+    // Each node holds the value and a next pointer, each bucket a pointer.
+    return map_.size() * (sizeof(typename decltype(map_)::value_type) + sizeof(void *)) +
+        map_.bucket_count() * sizeof(void *);
+  }
+
+ private:
+  /// Node based, so entries never move.
+  boost::unordered_map<AStarVertex::IdTimeIndex, Entry> map_;
+};
+
+/**
+ * Array backed closed set for searches in which all time steps from |time_horizon| on are equivalent.
+ *
+ * States are stored at index vertex * (time_horizon + 1) + min(time, time_horizon), so lookups are O(1) without any
+ * hashing. The index space is split into fixed size pages which are only allocated once a state in them is visited,
+ * which keeps memory proportional to the explored region of the planet.
+ *
+ * Entry must have a `uint32_t cost` member; kEmptyCost marks unused slots.
+ */
+template<typename Entry>
+class DensePaged {
+ public:
+  /// Cost of unused slots.
+  static constexpr uint32_t kEmptyCost = UINT32_MAX;
+  /// The number of states per page.
+  static constexpr size_t kPageSize = 4096;
+
+  /**
+   * @param vertex_count The number of vertices of the planet.
+   * @param time_horizon The first time step from which all time steps are equivalent.
+   */
+  DensePaged(size_t vertex_count, uint32_t time_horizon)
+      : time_horizon_(time_horizon),
+        pages_((vertex_count * (static_cast<size_t>(time_horizon) + 1) + kPageSize - 1) / kPageSize) {}
+
+  Entry *find(const AStarVertex::IdTimeIndex &id_time_index) {
+    const size_t index = Index(id_time_index);
+    const std::unique_ptr<Entry[]> &page = pages_[index / kPageSize];
+    if (!page) {
+      return nullptr;
+    }
+    Entry &entry = page[index % kPageSize];
+    return entry.cost == kEmptyCost ? nullptr : &entry;
+  }
+
+  Entry &insert(const AStarVertex::IdTimeIndex &id_time_index, const Entry &entry) {
+    const size_t index = Index(id_time_index);
+    std::unique_ptr<Entry[]> &page = pages_[index / kPageSize];
+    if (!page) {
+      page.reset(new Entry[kPageSize]);
+      allocated_pages_++;
+      for (size_t i = 0; i < kPageSize; i++) {
+        page[i].cost = kEmptyCost;
+      }
+    }
+    Entry &stored = page[index % kPageSize];
+    stored = entry;
+    size_++;
+    return stored;
+  }
+
+  size_t size() const { return size_; }
+
+  /**
+   * @return The memory used by the allocated pages and the page table in bytes.
+   */
+  size_t memory_usage() const {
+    return allocated_pages_ * kPageSize * sizeof(Entry) + pages_.size() * sizeof(std::unique_ptr<Entry[]>);
+  }
+
+ private:
+  size_t Index(const AStarVertex::IdTimeIndex &id_time_index) const {
+    return static_cast<size_t>(id_time_index.first) * (static_cast<size_t>(time_horizon_) + 1) +
+        std::min(id_time_index.second, time_horizon_);
+  }
+
+  uint32_t time_horizon_;
+  std::vector<std::unique_ptr<Entry[]>> pages_;
+  size_t allocated_pages_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace closed_set
+
+#endif  // PATHFINDING_CLOSEDSET_H_
@@ -0,0 +1,6 @@
+// Copyright 2022 UBC Sailbot
+
+#include "pathfinding/CostCalculator.h"
+
+constexpr uint32_t CostCalculator::kUnboundedTimeHorizon;
+constexpr uint64_t CostCalculator::kNoFingerprint;
@@ -4,10 +4,17 @@
 #define PATHFINDING_COSTCALCULATOR_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "planet/HexPlanet.h"
 #include "datatypes/HexDefs.h"
 
+/**
+ * Cost calculators compute the cost and duration of edges.
+ *
+ * Note: a cost calculator may be shared by several pathfinders running at once (see BatchPathfinder), so the const
+ * methods must be safe to call concurrently.
+ */
 class CostCalculator {
  public:
   struct Result {
@@ -17,7 +24,30 @@ class CostCalculator {
     uint32_t time;
   };
 
-  explicit CostCalculator(HexPlanet &planet) : planet_(planet) {}
+  /**
+   * The costs and ending time steps of all edges out of a vertex, see calculate_all(). The direct neighbours come
+   * first, in graph().neighbours() order, followed by the indirect neighbours in graph().indirect_neighbours() order.
+   * Reusing an instance across calls avoids reallocating.
+   */
+  struct EdgeResults {
+    std::vector<uint32_t> costs;
+    std::vector<uint32_t> times;
+
+    /**
+     * @param edge_count The number of edges to hold.
+     */
+    void resize(size_t edge_count) {
+      costs.resize(edge_count);
+      times.resize(edge_count);
+    }
+  };
+
+  /// Time horizon of cost calculators whose costs may depend on any time step.
+  static constexpr uint32_t kUnboundedTimeHorizon = UINT32_MAX;
+  /// Fingerprint of cost calculators that can't cheaply identify their inputs.
+  static constexpr uint64_t kNoFingerprint = 0;
+
+  explicit CostCalculator(const HexPlanet &planet) : planet_(planet) {}
 
   /**
    * Calculate the cost to an immediate neighbour of |source|.
@@ -28,11 +58,11 @@ class CostCalculator {
    * @return The cost and ending time step for an edge.
    */
   virtual Result calculate_neighbour(HexVertexId source, size_t neighbour, uint32_t start_time) const {
-    const HexVertex &source_vertex = planet_.vertex(source);
-    if (neighbour >= source_vertex.neighbour_count) {
+    const HexGraph::Span<HexVertexId> neighbours = planet_.graph().neighbours(source);
+    if (neighbour >= neighbours.size()) {
       throw std::runtime_error("Calculating cost to invalid neighbour");
     }
-    HexVertexId target = source_vertex.neighbours[neighbour];
+    HexVertexId target = neighbours[neighbour];
     return calculate_target(source, target, start_time);
   }
 
@@ -44,13 +74,64 @@ class CostCalculator {
    */
   virtual Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const = 0;
 
+  /**
+   * Calculate the costs to all direct neighbours of |source| and, if |include_indirect|, all its indirect neighbours
+   * at once. The results are the same as those of calculate_neighbour() and calculate_target(), which this calls by
+   * default; cost calculators override it to only look up |source|'s data once and to process the edges in batches.
+   * @param source Source hex vertex ID.
+   * @param start_time Starting time step.
+   * @param include_indirect Whether to include the indirect neighbours.
+   * @param results Output, resized to the number of edges.
+   */
+  virtual void calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                             EdgeResults *results) const {
+    const HexGraph &graph = planet_.graph();
+    const size_t neighbour_count = graph.neighbour_count(source);
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+    results->resize(neighbour_count + (include_indirect ? indirect_neighbours.size() : 0));
+
+    for (size_t i = 0; i < neighbour_count; i++) {
+      const Result result = calculate_neighbour(source, i, start_time);
+      results->costs[i] = result.cost;
+      results->times[i] = result.time;
+    }
+    if (include_indirect) {
+      for (size_t i = 0; i < indirect_neighbours.size(); i++) {
+        const Result result = calculate_target(source, indirect_neighbours[i], start_time);
+        results->costs[neighbour_count + i] = result.cost;
+        results->times[neighbour_count + i] = result.time;
+      }
+    }
+  }
+
   /**
    * @return Whether this cost calculator is safe for usage with indirect neighbours.
    */
   virtual bool is_indirect_neighbour_safe() const { return false; }
 
+  /**
+   * The first time step from which costs no longer depend on the time, i.e. calculating a cost from any start time
+   * t >= time_horizon() gives the same cost as from time_horizon() (the ending time is still relative to t).
+   * Pathfinders use this to treat all such time steps as one state.
+   * @return The time horizon, or kUnboundedTimeHorizon if costs may depend on any time step.
+   */
+  virtual uint32_t time_horizon() const { return kUnboundedTimeHorizon; }
+
+  /**
+   * A hash of everything the costs depend on besides the planet (e.g. the weather), computed without calculating any
+   * cost. Data derived from the costs (e.g. landmark tables) can be cached under it.
+   * @return The fingerprint, or kNoFingerprint if the cost calculator doesn't provide one.
+   */
+  virtual uint64_t fingerprint() const { return kNoFingerprint; }
+
+  /**
+   * @return Whether costs and durations don't depend on the time at all (a time horizon of 0), which allows
+   *    searching backwards from the target (see BidirectionalAStarPathfinder).
+   */
+  bool is_time_independent() const { return time_horizon() == 0; }
+
  protected:
-  HexPlanet &planet_;
+  const HexPlanet &planet_;
 };
 
 #endif  // PATHFINDING_COSTCALCULATOR_H_
@@ -4,23 +4,9 @@
 
 #include <logic/StandardCalc.h>
 
-HaversineCostCalculator::HaversineCostCalculator(HexPlanet &planet) : CostCalculator(planet) {}
-
-CostCalculator::Result HaversineCostCalculator::calculate_neighbour(HexVertexId source,
-                                                                    size_t neighbour,
-                                                                    uint32_t start_time) const {
-  const HexVertex &source_vertex = planet_.vertex(source);
-  if (neighbour >= source_vertex.neighbour_count) {
-    throw std::runtime_error("Calculating distance to invalid neighbour");
-  }
-
-  uint32_t distance = source_vertex.neighbour_distances[neighbour];
-
-  // TODO(areksredzki): Use better logic for handling time steps.
-  uint32_t end_time = start_time + 1;
+#include <algorithm>
 
-  return {distance, end_time};
-}
+HaversineCostCalculator::HaversineCostCalculator(const HexPlanet &planet) : CostCalculator(planet) {}
 
 CostCalculator::Result HaversineCostCalculator::calculate_target(HexVertexId source,
                                                                  HexVertexId target,
@@ -37,3 +23,21 @@ CostCalculator::Result HaversineCostCalculator::calculate_target(HexVertexId sou
 
   return {distance, end_time};
 }
+
+void HaversineCostCalculator::calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                                            EdgeResults *results) const {
+  const HexGraph &graph = planet_.graph();
+  const HexGraph::Span<uint32_t> neighbour_distances = graph.neighbour_distances(source);
+  const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+  const size_t neighbour_count = neighbour_distances.size();
+  results->resize(neighbour_count + (include_indirect ? indirect_neighbours.size() : 0));
+
+  std::copy(neighbour_distances.begin(), neighbour_distances.end(), results->costs.begin());
+  if (include_indirect) {
+    planet_.DistancesFromVertex(source, indirect_neighbours.begin(), indirect_neighbours.size(),
+                                results->costs.data() + neighbour_count);
+  }
+
+  // TODO(areksredzki): Use better logic for handling time steps.
+  std::fill(results->times.begin(), results->times.end(), start_time + 1);
+}
@@ -3,11 +3,13 @@
 #ifndef PATHFINDING_HAVERSINECOSTCALCULATOR_H_
 #define PATHFINDING_HAVERSINECOSTCALCULATOR_H_
 
+#include <stdexcept>
+
 #include "pathfinding/CostCalculator.h"
 
 class HaversineCostCalculator : public CostCalculator {
  public:
-  explicit HaversineCostCalculator(HexPlanet &planet);
+  explicit HaversineCostCalculator(const HexPlanet &planet);
 
   /**
    * Calculate the cost to an immediate neighbour of |source| using the Haversine formula.
@@ -17,7 +19,15 @@ class HaversineCostCalculator : public CostCalculator {
    * @throw std::runtime_error |neighbour| is invalid.
    * @return The cost and ending time step for an edge.
    */
-  Result calculate_neighbour(HexVertexId source, size_t neighbour, uint32_t start_time) const override;
+  Result calculate_neighbour(HexVertexId source, size_t neighbour, uint32_t start_time) const override {
+    const HexGraph::Span<uint32_t> neighbour_distances = planet_.graph().neighbour_distances(source);
+    if (neighbour >= neighbour_distances.size()) {
+      throw std::runtime_error("Calculating distance to invalid neighbour");
+    }
+
+    // TODO(areksredzki): Use better logic for handling time steps.
+    return {neighbour_distances[neighbour], start_time + 1};
+  }
 
   /**
    * Computes the a distance between two points using the Haversine formula.
@@ -31,10 +41,21 @@ class HaversineCostCalculator : public CostCalculator {
    */
   Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override;
 
+  /**
+   * Calculate the distances to all neighbours of |source| at once, see CostCalculator::calculate_all().
+   */
+  void calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                     EdgeResults *results) const override;
+
   /**
    * @return Whether this cost calculator is safe for usage with indirect neighbours.
    */
   bool is_indirect_neighbour_safe() const override { return true; }
+
+  /**
+   * @return 0, distances don't depend on the time.
+   */
+  uint32_t time_horizon() const override { return 0; }
 };
 
 #endif  // PATHFINDING_HAVERSINECOSTCALCULATOR_H_
@@ -4,8 +4,7 @@
 
 #include <logic/StandardCalc.h>
 
-HaversineHeuristic::HaversineHeuristic(HexPlanet &planet) : Heuristic(planet) {}
+HaversineHeuristic::HaversineHeuristic(const HexPlanet &planet) : Heuristic(planet) {}
 
-uint32_t HaversineHeuristic::calculate(HexVertexId source, HexVertexId target) const {
-  return planet_.DistanceBetweenVertices(source, target);
-}
+HaversineHeuristic::HaversineHeuristic(const HexPlanet &planet, HexVertexId target, unsigned thread_count)
+    : Heuristic(planet), table_target_(target), target_distances_(planet.DistancesToVertex(target, thread_count)) {}
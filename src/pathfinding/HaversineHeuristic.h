@@ -3,11 +3,22 @@
 #ifndef PATHFINDING_HAVERSINEHEURISTIC_H_
 #define PATHFINDING_HAVERSINEHEURISTIC_H_
 
+#include <vector>
+
 #include "pathfinding/Heuristic.h"
 
 class HaversineHeuristic: public Heuristic {
  public:
-  explicit HaversineHeuristic(HexPlanet &planet);
+  explicit HaversineHeuristic(const HexPlanet &planet);
+
+  /**
+   * Create a heuristic with the distances from every vertex to |target| precomputed, which turns calculate() into a
+   * table lookup for that target. Costs 4 bytes per vertex.
+   * @param planet The planet used for heuristic calculations.
+   * @param target The target vertex of the query.
+   * @param thread_count The number of threads used to fill the table. 0 for one per hardware thread.
+   */
+  HaversineHeuristic(const HexPlanet &planet, HexVertexId target, unsigned thread_count = 0);
 
   /**
    * Computes the a distance heuristic between two points using the Haversine formula.
@@ -15,7 +26,18 @@ class HaversineHeuristic: public Heuristic {
    * @param target Target vertex ID.
    * @return Distance in meters
    */
-  uint32_t calculate(HexVertexId source, HexVertexId target) const override;
+  uint32_t calculate(HexVertexId source, HexVertexId target) const override {
+    if (target == table_target_) {
+      return target_distances_[source];
+    }
+    return planet_.DistanceBetweenVertices(source, target);
+  }
+
+ private:
+  /// The target of target_distances_, kInvalidHexVertexId if there is no table.
+  HexVertexId table_target_ = kInvalidHexVertexId;
+  /// Distance from each vertex to table_target_.
+  std::vector<uint32_t> target_distances_;
 };
 
 #endif  // PATHFINDING_HAVERSINEHEURISTIC_H_
@@ -15,7 +15,7 @@
  */
 class Heuristic {
  public:
-  explicit Heuristic(HexPlanet &planet) : planet_(planet) {}
+  explicit Heuristic(const HexPlanet &planet) : planet_(planet) {}
 
   /**
    * @param source Source vertex id
@@ -25,7 +25,7 @@ class Heuristic {
   virtual uint32_t calculate(HexVertexId source, HexVertexId target) const = 0;
 
  protected:
-  HexPlanet &planet_;
+  const HexPlanet &planet_;
 };
 
 #endif  // PATHFINDING_HEURISTIC_H_
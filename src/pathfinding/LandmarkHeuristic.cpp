@@ -0,0 +1,300 @@
+// Copyright 2022 UBC Sailbot
+
+#include "pathfinding/LandmarkHeuristic.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "common/Fnv1aHash.h"
+#include "common/ParallelFor.h"
+#include "pathfinding/LandmarkTableFormat.h"
+
+constexpr uint32_t LandmarkHeuristic::kUnreachable;
+
+namespace {
+
+/**
+ * Run Dijkstra's algorithm from |source| over |edge_costs| (the surface's out_costs_ to get the costs from |source|,
+ * its in_costs_ to get the costs to it), writing the cost of each vertex to every |stride|th element of |table|.
+ */
+void FillTable(const HexGraph &graph, bool use_indirect_neighbours, const std::vector<uint64_t> &edge_offsets,
+               const std::vector<uint32_t> &edge_costs, HexVertexId source, uint32_t *table, size_t stride) {
+  using QueueItem = std::pair<uint64_t, HexVertexId>;
+  constexpr uint64_t kUnvisited = UINT64_MAX;
+
+  std::vector<uint64_t> costs(graph.vertex_count(), kUnvisited);
+  std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+  costs[source] = 0;
+  queue.emplace(0, source);
+
+  while (!queue.empty()) {
+    const QueueItem item = queue.top();
+    queue.pop();
+    const HexVertexId vertex = item.second;
+    if (item.first != costs[vertex]) {
+      continue;
+    }
+
+    const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(vertex);
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(vertex);
+    const size_t edge_count = neighbours.size() + (use_indirect_neighbours ? indirect_neighbours.size() : 0);
+    const uint32_t *vertex_edge_costs = edge_costs.data() + edge_offsets[vertex];
+    for (size_t i = 0; i < edge_count; i++) {
+      const HexVertexId neighbour = i < neighbours.size() ? neighbours[i] : indirect_neighbours[i - neighbours.size()];
+      const uint64_t cost = item.first + vertex_edge_costs[i];
+      if (cost < costs[neighbour]) {
+        costs[neighbour] = cost;
+        queue.emplace(cost, neighbour);
+      }
+    }
+  }
+
+  for (size_t vertex = 0; vertex < costs.size(); vertex++) {
+    table[vertex * stride] =
+        static_cast<uint32_t>(std::min<uint64_t>(costs[vertex], LandmarkHeuristic::kUnreachable));
+  }
+}
+
+}  // namespace
+
+LandmarkHeuristic::CostSurface::CostSurface(const HexPlanet &planet, const CostCalculator &cost_calculator,
+                                            bool use_indirect_neighbours, unsigned thread_count)
+    : planet_(planet), use_indirect_neighbours_(use_indirect_neighbours) {
+  const uint32_t time_horizon = cost_calculator.time_horizon();
+  if (time_horizon == CostCalculator::kUnboundedTimeHorizon) {
+    throw std::runtime_error("Landmark tables require a cost calculator with a bounded time horizon");
+  }
+  if (use_indirect_neighbours_ && !cost_calculator.is_indirect_neighbour_safe()) {
+    throw std::runtime_error("This cost calculator cannot be safely used with indirect neighbours");
+  }
+
+  const HexGraph &graph = planet_.graph();
+  const size_t vertex_count = graph.vertex_count();
+  edge_offsets_.resize(vertex_count + 1);
+  edge_offsets_[0] = 0;
+  for (HexVertexId vertex = 0; vertex < vertex_count; vertex++) {
+    edge_offsets_[vertex + 1] = edge_offsets_[vertex] + graph.neighbour_count(vertex) +
+        (use_indirect_neighbours_ ? graph.indirect_neighbours(vertex).size() : 0);
+  }
+  out_costs_.resize(edge_offsets_.back());
+  in_costs_.resize(edge_offsets_.back());
+
+  // Costs from any start time past the horizon are the same as from the horizon.
+  parallel::ForRange(vertex_count, thread_count, [&](size_t begin, size_t end) {
+    CostCalculator::EdgeResults results;
+    for (size_t vertex = begin; vertex < end; vertex++) {
+      uint32_t *costs = out_costs_.data() + edge_offsets_[vertex];
+      const size_t edge_count = edge_offsets_[vertex + 1] - edge_offsets_[vertex];
+      std::fill(costs, costs + edge_count, UINT32_MAX);
+      for (uint32_t time = 0; time <= time_horizon; time++) {
+        cost_calculator.calculate_all(static_cast<HexVertexId>(vertex), time, use_indirect_neighbours_, &results);
+        for (size_t i = 0; i < edge_count; i++) {
+          costs[i] = std::min(costs[i], results.costs[i]);
+        }
+      }
+    }
+  });
+
+  // The cost into a vertex is that of the reverse edge out of its neighbour, found in the neighbour's edges. Only
+  // indirect neighbour relations that aren't symmetric need another calculation.
+  parallel::ForRange(vertex_count, thread_count, [&](size_t begin, size_t end) {
+    for (size_t vertex = begin; vertex < end; vertex++) {
+      const HexVertexId vertex_id = static_cast<HexVertexId>(vertex);
+      const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(vertex_id);
+      const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(vertex_id);
+      uint32_t *costs = in_costs_.data() + edge_offsets_[vertex];
+      const size_t edge_count = edge_offsets_[vertex + 1] - edge_offsets_[vertex];
+      for (size_t i = 0; i < edge_count; i++) {
+        const bool indirect = i >= neighbours.size();
+        const HexVertexId neighbour = indirect ? indirect_neighbours[i - neighbours.size()] : neighbours[i];
+        const HexGraph::Span<HexVertexId> reverse_edges =
+            indirect ? graph.indirect_neighbours(neighbour) : graph.neighbours(neighbour);
+        const auto reverse_edge = std::find(reverse_edges.begin(), reverse_edges.end(), vertex_id);
+        if (reverse_edge != reverse_edges.end()) {
+          const size_t reverse_index = static_cast<size_t>(reverse_edge - reverse_edges.begin()) +
+              (indirect ? graph.neighbour_count(neighbour) : 0);
+          costs[i] = out_costs_[edge_offsets_[neighbour] + reverse_index];
+          continue;
+        }
+
+        costs[i] = UINT32_MAX;
+        for (uint32_t time = 0; time <= time_horizon; time++) {
+          costs[i] = std::min(costs[i], cost_calculator.calculate_target(neighbour, vertex_id, time).cost);
+        }
+      }
+    }
+  });
+
+  // Without a fingerprint of the cost calculator's inputs, the edge set and costs identify the surface
+  fingerprint_ = Fingerprint(planet_, cost_calculator, use_indirect_neighbours_);
+  if (fingerprint_ == CostCalculator::kNoFingerprint) {
+    Fnv1aHash hash;
+    hash.add(planet_.vertex_count());
+    hash.add(use_indirect_neighbours_ ? 1 : 0);
+    hash.add(out_costs_.size());
+    for (uint32_t cost : out_costs_) {
+      hash.add(cost);
+    }
+    fingerprint_ = hash.value();
+  }
+}
+
+uint64_t LandmarkHeuristic::CostSurface::Fingerprint(const HexPlanet &planet, const CostCalculator &cost_calculator,
+                                                     bool use_indirect_neighbours) {
+  const uint64_t costs_fingerprint = cost_calculator.fingerprint();
+  if (costs_fingerprint == CostCalculator::kNoFingerprint) {
+    return CostCalculator::kNoFingerprint;
+  }
+  Fnv1aHash hash;
+  hash.add(planet.vertex_count());
+  hash.add(use_indirect_neighbours ? 1 : 0);
+  hash.add(costs_fingerprint);
+  return hash.value();
+}
+
+LandmarkHeuristic::LandmarkHeuristic(const HexPlanet &planet, const CostSurface &surface,
+                                     const std::vector<HexVertexId> &landmarks, unsigned thread_count)
+    : Heuristic(planet),
+      landmarks_(landmarks),
+      surface_fingerprint_(surface.fingerprint()),
+      owned_from_distances_(planet.vertex_count() * landmarks.size()),
+      owned_to_distances_(planet.vertex_count() * landmarks.size()) {
+  const HexGraph &graph = planet_.graph();
+  const size_t count = landmarks_.size();
+
+  // Each search fills one column of a table
+  parallel::ForDynamic(2 * count, thread_count, [&](size_t search) {
+    const size_t landmark = search / 2;
+    const bool from_landmark = search % 2 == 0;
+    FillTable(graph, surface.use_indirect_neighbours_, surface.edge_offsets_,
+              from_landmark ? surface.out_costs_ : surface.in_costs_, landmarks_[landmark],
+              (from_landmark ? owned_from_distances_.data() : owned_to_distances_.data()) + landmark, count);
+  });
+
+  from_distances_ = owned_from_distances_.data();
+  to_distances_ = owned_to_distances_.data();
+}
+
+LandmarkHeuristic::LandmarkHeuristic(const HexPlanet &planet, const std::string &filename,
+                                     uint64_t surface_fingerprint)
+    : Heuristic(planet), surface_fingerprint_(surface_fingerprint), file_(new MappedFile(filename)) {
+  const landmark_table_format::Header &header = *file_->at<landmark_table_format::Header>(0, 1);
+  if (!landmark_table_format::IsValidHeader(header)) {
+    throw std::runtime_error("Not a landmark table file (or unsupported version): " + filename);
+  }
+  if (header.vertex_count != planet_.vertex_count()) {
+    throw std::runtime_error("Landmark tables " + filename + " don't match the planet");
+  }
+  if (header.surface_fingerprint != surface_fingerprint) {
+    throw std::runtime_error("Landmark tables " + filename + " were computed on other costs");
+  }
+
+  const HexVertexId *landmarks = file_->at<HexVertexId>(header.landmarks_offset, header.landmark_count);
+  landmarks_.assign(landmarks, landmarks + header.landmark_count);
+  const uint64_t table_size = header.vertex_count * header.landmark_count;
+  from_distances_ = file_->at<uint32_t>(header.from_distances_offset, table_size);
+  to_distances_ = file_->at<uint32_t>(header.to_distances_offset, table_size);
+}
+
+void LandmarkHeuristic::WriteToFile(const std::string &filename) const {
+  using landmark_table_format::Align;
+  const uint64_t table_size = planet_.vertex_count() * landmarks_.size();
+
+  landmark_table_format::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, landmark_table_format::kMagic, sizeof(header.magic));
+  header.version = landmark_table_format::kVersion;
+  header.landmark_count = static_cast<uint32_t>(landmarks_.size());
+  header.vertex_count = planet_.vertex_count();
+  header.surface_fingerprint = surface_fingerprint_;
+
+  uint64_t offset = Align(sizeof(header));
+  auto place = [&offset](uint64_t bytes) {
+    uint64_t placed = offset;
+    offset = Align(offset + bytes);
+    return placed;
+  };
+  header.landmarks_offset = place(landmarks_.size() * sizeof(HexVertexId));
+  header.from_distances_offset = place(table_size * sizeof(uint32_t));
+  header.to_distances_offset = place(table_size * sizeof(uint32_t));
+
+  std::ofstream os(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os) {
+    throw std::runtime_error("Unable to open " + filename + " for writing");
+  }
+
+  // Write the header and each array, padding up to the next offset
+  uint64_t written = 0;
+  auto write_at = [&os, &written](uint64_t at, const void *data, uint64_t bytes) {
+    static const char kPadding[landmark_table_format::kAlignment] = {0};
+    while (written < at) {
+      uint64_t padding = std::min<uint64_t>(at - written, sizeof(kPadding));
+      os.write(kPadding, padding);
+      written += padding;
+    }
+    os.write(static_cast<const char *>(data), bytes);
+    written += bytes;
+  };
+  write_at(0, &header, sizeof(header));
+  write_at(header.landmarks_offset, landmarks_.data(), landmarks_.size() * sizeof(HexVertexId));
+  write_at(header.from_distances_offset, from_distances_, table_size * sizeof(uint32_t));
+  write_at(header.to_distances_offset, to_distances_, table_size * sizeof(uint32_t));
+
+  if (!os) {
+    throw std::runtime_error("Failed to write " + filename);
+  }
+}
+
+bool LandmarkHeuristic::IsLandmarkFile(const std::string &filename) {
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  landmark_table_format::Header header;
+  if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+  return landmark_table_format::IsValidHeader(header);
+}
+
+std::vector<HexVertexId> LandmarkHeuristic::SelectLandmarks(const HexPlanet &planet, size_t count,
+                                                            const std::vector<HexVertexId> &candidates,
+                                                            unsigned thread_count) {
+  std::vector<HexVertexId> all_vertices;
+  if (candidates.empty()) {
+    all_vertices.resize(planet.vertex_count());
+    for (HexVertexId vertex = 0; vertex < all_vertices.size(); vertex++) {
+      all_vertices[vertex] = vertex;
+    }
+  }
+  const std::vector<HexVertexId> &pool = candidates.empty() ? all_vertices : candidates;
+  count = std::min(count, pool.size());
+
+  // The distance from each candidate to the closest landmark, or to the first candidate before there are any.
+  std::vector<uint32_t> min_distances(pool.size(), UINT32_MAX);
+  auto update_min_distances = [&](HexVertexId vertex) {
+    const std::vector<uint32_t> distances = planet.DistancesToVertex(vertex, thread_count);
+    for (size_t i = 0; i < pool.size(); i++) {
+      min_distances[i] = std::min(min_distances[i], distances[pool[i]]);
+    }
+  };
+  auto farthest = [&]() {
+    return pool[std::max_element(min_distances.begin(), min_distances.end()) - min_distances.begin()];
+  };
+
+  std::vector<HexVertexId> landmarks;
+  if (count == 0) {
+    return landmarks;
+  }
+  update_min_distances(pool.front());
+  HexVertexId next = farthest();
+  std::fill(min_distances.begin(), min_distances.end(), UINT32_MAX);
+  while (landmarks.size() < count) {
+    landmarks.push_back(next);
+    update_min_distances(next);
+    next = farthest();
+  }
+  return landmarks;
+}
@@ -0,0 +1,179 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_LANDMARKHEURISTIC_H_
+#define PATHFINDING_LANDMARKHEURISTIC_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/MappedFile.h"
+#include "pathfinding/CostCalculator.h"
+#include "pathfinding/Heuristic.h"
+
+/**
+ * @brief Landmark (ALT) heuristic: lower bounds from precomputed costs to and from a few landmark vertices.
+ *
+ * For every landmark L, the lowest costs from L to each vertex and from each vertex to L are computed once on a cost
+ * surface. By the triangle inequality, the cost from v to t is at least cost(L, t) - cost(L, v) and
+ * cost(v, L) - cost(t, L), and the heuristic is the largest of these bounds over all landmarks. Unlike
+ * HaversineHeuristic, this accounts for the weather and risk costs, so A* explores far fewer states when those
+ * dominate the distance. The heuristic is consistent, so it's also usable by BidirectionalAStarPathfinder.
+ *
+ * The tables take 8 bytes per vertex and landmark. They can be written to a file and memory-mapped back, which is
+ * much faster than computing them again. Loading them only needs CostSurface::Fingerprint(), not the surface.
+ */
+class LandmarkHeuristic : public Heuristic {
+ public:
+  /// Table entry of vertices that can't reach (or be reached from) a landmark, or too far for a uint32_t cost.
+  static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+  /**
+   * The static cost surface the landmark tables are computed on: the lowest cost of every edge over all time steps
+   * of a cost calculator. Costs on it never exceed those of the cost calculator at any time, so the heuristic is
+   * admissible for time-dependent costs too, if weaker.
+   */
+  class CostSurface {
+   public:
+    /**
+     * @param planet The planet.
+     * @param cost_calculator The costs, which must have a bounded time horizon.
+     * @param use_indirect_neighbours Whether to include the indirect neighbour edges, which must be true if the
+     *    heuristic is used by a search that takes them.
+     * @param thread_count The number of threads used. 0 for one per hardware thread.
+     * @throw std::runtime_error If cost_calculator's time horizon is unbounded, or use_indirect_neighbours is true but
+     *    cost_calculator doesn't support it.
+     */
+    CostSurface(const HexPlanet &planet, const CostCalculator &cost_calculator, bool use_indirect_neighbours,
+                unsigned thread_count = 0);
+
+    /**
+     * The fingerprint of the surface a cost calculator would give, computed without building it.
+     * @param planet The planet.
+     * @param cost_calculator The costs.
+     * @param use_indirect_neighbours Whether the surface would include the indirect neighbour edges.
+     * @return The fingerprint, or CostCalculator::kNoFingerprint if cost_calculator doesn't provide one, in which case
+     *    only the surface itself can tell.
+     */
+    static uint64_t Fingerprint(const HexPlanet &planet, const CostCalculator &cost_calculator,
+                                bool use_indirect_neighbours);
+
+    /**
+     * @return A hash identifying the edge costs, which tells whether stored tables were computed on this surface.
+     *    It's Fingerprint() if the cost calculator provides one, otherwise a hash of the edge costs.
+     */
+    uint64_t fingerprint() const { return fingerprint_; }
+
+   private:
+    friend class LandmarkHeuristic;
+
+    const HexPlanet &planet_;
+    bool use_indirect_neighbours_;
+    /// Index of the first edge of each vertex in the cost arrays, followed by the total edge count.
+    std::vector<uint64_t> edge_offsets_;
+    /// The cost of the edges out of each vertex, to its neighbours then its indirect neighbours (in graph order).
+    std::vector<uint32_t> out_costs_;
+    /// The cost of the edges into each vertex, from the same vertices as out_costs_.
+    std::vector<uint32_t> in_costs_;
+    uint64_t fingerprint_;
+  };
+
+  /**
+   * Compute the landmark tables, running one Dijkstra search per landmark and direction in parallel.
+   * @param planet The planet used for heuristic calculations.
+   * @param surface The cost surface.
+   * @param landmarks The landmark vertices, see SelectLandmarks().
+   * @param thread_count The number of threads used. 0 for one per hardware thread.
+   */
+  LandmarkHeuristic(const HexPlanet &planet, const CostSurface &surface, const std::vector<HexVertexId> &landmarks,
+                    unsigned thread_count = 0);
+
+  /**
+   * Memory-map landmark tables written by WriteToFile().
+   * @param planet The planet used for heuristic calculations.
+   * @param filename Path of the tables.
+   * @param surface_fingerprint The CostSurface::fingerprint() the tables must have been computed with.
+   * @throw std::runtime_error If the file can't be mapped, is malformed, or doesn't match the planet or surface.
+   */
+  LandmarkHeuristic(const HexPlanet &planet, const std::string &filename, uint64_t surface_fingerprint);
+
+  /**
+   * @param source Source vertex ID.
+   * @param target Target vertex ID.
+   * @return The largest landmark lower bound on the cost from source to target.
+   */
+  uint32_t calculate(HexVertexId source, HexVertexId target) const override {
+    const size_t count = landmarks_.size();
+    const uint32_t *from_source = from_distances_ + source * count;
+    const uint32_t *from_target = from_distances_ + target * count;
+    const uint32_t *to_source = to_distances_ + source * count;
+    const uint32_t *to_target = to_distances_ + target * count;
+
+    // Unreachable entries are the largest value, so they never give a (wrong) positive bound.
+    uint32_t bound = 0;
+    for (size_t i = 0; i < count; i++) {
+      if (from_target[i] != kUnreachable && from_target[i] > from_source[i]) {
+        bound = std::max(bound, from_target[i] - from_source[i]);
+      }
+      if (to_source[i] != kUnreachable && to_source[i] > to_target[i]) {
+        bound = std::max(bound, to_source[i] - to_target[i]);
+      }
+    }
+    return bound;
+  }
+
+  /**
+   * Write the tables to |filename| (see landmark_table_format), along with the fingerprint of the surface they were
+   * computed on.
+   * @throw std::runtime_error The file can't be written.
+   */
+  void WriteToFile(const std::string &filename) const;
+
+  /**
+   * @param filename Path of a file.
+   * @return Whether the file holds landmark tables of the current version.
+   */
+  static bool IsLandmarkFile(const std::string &filename);
+
+  /**
+   * Pick landmarks spread over |candidates|: the candidate farthest from the first one, then repeatedly the candidate
+   * farthest from all landmarks picked so far. Landmarks on the edges of the searched area give the best bounds.
+   * @param planet The planet.
+   * @param count The number of landmarks, at most the number of candidates.
+   * @param candidates The vertices landmarks are picked from (e.g. those of the forecast region), all if empty.
+   * @param thread_count The number of threads used. 0 for one per hardware thread.
+   * @return The landmarks.
+   */
+  static std::vector<HexVertexId> SelectLandmarks(const HexPlanet &planet, size_t count,
+                                                  const std::vector<HexVertexId> &candidates = {},
+                                                  unsigned thread_count = 0);
+
+  /**
+   * @return The landmark vertices.
+   */
+  const std::vector<HexVertexId> &landmarks() const { return landmarks_; }
+
+  /**
+   * @return The fingerprint of the cost surface the tables were computed on.
+   */
+  uint64_t surface_fingerprint() const { return surface_fingerprint_; }
+
+ private:
+  std::vector<HexVertexId> landmarks_;
+  uint64_t surface_fingerprint_;
+
+  /// The tables computed by this instance, empty if they're memory-mapped.
+  std::vector<uint32_t> owned_from_distances_;
+  std::vector<uint32_t> owned_to_distances_;
+  /// The mapped file the tables are read from, if any.
+  std::unique_ptr<MappedFile> file_;
+
+  /// The cost from each landmark to each vertex, vertex-major.
+  const uint32_t *from_distances_;
+  /// The cost from each vertex to each landmark, vertex-major.
+  const uint32_t *to_distances_;
+};
+
+#endif  // PATHFINDING_LANDMARKHEURISTIC_H_
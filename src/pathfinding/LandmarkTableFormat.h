@@ -0,0 +1,60 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_LANDMARKTABLEFORMAT_H_
+#define PATHFINDING_LANDMARKTABLEFORMAT_H_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Layout of the binary landmark tables of a LandmarkHeuristic, stored next to the cached planet they belong to.
+ *
+ * The file is a Header followed by flat, 8-byte aligned arrays stored in native (little-endian) byte order, located
+ * through their offsets (in bytes from the start of the file) so that a memory-mapped file can be used directly.
+ * Distance tables are vertex-major: the distances of all landmarks for vertex 0, then for vertex 1, ...
+ */
+namespace landmark_table_format {
+
+/// Identifies a landmark table file.
+constexpr char kMagic[8] = {'L', 'A', 'N', 'D', 'M', 'A', 'R', 'K'};
+
+/// Bumped whenever the layout changes.
+constexpr uint32_t kVersion = 1;
+
+/// Alignment of each array in the file.
+constexpr uint64_t kAlignment = 8;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t landmark_count;
+  uint64_t vertex_count;
+  /// Identifies the cost surface the distances were computed on, see LandmarkHeuristic::CostSurface::fingerprint().
+  uint64_t surface_fingerprint;
+  /// HexVertexId[landmark_count]
+  uint64_t landmarks_offset;
+  /// uint32_t[vertex_count * landmark_count], the cost from each landmark to each vertex.
+  uint64_t from_distances_offset;
+  /// uint32_t[vertex_count * landmark_count], the cost from each vertex to each landmark.
+  uint64_t to_distances_offset;
+};
+
+/**
+ * @param offset Byte offset.
+ * @return |offset| rounded up to kAlignment.
+ */
+inline uint64_t Align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/**
+ * @param header Header read from the start of a file.
+ * @return Whether the header identifies landmark tables of the current version.
+ */
+inline bool IsValidHeader(const Header &header) {
+  return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion;
+}
+
+}  // namespace landmark_table_format
+
+#endif  // PATHFINDING_LANDMARKTABLEFORMAT_H_
@@ -2,7 +2,8 @@
 
 #include "pathfinding/NaiveCostCalculator.h"
 
-NaiveCostCalculator::NaiveCostCalculator(HexPlanet &planet, uint32_t cost) : CostCalculator(planet), cost_(cost) {}
+NaiveCostCalculator::NaiveCostCalculator(const HexPlanet &planet, uint32_t cost)
+    : CostCalculator(planet), cost_(cost) {}
 
 CostCalculator::Result NaiveCostCalculator::calculate_target(HexVertexId, HexVertexId, uint32_t start_time) const {
   return {cost_, start_time + 1};
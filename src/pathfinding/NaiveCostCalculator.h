@@ -11,7 +11,7 @@ class NaiveCostCalculator: public CostCalculator {
    * @param planet The planet used for cost calculations. Note: Not used by this cost calculator.
    * @param cost The cost that will always be returned.
    */
-  explicit NaiveCostCalculator(HexPlanet &planet, uint32_t cost = 1);
+  explicit NaiveCostCalculator(const HexPlanet &planet, uint32_t cost = 1);
 
   /**
    * Note: This cost calculator doesn't actually use the source & target IDs.
@@ -23,6 +23,11 @@ class NaiveCostCalculator: public CostCalculator {
    */
   Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override;
 
+  /**
+   * @return 0, the cost is constant.
+   */
+  uint32_t time_horizon() const override { return 0; }
+
  private:
   uint32_t cost_;
 };
@@ -2,7 +2,7 @@
 
 #include "pathfinding/NaiveHeuristic.h"
 
-NaiveHeuristic::NaiveHeuristic(HexPlanet &planet, uint32_t cost)
+NaiveHeuristic::NaiveHeuristic(const HexPlanet &planet, uint32_t cost)
     : Heuristic(planet), cost_(cost) {}
 
 uint32_t NaiveHeuristic::calculate(HexVertexId source, HexVertexId target) const {
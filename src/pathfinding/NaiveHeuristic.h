@@ -11,7 +11,7 @@ class NaiveHeuristic : public Heuristic {
    * @param planet The planet used for heuristic calculations. Note: Not used by this heuristic.
    * @param cost The cost that will always be returned.
    */
-  explicit NaiveHeuristic(HexPlanet &planet, uint32_t cost = 1);
+  explicit NaiveHeuristic(const HexPlanet &planet, uint32_t cost = 1);
 
   /**
    * Note: This heuristic doesn't actually use the source & target IDs.
@@ -0,0 +1,234 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_OPENSET_H_
+#define PATHFINDING_OPENSET_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+/**
+ * Priority queues used as the open set of the A* pathfinder.
+ *
+ * All open sets hold pointers to search state entries (which must stay at a fixed address while queued) keyed by an
+ * integer priority, and share the same interface:
+ *  - push(entry, key): queue |entry| with |key|, or lower its key if the set supports decrease-key,
+ *  - pop(): remove and return an item with the smallest key,
+ *  - empty(), size(), pushes(), decrease_keys().
+ *
+ * Sets without decrease-key keep the outdated items; pop() returns the key each item was pushed with so that the
+ * caller can recognize and skip stale items.
+ */
+namespace open_set {
+
+/// Value of Entry::open_set_index for entries that aren't in an IndexedHeap.
+constexpr uint32_t kNotQueued = std::numeric_limits<uint32_t>::max();
+
+/**
+ * An item removed from an open set.
+ */
+template<typename Entry>
+struct Item {
+  /// The key the entry was pushed with.
+  uint32_t key;
+  Entry *entry;
+
+  bool operator>(const Item &rhs) const { return key > rhs.key; }
+};
+
+/**
+ * std::priority_queue based binary heap, the open set the pathfinder has always used.
+ * Improved entries are pushed again, leaving stale items in the heap.
+ */
+template<typename Entry>
+class BinaryHeap {
+ public:
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+  size_t pushes() const { return pushes_; }
+  size_t decrease_keys() const { return 0; }
+
+  void push(Entry *entry, uint32_t key) {
+    heap_.push({key, entry});
+    pushes_++;
+  }
+
+  Item<Entry> pop() {
+    Item<Entry> item = heap_.top();
+    heap_.pop();
+    return item;
+  }
+
+ private:
+  std::priority_queue<Item<Entry>, std::vector<Item<Entry>>, std::greater<Item<Entry>>> heap_;
+  size_t pushes_ = 0;
+};
+
+/**
+ * Indexed d-ary min-heap with decrease-key, so every entry is in the heap at most once.
+ * Entry must have a `uint32_t open_set_index` member initialized to kNotQueued, which the heap maintains.
+ * @tparam Arity The number of children of each node.
+ */
+template<typename Entry, size_t Arity = 4>
+class IndexedHeap {
+ public:
+  bool empty() const { return heap_.empty(); }
+  size_t size() const { return heap_.size(); }
+  size_t pushes() const { return pushes_; }
+  size_t decrease_keys() const { return decrease_keys_; }
+
+  void push(Entry *entry, uint32_t key) {
+    size_t index;
+    if (entry->open_set_index == kNotQueued) {
+      index = heap_.size();
+      heap_.push_back({key, entry});
+      pushes_++;
+    } else {
+      index = entry->open_set_index;
+      // The caller only pushes a queued entry again with a lower key.
+      heap_[index].key = key;
+      decrease_keys_++;
+    }
+    SiftUp(index);
+  }
+
+  Item<Entry> pop() {
+    Item<Entry> top = heap_.front();
+    top.entry->open_set_index = kNotQueued;
+
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+      SiftDown(0);
+    }
+    return top;
+  }
+
+ private:
+  void Place(size_t index, const Item<Entry> &item) {
+    heap_[index] = item;
+    item.entry->open_set_index = static_cast<uint32_t>(index);
+  }
+
+  void SiftUp(size_t index) {
+    const Item<Entry> item = heap_[index];
+    while (index > 0) {
+      const size_t parent = (index - 1) / Arity;
+      if (heap_[parent].key <= item.key) {
+        break;
+      }
+      Place(index, heap_[parent]);
+      index = parent;
+    }
+    Place(index, item);
+  }
+
+  void SiftDown(size_t index) {
+    const Item<Entry> item = heap_[index];
+    const size_t count = heap_.size();
+    while (true) {
+      const size_t first_child = index * Arity + 1;
+      if (first_child >= count) {
+        break;
+      }
+      const size_t last_child = std::min(first_child + Arity, count);
+      size_t best_child = first_child;
+      for (size_t child = first_child + 1; child < last_child; child++) {
+        if (heap_[child].key < heap_[best_child].key) {
+          best_child = child;
+        }
+      }
+      if (heap_[best_child].key >= item.key) {
+        break;
+      }
+      Place(index, heap_[best_child]);
+      index = best_child;
+    }
+    Place(index, item);
+  }
+
+  std::vector<Item<Entry>> heap_;
+  size_t pushes_ = 0;
+  size_t decrease_keys_ = 0;
+};
+
+/**
+ * Radix heap: a monotone priority queue for integer keys with amortized O(log C) operations.
+ * Items are bucketed by the highest bit in which their key differs from the last popped key, so pushing is O(1) and
+ * each item is moved to a lower bucket at most 32 times.
+ *
+ * Keys are expected to never be lower than the last popped key, which holds for consistent heuristics. Lower keys
+ * (from an inconsistent heuristic) are treated as equal to the last popped key, i.e. popped next.
+ * Like BinaryHeap, improved entries are pushed again.
+ */
+template<typename Entry>
+class RadixHeap {
+ public:
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+  size_t pushes() const { return pushes_; }
+  size_t decrease_keys() const { return 0; }
+
+  void push(Entry *entry, uint32_t key) {
+    buckets_[BucketIndex(key)].push_back({key, entry});
+    size_++;
+    pushes_++;
+  }
+
+  Item<Entry> pop() {
+    if (buckets_[0].empty()) {
+      // Find the first non-empty bucket and redistribute it around its smallest key.
+      size_t bucket = 1;
+      while (buckets_[bucket].empty()) {
+        bucket++;
+      }
+
+      std::vector<Item<Entry>> items;
+      items.swap(buckets_[bucket]);
+
+      uint32_t new_last = std::numeric_limits<uint32_t>::max();
+      for (const Item<Entry> &item : items) {
+        new_last = std::min(new_last, EffectiveKey(item.key));
+      }
+      last_ = new_last;
+
+      // Every item now differs from last_ only in bits below the old bucket, so it moves to a lower bucket.
+      for (const Item<Entry> &item : items) {
+        buckets_[BucketIndex(item.key)].push_back(item);
+      }
+
+      // Keep the allocation around for later pushes.
+      items.clear();
+      items.swap(buckets_[bucket]);
+    }
+
+    Item<Entry> item = buckets_[0].back();
+    buckets_[0].pop_back();
+    size_--;
+    return item;
+  }
+
+ private:
+  uint32_t EffectiveKey(uint32_t key) const { return std::max(key, last_); }
+
+  size_t BucketIndex(uint32_t key) const {
+    const uint32_t difference = EffectiveKey(key) ^ last_;
+    return difference == 0 ? 0 : 32 - __builtin_clz(difference);
+  }
+
+  /// buckets_[0] holds keys equal to last_, buckets_[i] keys whose highest bit differing from last_ is bit i - 1.
+  std::array<std::vector<Item<Entry>>, 33> buckets_;
+  uint32_t last_ = 0;
+  size_t size_ = 0;
+  size_t pushes_ = 0;
+};
+
+}  // namespace open_set
+
+#endif  // PATHFINDING_OPENSET_H_
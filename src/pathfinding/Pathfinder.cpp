@@ -2,7 +2,7 @@
 
 #include "Pathfinder.h"
 
-Pathfinder::Pathfinder(HexPlanet &planet,
+Pathfinder::Pathfinder(const HexPlanet &planet,
                        const Heuristic &heuristic,
                        const CostCalculator &cost_calculator,
                        HexVertexId start,
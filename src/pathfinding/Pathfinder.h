@@ -3,6 +3,8 @@
 #ifndef PATHFINDING_PATHFINDER_H_
 #define PATHFINDING_PATHFINDER_H_
 
+#include <chrono>
+#include <limits>
 #include <vector>
 
 #include "planet/HexPlanet.h"
@@ -11,13 +13,47 @@
 
 class Pathfinder {
  public:
+  /**
+   * How a pathfinder run ended.
+   */
+  enum class Status {
+    /// The path leads to the target.
+    kFound,
+    /// Every reachable state within the time limit was explored without reaching the target.
+    kUnreachable,
+    /// The maximum number of state expansions was reached.
+    kExpansionLimitExceeded,
+    /// The maximum wall clock time was reached.
+    kTimeLimitExceeded,
+    /// The maximum memory of the open and closed sets was reached.
+    kMemoryLimitExceeded
+  };
+
+  /**
+   * Bounds on a single Run(). When one is hit, Run() stops with the matching Result::Status and the best partial path.
+   */
+  struct Limits {
+    /// States later than this time index are not explored. Bounding it makes the state space finite.
+    uint32_t max_time = std::numeric_limits<uint32_t>::max();
+    /// The maximum number of state expansions, 0 for no limit.
+    size_t max_expansions = 0;
+    /// The maximum wall clock time of Run(), 0 for no limit.
+    std::chrono::milliseconds max_duration{0};
+    /// The maximum (estimated) memory of the open and closed sets in bytes, 0 for no limit.
+    size_t max_memory = 0;
+  };
+
   /**
    * The result of a pathfinder run.
+   * If the target wasn't found, path is the best partial path: the one to the explored state closest to the target.
    */
   struct Result {
     std::vector<HexVertexId> path;
     uint32_t cost;
     uint32_t time;
+    Status status = Status::kFound;
+    /// The time step at which each vertex of path is reached.
+    std::vector<uint32_t> times;
   };
 
   /**
@@ -25,9 +61,21 @@ class Pathfinder {
    */
   struct Stats {
     /// The size of the closed set at the end of Run(). This is the number of states (vertex & time) visited.
-    size_t closed_set_size;
+    size_t closed_set_size = 0;
     /// The size of the open set at the end of Run(). This is the number of states (vertex & time) to be visited.
-    size_t open_set_size;
+    size_t open_set_size = 0;
+    /// The number of items added to the open set.
+    size_t pushes = 0;
+    /// The number of items removed from the open set, including stale ones.
+    size_t pops = 0;
+    /// The number of removed items that were outdated by a later push and thus skipped.
+    size_t stale_pops = 0;
+    /// The number of in-place key decreases in the open set (only for open sets supporting decrease-key).
+    size_t decrease_keys = 0;
+    /// The number of states expanded, i.e. non-stale pops.
+    size_t expansions = 0;
+    /// The number of expansions made by the backward search of a bidirectional pathfinder, included in expansions.
+    size_t backward_expansions = 0;
   };
 
   /**
@@ -39,7 +87,7 @@ class Pathfinder {
    * @param start Start vertex id.
    * @param target Target vertex id.
    */
-  Pathfinder(HexPlanet &planet,
+  Pathfinder(const HexPlanet &planet,
              const Heuristic &heuristic,
              const CostCalculator &cost_calculator,
              HexVertexId start,
@@ -58,14 +106,14 @@ class Pathfinder {
   const Stats &stats() const;
 
  protected:
-  HexPlanet &planet_;
+  const HexPlanet &planet_;
   const Heuristic &heuristic_;
   const CostCalculator &cost_calculator_;
 
   const HexVertexId start_;
   const HexVertexId target_;
 
-  Stats stats_ = {0, 0};
+  Stats stats_;
 };
 
 #endif  // PATHFINDING_PATHFINDER_H_
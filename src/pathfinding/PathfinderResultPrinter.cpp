@@ -3,7 +3,6 @@
 #include "pathfinding/PathfinderResultPrinter.h"
 #include "pathfinding/WeatherCostCalculator.h"
 #include "pathfinding/WeatherHexMap.h"
-#include "grib/gribParse.h"
 #include "grib/UrlBuilder.h"
 #include "grib/UrlDownloader.h"
 #include "logic/StandardCalc.h"
@@ -11,16 +10,35 @@
 #include <iomanip>
 #include <fstream>
 #include <string>
-#include <eccodes.h>
 #include <vector>
 
 
+std::string PathfinderResultPrinter::StatusName(Pathfinder::Status status) {
+  switch (status) {
+    case Pathfinder::Status::kFound:
+      return "found";
+    case Pathfinder::Status::kUnreachable:
+      return "unreachable";
+    case Pathfinder::Status::kExpansionLimitExceeded:
+      return "expansion limit exceeded";
+    case Pathfinder::Status::kTimeLimitExceeded:
+      return "time limit exceeded";
+    case Pathfinder::Status::kMemoryLimitExceeded:
+      return "memory limit exceeded";
+  }
+  return "unknown";
+}
+
 std::string PathfinderResultPrinter::PrintDefault(const Pathfinder::Result &result) {
   std::stringstream ss;
   ss << std::fixed << std::setprecision(1)
      << "Cost: " << result.cost << " (distance in meters)" << std::endl
      << "Time: " << result.time << std::endl;
 
+  if (result.status != Pathfinder::Status::kFound) {
+    ss << "Target not reached (" << StatusName(result.status) << "), partial path to the closest vertex" << std::endl;
+  }
+
   ss << "Path: " << std::endl;
   for (auto point : result.path) {
     ss << point << " ";
@@ -30,7 +48,7 @@ std::string PathfinderResultPrinter::PrintDefault(const Pathfinder::Result &resu
   return ss.str();
 }
 
-std::string PathfinderResultPrinter::PrintCoordinates(HexPlanet &planet, const Pathfinder::Result &result) {
+std::string PathfinderResultPrinter::PrintCoordinates(const HexPlanet &planet, const Pathfinder::Result &result) {
   std::stringstream ss;
 
   for (HexVertexId id : result.path) {
@@ -42,7 +60,7 @@ std::string PathfinderResultPrinter::PrintCoordinates(HexPlanet &planet, const P
 }
 
 
-std::vector<std::pair<double, double>> PathfinderResultPrinter::GetVector(HexPlanet &planet,
+std::vector<std::pair<double, double>> PathfinderResultPrinter::GetVector(const HexPlanet &planet,
                                                                           const Pathfinder::Result &result,
                                                                           bool prefixHardcoded) {
   std::vector<std::pair<double, double>> pathResult;
@@ -108,26 +126,20 @@ std::string PathfinderResultPrinter::PrintHardcoded(std::vector<std::pair<double
   return ss.str();
 }
 
-std::string PathfinderResultPrinter::PrintKML(HexPlanet &planet,
+std::string PathfinderResultPrinter::PrintKML(const HexPlanet &planet,
                                               const Pathfinder::Result &result,
                                               int weather_factor,
-                                              const std::string & file_name,
-                                              int time_steps,
-                                              bool use_csvs,
-                                              const std::string & output_csvs_folder,
+                                              const WeatherHexMap &weather,
                                               int pointToPrint,
                                               bool preserveKml,
                                               bool prefixHardcoded) {
   std::ofstream handle;
   std::stringstream ss;
-  int north = 49, south = 21, east = 235, west = 203;
   int countPoints = 0;
   std::string latToPrint, lonToPrint;
 
   std::vector<std::pair<double, double>> pathResult;
 
-  gribParse file = gribParse(file_name, time_steps, use_csvs, output_csvs_folder);
-
   HexVertexId old_id;
 
   handle.exceptions(std::ofstream::failbit | std::ofstream::badbit);
@@ -190,23 +202,9 @@ std::string PathfinderResultPrinter::PrintKML(HexPlanet &planet,
         totalDist += planet.DistanceBetweenVertices(old_id, id);
     }
 
-    int lat, lon;
-    lat = coord.round_to_int_latitude();
-    lon = coord.round_to_int_longitude();
-    lon = lon < 0 ? lon+360 : lon;
-    int gribIndex = (lat-south) * (east-west+1) + (lon-west);
-
-    int time_step;
-    double dist = sqrt(pow(lat-north, 2) + pow(lon-east, 2));
-    if (dist < 2)
-      time_step = 0;
-    else if (dist < 4)
-      time_step = 1;
-    else if (dist < 6)
-      time_step = 2;
-    else
-      time_step = 3;
-    double current_wind = file.magnitudes[time_step][gribIndex];
+    // The weather at the time the path reaches the vertex, as seen by the search
+    const uint32_t time = count < static_cast<int>(result.times.size()) ? result.times[count] : 0;
+    double current_wind = weather.get(WeatherHexMap::Channel::kWindSpeed, id, time);
 
     if (current_wind <= 5) {  // See https://www.desmos.com/calculator/md1byjfsl2
       totalWeatherCost += 17 - current_wind;
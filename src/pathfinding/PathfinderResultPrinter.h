@@ -4,11 +4,18 @@
 #define PATHFINDING_PATHFINDERRESULTPRINTER_H_
 
 #include "pathfinding/Pathfinder.h"
+#include "pathfinding/WeatherHexMap.h"
 #include "datatypes/HexDefs.h"
 #include <vector>
 
 class PathfinderResultPrinter {
  public:
+  /**
+   * @param status Status of a pathfinding result.
+   * @return Human readable name of the status.
+   */
+  static std::string StatusName(Pathfinder::Status status);
+
   /**
    * Produces a verbose output string containing the cost, ending time step and then a space-separated list of vertex
    * ids.
@@ -24,27 +31,27 @@ class PathfinderResultPrinter {
    * @param result Pathfinding result to be printed.
    * @return Generated output string.
    */
-  static std::string PrintCoordinates(HexPlanet &planet, const Pathfinder::Result &result);
+  static std::string PrintCoordinates(const HexPlanet &planet, const Pathfinder::Result &result);
 
   /**
    * Produces a KML formatted line.
    * @param planet Planet corresponding to the result.
    * @param result Pathfinding result to be printed.
    * @param weather_factor Weather factor used for pathfinding.
+   * @param weather The weather used for pathfinding, for the wind statistics along the path.
    * @return Generated KML output string.
    */
-  static std::string PrintKML(HexPlanet &planet,
+  static std::string PrintKML(const HexPlanet &planet,
                               const Pathfinder::Result &result,
                               int weather_factor,
-                              const std::string & file_name,
-                              int time_steps,
-                              bool use_csvs,
-                              const std::string & output_csvs_folder,
+                              const WeatherHexMap &weather,
                               int pointToPrint,
                               bool preserveKml,
                               bool prefixHardcoded);
 
-  static std::vector<std::pair<double, double>> GetVector(HexPlanet &planet, const Pathfinder::Result &result, bool prefixHardcoded);
+  static std::vector<std::pair<double, double>> GetVector(const HexPlanet &planet,
+                                                          const Pathfinder::Result &result,
+                                                          bool prefixHardcoded);
 
   static std::vector<std::pair<double, double>> GetHardcoded(std::string test_name);
 
@@ -6,7 +6,7 @@
 
 #include <logic/StandardCalc.h>
 
-TotalCostCalculator::TotalCostCalculator(HexPlanet &planet) : CostCalculator(planet) {}
+TotalCostCalculator::TotalCostCalculator(const HexPlanet &planet) : CostCalculator(planet) {}
 
 CostCalculator::Result TotalCostCalculator::calculate_neighbour(HexVertexId source,
                                                                     size_t neighbour,
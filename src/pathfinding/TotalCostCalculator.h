@@ -7,7 +7,7 @@
 
 class TotalCostCalculator : public CostCalculator {
  public:
-  explicit TotalCostCalculator(HexPlanet &planet);
+  explicit TotalCostCalculator(const HexPlanet &planet);
 
   /**
    * Calculate the cost to an immediate neighbour of |source| using the Haversine formula.
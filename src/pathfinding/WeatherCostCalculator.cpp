@@ -2,21 +2,35 @@
 
 #include "pathfinding/WeatherCostCalculator.h"
 #include "pathfinding/WeatherHexMap.h"
+#include "common/Fnv1aHash.h"
+#include "common/ParallelFor.h"
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
-WeatherCostCalculator::WeatherCostCalculator(HexPlanet &planet,
+WeatherCostCalculator::WeatherCostCalculator(const HexPlanet &planet,
                                            std::unique_ptr<WeatherHexMap> &map, int weather_factor)
     : HaversineCostCalculator(planet), map_(std::move(map)), weather_factor_(weather_factor) {}
 
 CostCalculator::Result WeatherCostCalculator::calculate_neighbour(HexVertexId source,
                                                                 size_t neighbour,
                                                                 uint32_t start_time) const {
+  if (has_cost_tables_) {
+    const HexGraph &graph = planet_.graph();
+    if (neighbour >= graph.neighbour_count(source)) {
+      throw std::runtime_error("Calculating distance to invalid neighbour");
+    }
+    const size_t edge = graph.neighbour_offset(source) + neighbour;
+    return {neighbour_costs_[cost_table_time(start_time) * graph.neighbour_edge_count() + edge], start_time + 1};
+  }
+
   Result result = HaversineCostCalculator::calculate_neighbour(source, neighbour, start_time);
 
   // Get neighbour vertex ID
   // |neighbour| is valid, else an exception would have been thrown earlier
-  HexVertexId target = planet_.vertex(source).neighbours[neighbour];
+  HexVertexId target = planet_.graph().neighbours(source)[neighbour];
 
   result.cost += weather_factor_ * calculate_map_cost(source, target, start_time);
 
@@ -26,6 +40,17 @@ CostCalculator::Result WeatherCostCalculator::calculate_neighbour(HexVertexId so
 CostCalculator::Result WeatherCostCalculator::calculate_target(HexVertexId source,
                                                              HexVertexId target,
                                                              uint32_t start_time) const {
+  if (has_cost_tables_ && source < planet_.vertex_count()) {
+    const HexGraph &graph = planet_.graph();
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+    const HexVertexId *indirect_neighbour = std::find(indirect_neighbours.begin(), indirect_neighbours.end(), target);
+    if (indirect_neighbour != indirect_neighbours.end()) {
+      const size_t edge = graph.indirect_offset(source) + (indirect_neighbour - indirect_neighbours.begin());
+      return {indirect_costs_[cost_table_time(start_time) * graph.indirect_neighbour_edge_count() + edge],
+              start_time + 1};
+    }
+  }
+
   Result result = HaversineCostCalculator::calculate_target(source, target, start_time);
 
   // std::cout << result.cost << " ";
@@ -37,13 +62,97 @@ CostCalculator::Result WeatherCostCalculator::calculate_target(HexVertexId sourc
   return result;
 }
 
+void WeatherCostCalculator::calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                                          EdgeResults *results) const {
+  const HexGraph &graph = planet_.graph();
+  const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(source);
+
+  if (has_cost_tables_) {
+    const size_t time = cost_table_time(start_time);
+    const size_t indirect_count = include_indirect ? graph.indirect_neighbours(source).size() : 0;
+    results->resize(neighbours.size() + indirect_count);
+    const auto neighbour_costs = neighbour_costs_.begin() + time * graph.neighbour_edge_count() +
+        graph.neighbour_offset(source);
+    std::copy(neighbour_costs, neighbour_costs + neighbours.size(), results->costs.begin());
+    const auto indirect_costs = indirect_costs_.begin() + time * graph.indirect_neighbour_edge_count() +
+        graph.indirect_offset(source);
+    std::copy(indirect_costs, indirect_costs + indirect_count, results->costs.begin() + neighbours.size());
+    std::fill(results->times.begin(), results->times.end(), start_time + 1);
+    return;
+  }
+
+  HaversineCostCalculator::calculate_all(source, start_time, include_indirect, results);
+
+  const double source_mag = map_->get(WeatherHexMap::Channel::kWindSpeed, source, start_time);
+  auto add_map_cost = [&](size_t edge, HexVertexId target) {
+    const double target_mag = map_->get(WeatherHexMap::Channel::kWindSpeed, target, start_time);
+    results->costs[edge] += weather_factor_ * wind_speed_cost((source_mag + target_mag) / 2);
+  };
+
+  for (size_t i = 0; i < neighbours.size(); i++) {
+    add_map_cost(i, neighbours[i]);
+  }
+  if (include_indirect) {
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+    for (size_t i = 0; i < indirect_neighbours.size(); i++) {
+      add_map_cost(neighbours.size() + i, indirect_neighbours[i]);
+    }
+  }
+}
+
+uint32_t WeatherCostCalculator::time_horizon() const {
+  return map_->time_horizon();
+}
+
+uint64_t WeatherCostCalculator::fingerprint() const {
+  Fnv1aHash hash;
+  hash.add(map_->fingerprint());
+  hash.add(static_cast<uint64_t>(weather_factor_));
+  return hash.value();
+}
+
+void WeatherCostCalculator::BuildCostTables(unsigned thread_count) {
+  const HexGraph &graph = planet_.graph();
+  const uint32_t horizon = time_horizon();
+  const size_t neighbour_edge_count = graph.neighbour_edge_count();
+  const size_t indirect_edge_count = graph.indirect_neighbour_edge_count();
+  std::vector<uint32_t> neighbour_costs((static_cast<size_t>(horizon) + 1) * neighbour_edge_count);
+  std::vector<uint32_t> indirect_costs((static_cast<size_t>(horizon) + 1) * indirect_edge_count);
+
+  // Filled through calculate_all(), so the tables must only be used once complete.
+  has_cost_tables_ = false;
+  for (uint32_t time = 0; time <= horizon; time++) {
+    parallel::ForRange(planet_.vertex_count(), thread_count, [&](size_t begin, size_t end) {
+      EdgeResults results;
+      for (size_t vertex = begin; vertex < end; vertex++) {
+        const HexVertexId source = static_cast<HexVertexId>(vertex);
+        calculate_all(source, time, true, &results);
+        const size_t neighbour_count = graph.neighbour_count(source);
+        std::copy(results.costs.begin(), results.costs.begin() + neighbour_count,
+                  neighbour_costs.begin() + time * neighbour_edge_count + graph.neighbour_offset(source));
+        std::copy(results.costs.begin() + neighbour_count, results.costs.end(),
+                  indirect_costs.begin() + time * indirect_edge_count + graph.indirect_offset(source));
+      }
+    });
+  }
+
+  neighbour_costs_ = std::move(neighbour_costs);
+  indirect_costs_ = std::move(indirect_costs);
+  cost_table_horizon_ = horizon;
+  has_cost_tables_ = true;
+}
+
 double WeatherCostCalculator::calculate_map_cost(HexVertexId target,
                                                HexVertexId source,
                                                uint32_t time) const {
-  double target_mag = map_->get_weather(target, time).wind_speed,
-         source_mag = map_->get_weather(source, time).wind_speed,
+  double target_mag = map_->get(WeatherHexMap::Channel::kWindSpeed, target, time),
+         source_mag = map_->get(WeatherHexMap::Channel::kWindSpeed, source, time),
          mag = (source_mag + target_mag)/2;  // Average of this node and the next
 
+  return wind_speed_cost(mag);
+}
+
+double WeatherCostCalculator::wind_speed_cost(double mag) {
   if (mag <= 4) {   // https://www.desmos.com/calculator/s83nzwulue
     return 15;
   } else if (mag <= 7) {
@@ -51,7 +160,7 @@ double WeatherCostCalculator::calculate_map_cost(HexVertexId target,
   } else if (mag <= 12) {
       return 0;
   } else if (mag <= 15) {
-      return (5 / 3) * mag - 20;
+      return 5.0 / 3 * mag - 20;
   } else if (mag <= 22) {
       return 5 * mag - 70;
   }
@@ -3,6 +3,10 @@
 #ifndef PATHFINDING_WEATHERCOSTCALCULATOR_H_
 #define PATHFINDING_WEATHERCOSTCALCULATOR_H_
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 #include "pathfinding/WeatherHexMap.h"
 #include "pathfinding/HaversineCostCalculator.h"
 
@@ -16,7 +20,7 @@ class WeatherCostCalculator : public HaversineCostCalculator {
    * @param map The risk map for the planet.
    * @param weather_factor The weather_factor used to weight weather cost
    */
-  explicit WeatherCostCalculator(HexPlanet &planet, std::unique_ptr<WeatherHexMap> &map, int weather_factor);
+  explicit WeatherCostCalculator(const HexPlanet &planet, std::unique_ptr<WeatherHexMap> &map, int weather_factor);
 
   /**
    * Calculate the cost to an immediate neighbour of |source| using the
@@ -44,6 +48,56 @@ class WeatherCostCalculator : public HaversineCostCalculator {
    */
   Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override;
 
+  /**
+   * Calculate the costs to all neighbours of |source| at once, see CostCalculator::calculate_all(). The wind
+   * of |source| is only looked up once.
+   */
+  void calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                     EdgeResults *results) const override;
+
+  /**
+   * @return The time step of the last weather forecast, later times use the same weather.
+   */
+  uint32_t time_horizon() const override;
+
+  /**
+   * @return A hash of the weather and weather_factor_, which are what the costs depend on.
+   */
+  uint64_t fingerprint() const override;
+
+  /**
+   * @param mag The wind speed along an edge (the average of its ends) in knots.
+   * @return The weather cost of the edge, before weighting by weather_factor_. It is continuous up to 22 knots.
+   */
+  static double wind_speed_cost(double mag);
+
+  /**
+   * Precompute the cost of every direct and indirect edge of the planet for each time step up to time_horizon(), so
+   * that the calculate methods look costs up instead of computing them from the weather. The tables hold the same
+   * integer costs that would be computed. They take 4 bytes per edge and time step (see cost_table_memory_usage()), so
+   * they are worth it for planets and time horizons whose tables fit in memory.
+   * Must not be called while costs are being calculated.
+   * @param thread_count The number of threads used to fill the tables. 0 for one per hardware thread.
+   */
+  void BuildCostTables(unsigned thread_count = 0);
+
+  /**
+   * @return Whether BuildCostTables() was called.
+   */
+  bool has_cost_tables() const { return has_cost_tables_; }
+
+  /**
+   * @return The memory used by the cost tables in bytes, 0 if they weren't built.
+   */
+  size_t cost_table_memory_usage() const {
+    return (neighbour_costs_.capacity() + indirect_costs_.capacity()) * sizeof(uint32_t);
+  }
+
+  /**
+   * @return The weather the costs are based on.
+   */
+  const WeatherHexMap &map() const { return *map_; }
+
   // Class can't be copied
   // WeatherCostCalculator(const WeatherCostCalculator &) = delete;
 
@@ -60,7 +114,22 @@ class WeatherCostCalculator : public HaversineCostCalculator {
 
  private:
   double calculate_map_cost(HexVertexId target, HexVertexId source, uint32_t start_time) const;
+
   std::unique_ptr<WeatherHexMap> map_;
+
+  /// Whether the cost tables are built.
+  bool has_cost_tables_ = false;
+  /// The last time step of the cost tables, later time steps use it.
+  uint32_t cost_table_horizon_ = 0;
+  /// The cost of direct edge i (see HexGraph::neighbour_offset()) at time step t at t * neighbour_edge_count() + i.
+  std::vector<uint32_t> neighbour_costs_;
+  /// The cost of indirect edge i at time step t at t * indirect_neighbour_edge_count() + i.
+  std::vector<uint32_t> indirect_costs_;
+
+  /**
+   * @return The time step of the cost tables used for |start_time|.
+   */
+  size_t cost_table_time(uint32_t start_time) const { return std::min(start_time, cost_table_horizon_); }
 };
 
 #endif  // PATHFINDING_WEATHERCOSTCALCULATOR_H_
@@ -1,11 +1,14 @@
 // Copyright 2017 UBC Sailbot
 
 #include "pathfinding/WeatherHexMap.h"
+#include <common/Fnv1aHash.h>
 #include <logic/StandardCalc.h>
 #include <grib/UrlBuilder.h>
 #include <grib/UrlDownloader.h>
 #include "grib/gribParse.h"
+#include "grib/WeatherSnapshotFormat.h"
 #include <eccodes.h>
+#include <fstream>
 #include <string>
 #include <iostream>
 #include <iomanip>
@@ -13,63 +16,289 @@
 #include <stdlib.h>
 #include <math.h>
 
+constexpr int32_t WeatherHexMap::kOutOfRegion;
 
 WeatherHexMap::WeatherHexMap(const HexPlanet &planet, const uint32_t time_steps,
                              int start_lat, int start_lon, int end_lat, int end_lon,
                              bool generate_new_grib, const std::string & file_name, bool use_csvs,
-                             const std::string & output_csvs_folder, bool preserveKml)
-    : planet_(planet), steps_(time_steps) {
-  weather_data_.resize(boost::extents[planet_.vertex_count()][time_steps]);
+                             const std::string & output_csvs_folder, const WindKmlOptions &wind_kml,
+                             Interpolation interpolation, uint32_t steps_per_forecast)
+    : planet_(planet),
+      steps_(time_steps),
+      interpolation_(interpolation),
+      steps_per_forecast_(std::max(steps_per_forecast, 1u)),
+      stencil_size_(interpolation == Interpolation::kBilinear ? kStencilSize : 1),
+      north_(std::max(start_lat, end_lat)),
+      south_(std::min(start_lat, end_lat)),
+      east_(std::max(start_lon, end_lon)),
+      west_(std::min(start_lon, end_lon)),
+      tiles_(new std::atomic<const Stencil *>[(planet.vertex_count() + kTileSize - 1) / kTileSize]),
+      allocated_tiles_(0) {
+  static_assert(kChannelCount == weather_snapshot_format::kChannelCount, "Snapshots must store every channel");
 
-  int gribIndex;
-  int north = std::max(start_lat, end_lat);
-  int south = std::min(start_lat, end_lat);
-  int east = std::max(start_lon, end_lon);
-  int west = std::min(start_lon, end_lon);
-  int lat, lon;
+  const size_t tile_count = (planet_.vertex_count() + kTileSize - 1) / kTileSize;
+  for (size_t tile = 0; tile < tile_count; tile++) {
+    tiles_[tile].store(nullptr, std::memory_order_relaxed);
+  }
 
+  // Fresh forecasts are cached per region and forecast cycle, so reruns within a cycle don't download again
+  std::string weather_file_name = file_name;
   if (generate_new_grib) {
-    std::string url = UrlBuilder::BuildURL(std::to_string(north), std::to_string(south),
-                                           std::to_string(east), std::to_string(west));
-    UrlDownloader::Downloader(url);
-  }
-
-  gribParse file = gribParse(file_name, time_steps, use_csvs, output_csvs_folder);
-  file.saveKML(preserveKml);
-
-  for (WeatherMatrix::index vertex_id = 0; vertex_id < (WeatherMatrix::index)planet_.vertex_count(); ++vertex_id) {
-    for (WeatherMatrix::index time_step = 0; time_step < steps_; time_step++) {
-      boost::array<WeatherMatrix::index, 2> ind = {{vertex_id, time_step}};
-      const auto &coord = planet.vertex(vertex_id).coordinate;
-      lat = coord.round_to_int_latitude();
-      lon = coord.round_to_int_longitude();
-      lon = lon < 0 ? lon+360 : lon;  // convert negative longitudes to positive
-
-      if (lat > north || lat < south || lon > east || lon < west) {
-        // If out of bounds, put a high wind there to avoid going there
-        weather_data_(ind) = WeatherDatum{1000.0, 0.0, 0.0, 0.0, 0.0};
-        continue;
-      }
-
-      gribIndex = (lat-south) * (east-west+1) + (lon-west);
-      if (gribIndex >= file.number_of_points_) gribIndex = file.number_of_points_-1;
-      weather_data_(ind) = WeatherDatum{file.magnitudes[time_step][gribIndex],
-                                        file.angles[time_step][gribIndex], 0.0, 0.0, 0.0};
+    std::string url = UrlBuilder::BuildURL(std::to_string(north_), std::to_string(south_),
+                                           std::to_string(east_), std::to_string(west_));
+    std::string region_key = "N" + std::to_string(north_) + "_S" + std::to_string(south_) +
+        "_E" + std::to_string(east_) + "_W" + std::to_string(west_);
+    weather_file_name = UrlDownloader::CachedDownload(url, region_key, std::time(nullptr));
+  }
+
+  channel_values_.fill(nullptr);
+  if (IsSnapshotFile(weather_file_name)) {
+    ReadSnapshot(weather_file_name);
+    return;
+  }
+
+  gribParse file = gribParse(weather_file_name, time_steps, use_csvs, output_csvs_folder);
+  if (wind_kml.enabled) {
+    file.saveKML(wind_kml);
+  }
+
+  // The GRIB data only has wind.
+  grid_point_count_ = file.number_of_points_;
+  std::vector<float> &wind_speeds = channels_[static_cast<size_t>(Channel::kWindSpeed)];
+  std::vector<float> &wind_directions = channels_[static_cast<size_t>(Channel::kWindDirection)];
+  wind_speeds.resize(grid_point_count_ * steps_);
+  wind_directions.resize(grid_point_count_ * steps_);
+  for (uint32_t time_step = 0; time_step < steps_; time_step++) {
+    for (size_t grid_index = 0; grid_index < grid_point_count_; grid_index++) {
+      wind_speeds[time_step * grid_point_count_ + grid_index] =
+          static_cast<float>(file.magnitudes[time_step][grid_index]);
+      wind_directions[time_step * grid_point_count_ + grid_index] =
+          static_cast<float>(file.angles[time_step][grid_index]);
+    }
+  }
+  for (size_t channel = 0; channel < kChannelCount; channel++) {
+    if (!channels_[channel].empty()) {
+      channel_values_[channel] = channels_[channel].data();
+    }
+  }
+}
+
+bool WeatherHexMap::IsSnapshotFile(const std::string &filename) {
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  weather_snapshot_format::Header header;
+  if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+  return weather_snapshot_format::IsValidHeader(header);
+}
+
+void WeatherHexMap::ReadSnapshot(const std::string &filename) {
+  snapshot_.reset(new MappedFile(filename));
+  const weather_snapshot_format::Header &header = *snapshot_->at<weather_snapshot_format::Header>(0, 1);
+  if (!weather_snapshot_format::IsValidHeader(header)) {
+    throw std::runtime_error("Not a weather snapshot (or unsupported version): " + filename);
+  }
+  if (header.north != north_ || header.south != south_ || header.east != east_ || header.west != west_) {
+    throw std::runtime_error("Weather snapshot " + filename + " doesn't match the forecast region");
+  }
+  if (header.time_step_count < steps_) {
+    throw std::runtime_error("Weather snapshot " + filename + " has fewer than " + std::to_string(steps_) +
+        " time steps");
+  }
+  if (header.grid_point_count != static_cast<uint64_t>(north_ - south_ + 1) * (east_ - west_ + 1)) {
+    throw std::runtime_error("Weather snapshot " + filename + " has an inconsistent grid");
+  }
+
+  grid_point_count_ = header.grid_point_count;
+  for (size_t channel = 0; channel < kChannelCount; channel++) {
+    if (header.channel_offsets[channel] != 0) {
+      channel_values_[channel] = snapshot_->at<float>(header.channel_offsets[channel],
+                                                      header.time_step_count * header.grid_point_count);
+    }
+  }
+}
+
+namespace {
+
+/**
+ * @return The shared stencil table of tiles entirely outside of the forecast region.
+ */
+template<typename Stencil>
+const Stencil *OutOfRegionTile(int32_t out_of_region) {
+  static const std::vector<Stencil> tile(WeatherHexMap::kTileSize, Stencil{{{out_of_region}}, {{0.0f}}});
+  return tile.data();
+}
+
+}  // namespace
+
+WeatherHexMap::~WeatherHexMap() {
+  const size_t tile_count = (planet_.vertex_count() + kTileSize - 1) / kTileSize;
+  for (size_t tile = 0; tile < tile_count; tile++) {
+    const Stencil *stencils = tiles_[tile].load(std::memory_order_relaxed);
+    if (stencils != OutOfRegionTile<Stencil>(kOutOfRegion)) {
+      delete[] stencils;
+    }
+  }
+}
+
+WeatherDatum WeatherHexMap::get_weather(HexVertexId vertex_id,
+                                       uint32_t time) const {
+  const Stencil &stencil = VertexStencil(vertex_id);
+  return WeatherDatum{Value(Channel::kWindSpeed, stencil, time), Value(Channel::kWindDirection, stencil, time),
+                      Value(Channel::kCurrentSpeed, stencil, time), Value(Channel::kCurrentDirection, stencil, time),
+                      Value(Channel::kWaveHeight, stencil, time)};
+}
+
+float WeatherHexMap::get(Channel channel, HexVertexId vertex_id, uint32_t time) const {
+  return Value(channel, VertexStencil(vertex_id), time);
+}
+
+size_t WeatherHexMap::memory_usage() const {
+  size_t bytes = 0;
+  for (const std::vector<float> &values : channels_) {
+    bytes += values.size() * sizeof(float);
+  }
+  if (snapshot_) {
+    bytes += snapshot_->size();
+  }
+  const size_t tile_count = (planet_.vertex_count() + kTileSize - 1) / kTileSize;
+  bytes += tile_count * sizeof(tiles_[0]) + allocated_tiles_.load() * kTileSize * sizeof(Stencil);
+  return bytes;
+}
+
+uint64_t WeatherHexMap::fingerprint() const {
+  Fnv1aHash hash;
+  for (int value : {north_, south_, east_, west_}) {
+    hash.add(static_cast<uint64_t>(value));
+  }
+  hash.add(steps_);
+  hash.add(steps_per_forecast_);
+  hash.add(static_cast<uint64_t>(interpolation_));
+  hash.add(grid_point_count_);
+  for (const float *values : channel_values_) {
+    hash.add(values != nullptr);
+    if (values != nullptr) {
+      hash.add(values, grid_point_count_ * steps_);
+    }
+  }
+  return hash.value();
+}
+
+int32_t WeatherHexMap::GridIndex(int lat, int lon) const {
+  const size_t grid_index = (lat-south_) * (east_-west_+1) + (lon-west_);
+  return static_cast<int32_t>(std::min(grid_index, grid_point_count_ - 1));
+}
+
+WeatherHexMap::Stencil WeatherHexMap::ComputeStencil(const GPSCoordinate &coord) const {
+  const int lat = coord.round_to_int_latitude();
+  int lon = coord.round_to_int_longitude();
+  lon = lon < 0 ? lon+360 : lon;  // convert negative longitudes to positive
+
+  Stencil stencil{{{kOutOfRegion, kOutOfRegion, kOutOfRegion, kOutOfRegion}}, {{0.0f, 0.0f, 0.0f, 0.0f}}};
+  if (lat > north_ || lat < south_ || lon > east_ || lon < west_ || grid_point_count_ == 0) {
+    return stencil;
+  }
+
+  if (interpolation_ == Interpolation::kNearest) {
+    stencil.grid_indices[0] = GridIndex(lat, lon);
+    stencil.weights[0] = 1.0f;
+    return stencil;
+  }
+
+  // Blend the grid cell around the exact position, clamped to the region (the grid spacing is one degree).
+  const double exact_lat = std::min<double>(std::max<double>(
+      static_cast<double>(coord.latitude_exact()) / GPSCoordinate::kExactCoordinateScaleFactor, south_), north_);
+  double exact_lon = static_cast<double>(coord.longitude_exact()) / GPSCoordinate::kExactCoordinateScaleFactor;
+  exact_lon = exact_lon < 0 ? exact_lon + 360 : exact_lon;
+  exact_lon = std::min<double>(std::max<double>(exact_lon, west_), east_);
+
+  const int lat0 = std::min(static_cast<int>(std::floor(exact_lat)), std::max(north_ - 1, south_));
+  const int lon0 = std::min(static_cast<int>(std::floor(exact_lon)), std::max(east_ - 1, west_));
+  const int lat1 = std::min(lat0 + 1, north_);
+  const int lon1 = std::min(lon0 + 1, east_);
+  const float lat_fraction = static_cast<float>(exact_lat - lat0);
+  const float lon_fraction = static_cast<float>(exact_lon - lon0);
+
+  stencil.grid_indices = {{GridIndex(lat0, lon0), GridIndex(lat0, lon1), GridIndex(lat1, lon0), GridIndex(lat1, lon1)}};
+  stencil.weights = {{(1 - lat_fraction) * (1 - lon_fraction), (1 - lat_fraction) * lon_fraction,
+                      lat_fraction * (1 - lon_fraction), lat_fraction * lon_fraction}};
+  return stencil;
+}
+
+const WeatherHexMap::Stencil *WeatherHexMap::Tile(size_t tile) const {
+  const Stencil *stencils = tiles_[tile].load(std::memory_order_acquire);
+  if (stencils != nullptr) {
+    return stencils;
+  }
+
+  const size_t begin = tile * kTileSize;
+  const size_t end = std::min(begin + kTileSize, planet_.vertex_count());
+  std::unique_ptr<Stencil[]> new_stencils(new Stencil[kTileSize]);
+  bool in_region = false;
+  for (size_t vertex_id = begin; vertex_id < end; vertex_id++) {
+    const HexVertexId id = static_cast<HexVertexId>(vertex_id);
+    new_stencils[vertex_id - begin] = ComputeStencil(planet_.vertex(id).coordinate);
+    in_region = in_region || new_stencils[vertex_id - begin].grid_indices[0] != kOutOfRegion;
+  }
+  const Stencil *mapped = in_region ? new_stencils.get() : OutOfRegionTile<Stencil>(kOutOfRegion);
+
+  // Another thread may have mapped the tile in the meantime, both results are identical.
+  if (tiles_[tile].compare_exchange_strong(stencils, mapped, std::memory_order_acq_rel)) {
+    if (in_region) {
+      new_stencils.release();
+      allocated_tiles_++;
     }
+    return mapped;
   }
+  return stencils;
 }
 
-const WeatherDatum& WeatherHexMap::get_weather(HexVertexId vertex_id,
-                                             uint32_t time) {
+const WeatherHexMap::Stencil &WeatherHexMap::VertexStencil(HexVertexId vertex_id) const {
   if (vertex_id >= planet_.vertex_count()) {
     throw std::runtime_error("Invalid vertex ID.");
   }
+  return Tile(vertex_id / kTileSize)[vertex_id % kTileSize];
+}
+
+float WeatherHexMap::Value(Channel channel, const Stencil &stencil, uint32_t time) const {
+  const float *values = channel_values_[static_cast<size_t>(channel)];
+  if (values == nullptr) {
+    return 0.0f;
+  }
+  if (stencil.grid_indices[0] == kOutOfRegion) {
+    // If out of bounds, put a high wind there to avoid going there
+    return channel == Channel::kWindSpeed ? kOutOfRegionWindSpeed : 0.0f;
+  }
 
+  const uint32_t forecast_step = time / steps_per_forecast_;
+  const uint32_t step_offset = time % steps_per_forecast_;
+  if (step_offset == 0 || forecast_step + 1 >= steps_) {
+    return ForecastValue(values, stencil, forecast_step);
+  }
+
+  // Blend the surrounding forecast steps. Directions are blended like the other channels; the GRIB wind angles lie
+  // within (180, 360) degrees, so they don't wrap around.
+  const float fraction = static_cast<float>(step_offset) / steps_per_forecast_;
+  return (1 - fraction) * ForecastValue(values, stencil, forecast_step) +
+      fraction * ForecastValue(values, stencil, forecast_step + 1);
+}
+
+float WeatherHexMap::ForecastValue(const float *values,
+                                   const Stencil &stencil,
+                                   uint32_t forecast_step) const {
   // Clamp time to be at max allowable value
-  if (time >= steps_) {
-    time = steps_ - 1;
+  if (forecast_step >= steps_) {
+    forecast_step = steps_ - 1;
+  }
+
+  const float *step_values = values + static_cast<size_t>(forecast_step) * grid_point_count_;
+  if (stencil_size_ == 1) {
+    return step_values[stencil.grid_indices[0]];
   }
 
-  boost::array<WeatherMatrix::index, 2> ind = {{vertex_id, time}};
-  return weather_data_(ind);
+  float value = 0.0f;
+  for (size_t i = 0; i < kStencilSize; i++) {
+    value += stencil.weights[i] * step_values[stencil.grid_indices[i]];
+  }
+  return value;
 }
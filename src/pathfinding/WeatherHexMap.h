@@ -3,25 +3,101 @@
 #ifndef PATHFINDING_WEATHERHEXMAP_H_
 #define PATHFINDING_WEATHERHEXMAP_H_
 
-#include "boost/multi_array.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/MappedFile.h"
+#include "datatypes/GPSCoordinate.h"
 #include "datatypes/WeatherDatum.h"
+#include "grib/WindKmlOptions.h"
 #include "planet/HexPlanet.h"
 
 /**
  * @brief Stores weather data over time for each vertex of a HexPlanet.
+ *
+ * Weather is only stored for the forecast region (the start/end bounding box): each WeatherDatum field is a channel
+ * stored as its own float array over the region's grid points, in time-major order (all grid points of time step 0,
+ * then all of time step 1, ...). Only the channels present in the weather source are allocated; the others read as 0.
+ *
+ * Each vertex reads its weather from a stencil of grid points: the nearest one, or the four surrounding ones blended
+ * bilinearly. Stencils are computed lazily, one tile of kTileSize consecutive vertices at a time, on the first lookup
+ * in the tile. Tiles entirely outside the region share a single table, so memory and startup time scale with the
+ * forecast region and the explored part of the planet rather than the whole globe. Lookups are safe to call
+ * concurrently.
+ *
+ * Pathfinder time steps can be finer than the forecast steps (steps_per_forecast), in which case the weather is
+ * blended linearly between the two surrounding forecast steps.
  */
 class WeatherHexMap {
  public:
+  /**
+   * The weather quantities, one per WeatherDatum field.
+   */
+  enum class Channel {
+    kWindSpeed,
+    kWindDirection,
+    kCurrentSpeed,
+    kCurrentDirection,
+    kWaveHeight
+  };
+
+  /**
+   * How the weather of a vertex is derived from the surrounding grid points.
+   */
+  enum class Interpolation {
+    /// The nearest grid point (a staircase at resolutions finer than the grid).
+    kNearest,
+    /// Bilinear blend of the four surrounding grid points.
+    kBilinear
+  };
+
+  /// The number of channels.
+  static constexpr size_t kChannelCount = 5;
+  /// The maximum number of grid points blended for a vertex.
+  static constexpr size_t kStencilSize = 4;
+  /// The number of consecutive vertices mapped to grid points at once.
+  static constexpr size_t kTileSize = 1024;
+  /// Wind speed of vertices outside the forecast region, high to keep paths out of it.
+  static constexpr float kOutOfRegionWindSpeed = 1000.0f;
+  /// Grid index of vertices outside of the forecast region.
+  static constexpr int32_t kOutOfRegion = -1;
+
+  /**
+   * The grid points a vertex's weather is blended from. Unused entries have a weight of 0.
+   */
+  struct Stencil {
+    /// Grid indices, the first one is kOutOfRegion for vertices outside the forecast region.
+    std::array<int32_t, kStencilSize> grid_indices;
+    std::array<float, kStencilSize> weights;
+  };
+
   /**
    * Initializes a map of weather data for each vertex of the planet.
    * Each WeatherDatum contains weather info for one point in time.
    * @param planet The planet.
-   * @param time_steps How many |WeatherDatum|s to store for each vertex.
+   * @param time_steps How many |WeatherDatum|s (forecast steps) to store for each vertex.
+   * @param file_name The GRIB file, the csvs folder if |use_csvs|, or a weather snapshot (see gribParse::saveSnapshot),
+   * which is recognized from its header and memory-mapped.
+   * @param wind_kml Whether and how to write the wind overlay KML of GRIB or csvs weather.
+   * @param interpolation How vertices are mapped onto the weather grid.
+   * @param steps_per_forecast The number of pathfinder time steps per forecast step. Values in between forecast steps
+   * are blended linearly.
+   * @throw std::runtime_error A weather snapshot is malformed, doesn't match the region or has too few time steps.
    */
   explicit WeatherHexMap(const HexPlanet &planet, const uint32_t time_steps, int start_lat,
                          int start_lon, int end_lat, int end_lon, bool generate_new_grib = true,
                          const std::string & file_name = "data.grb", bool use_csvs = false,
-                         const std::string & output_csvs_folder = "", bool preserveKml = false);
+                         const std::string & output_csvs_folder = "", const WindKmlOptions &wind_kml = WindKmlOptions(),
+                         Interpolation interpolation = Interpolation::kNearest, uint32_t steps_per_forecast = 1);
+
+  ~WeatherHexMap();
+
+  // Tiles are shared between lookups through raw pointers, so the map can't be copied.
+  WeatherHexMap(const WeatherHexMap &) = delete;
+  WeatherHexMap &operator=(const WeatherHexMap &) = delete;
 
   /**
    * Gets the |WeatherDatum| associated with a specific vertex at a specified
@@ -32,13 +108,115 @@ class WeatherHexMap {
    *    or |time_step| is out of range.
    * @return The |WeatherDatum| associated with that vertex at that time.
    */
-  const WeatherDatum& get_weather(HexVertexId vertex_id, uint32_t time_steps);
+  WeatherDatum get_weather(HexVertexId vertex_id, uint32_t time_steps) const;
+
+  /**
+   * Gets a single weather quantity, without assembling a whole WeatherDatum.
+   * @param channel The quantity.
+   * @param vertex_id The id of the vertex.
+   * @param time The time, expressed as number of pathfinder time steps into the future. Clamped to the last forecast.
+   * @throw std::runtime_error |vertex_id| is invalid.
+   * @return The value of |channel| at that vertex and time, 0 if the channel isn't stored.
+   */
+  float get(Channel channel, HexVertexId vertex_id, uint32_t time) const;
+
+  /**
+   * @param channel The quantity.
+   * @return Whether |channel| is stored.
+   */
+  bool has_channel(Channel channel) const { return channel_values_[static_cast<size_t>(channel)] != nullptr; }
+
+  /**
+   * @return The number of forecast steps stored.
+   */
+  uint32_t time_steps() const { return steps_; }
+
+  /**
+   * @return The first pathfinder time step from which the weather no longer changes (the last forecast step).
+   */
+  uint32_t time_horizon() const { return steps_ == 0 ? 0 : (steps_ - 1) * steps_per_forecast_; }
+
+  /**
+   * @return The memory used by the stored channels (or mapped snapshot) and the vertex tiles mapped so far in bytes.
+   */
+  size_t memory_usage() const;
+
+  /**
+   * @return A hash of the stored weather and of how it's mapped onto vertices, which tells two maps apart without
+   *    looking up any vertex.
+   */
+  uint64_t fingerprint() const;
+
+  /**
+   * @param coordinate A position.
+   * @return The grid points the weather at |coordinate| is blended from with this map's interpolation. Positions
+   *    that round into the forecast region but lie past its edges are clamped to them.
+   */
+  Stencil ComputeStencil(const GPSCoordinate &coordinate) const;
+
+  /**
+   * @param filename Path of a weather file.
+   * @return Whether the file is a weather snapshot.
+   */
+  static bool IsSnapshotFile(const std::string &filename);
 
  private:
   const HexPlanet &planet_;
   const uint32_t steps_;
-  typedef boost::multi_array<WeatherDatum, 2> WeatherMatrix;
-  WeatherMatrix weather_data_;
+  const Interpolation interpolation_;
+  const uint32_t steps_per_forecast_;
+  /// The number of used stencil entries, 1 for kNearest.
+  const size_t stencil_size_;
+
+  /// The forecast region, in integer degrees (longitudes in [0, 360)).
+  int north_, south_, east_, west_;
+  /// The number of grid points per time step.
+  size_t grid_point_count_;
+
+  /// Per channel values decoded from csvs or GRIB files, empty if the channel isn't stored.
+  std::array<std::vector<float>, kChannelCount> channels_;
+  /// The weather snapshot, if the weather was read from one.
+  std::unique_ptr<MappedFile> snapshot_;
+  /// Per channel values at index time * grid_point_count_ + grid index, pointing into channels_ or snapshot_. nullptr
+  /// if the channel isn't stored.
+  std::array<const float *, kChannelCount> channel_values_;
+
+  /// Per tile, the stencil of each of its vertices. nullptr until the tile is first accessed.
+  std::unique_ptr<std::atomic<const Stencil *>[]> tiles_;
+  /// The number of tiles with their own stencil table.
+  mutable std::atomic<size_t> allocated_tiles_;
+
+  /**
+   * Memory-maps the channels of a weather snapshot.
+   * @throw std::runtime_error The snapshot is malformed, doesn't match the region or has too few time steps.
+   */
+  void ReadSnapshot(const std::string &filename);
+
+  /**
+   * @return The grid index of a point in the forecast region, clamped to the grid.
+   */
+  int32_t GridIndex(int lat, int lon) const;
+
+  /**
+   * @return The stencils of the vertices of |tile|, computing them on first use.
+   */
+  const Stencil *Tile(size_t tile) const;
+
+  /**
+   * @throw std::runtime_error |vertex_id| is invalid.
+   * @return The stencil of |vertex_id|.
+   */
+  const Stencil &VertexStencil(HexVertexId vertex_id) const;
+
+  /**
+   * @return The value of |channel| for |stencil| at pathfinder time |time|.
+   */
+  float Value(Channel channel, const Stencil &stencil, uint32_t time) const;
+
+  /**
+   * @return The value of the channel |values| for |stencil| at forecast step |forecast_step| (clamped to the last one).
+   */
+  float ForecastValue(const float *values, const Stencil &stencil, uint32_t forecast_step) const;
 };
 
 #endif  // PATHFINDING_WEATHERHEXMAP_H_
@@ -0,0 +1,46 @@
+// Copyright 2022 UBC Sailbot
+
+#include "planet/HexGraph.h"
+
+#include <limits>
+#include <stdexcept>
+
+HexGraph::HexGraph(const std::vector<HexVertex> &vertices) {
+  size_t neighbour_edge_count = 0;
+  size_t indirect_edge_count = 0;
+  for (const HexVertex &vertex : vertices) {
+    neighbour_edge_count += vertex.neighbour_count;
+    indirect_edge_count += vertex.indirect_neighbours.size();
+  }
+
+  // Offsets are 32 bit to keep the arrays small, which holds comfortably for any planet we can build.
+  if (indirect_edge_count > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Too many indirect neighbours for HexGraph.");
+  }
+
+  neighbour_offsets_.reserve(vertices.size() + 1);
+  neighbours_.reserve(neighbour_edge_count);
+  neighbour_distances_.reserve(neighbour_edge_count);
+  indirect_offsets_.reserve(vertices.size() + 1);
+  indirect_neighbours_.reserve(indirect_edge_count);
+
+  neighbour_offsets_.push_back(0);
+  indirect_offsets_.push_back(0);
+  for (const HexVertex &vertex : vertices) {
+    neighbours_.insert(neighbours_.end(), vertex.neighbours.begin(),
+                       vertex.neighbours.begin() + vertex.neighbour_count);
+    neighbour_distances_.insert(neighbour_distances_.end(), vertex.neighbour_distances.begin(),
+                                vertex.neighbour_distances.begin() + vertex.neighbour_count);
+    neighbour_offsets_.push_back(static_cast<uint32_t>(neighbours_.size()));
+
+    indirect_neighbours_.insert(indirect_neighbours_.end(), vertex.indirect_neighbours.begin(),
+                                vertex.indirect_neighbours.end());
+    indirect_offsets_.push_back(static_cast<uint32_t>(indirect_neighbours_.size()));
+  }
+}
+
+size_t HexGraph::memory_usage() const {
+  return (neighbour_offsets_.capacity() + indirect_offsets_.capacity()) * sizeof(uint32_t) +
+      (neighbours_.capacity() + indirect_neighbours_.capacity()) * sizeof(HexVertexId) +
+      neighbour_distances_.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,133 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PLANET_HEXGRAPH_H_
+#define PLANET_HEXGRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "datatypes/HexDefs.h"
+#include "datatypes/HexVertex.h"
+
+/**
+ * @brief Compact, read-only adjacency of a HexPlanet.
+ *
+ * Neighbours, neighbour distances and indirect neighbours are stored in contiguous arrays (CSR layout) indexed by
+ * per-vertex offsets, so iterating over the edges of a vertex touches one or two cache lines instead of a whole
+ * HexVertex and its heap-allocated indirect neighbour vector.
+ *
+ * Direct neighbours keep the order of HexVertex::neighbours, so the i-th entry of neighbours(v) is the neighbour that
+ * CostCalculator::calculate_neighbour(v, i, ...) refers to.
+ */
+class HexGraph {
+ public:
+  /**
+   * A contiguous, non-owning range of elements.
+   */
+  template<typename T>
+  class Span {
+   public:
+    Span(const T *begin, const T *end) : begin_(begin), end_(end) {}
+
+    const T *begin() const { return begin_; }
+    const T *end() const { return end_; }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+    const T &operator[](size_t i) const { return begin_[i]; }
+
+   private:
+    const T *begin_;
+    const T *end_;
+  };
+
+  HexGraph() = default;
+
+  /**
+   * Build the graph from the vertices of a planet.
+   * @param vertices Vertices with their neighbours, neighbour distances and indirect neighbours computed.
+   */
+  explicit HexGraph(const std::vector<HexVertex> &vertices);
+
+  /**
+   * @return The number of vertices in the graph.
+   */
+  size_t vertex_count() const { return neighbour_offsets_.empty() ? 0 : neighbour_offsets_.size() - 1; }
+
+  /**
+   * @return The number of direct (directed) edges in the graph.
+   */
+  size_t neighbour_edge_count() const { return neighbours_.size(); }
+
+  /**
+   * @return The number of indirect (directed) edges in the graph.
+   */
+  size_t indirect_neighbour_edge_count() const { return indirect_neighbours_.size(); }
+
+  /**
+   * @param vertex Vertex ID.
+   * @return The number of direct neighbours of |vertex|.
+   */
+  uint32_t neighbour_count(HexVertexId vertex) const {
+    return neighbour_offsets_[vertex + 1] - neighbour_offsets_[vertex];
+  }
+
+  /**
+   * @param vertex Vertex ID.
+   * @return The direct neighbours of |vertex|.
+   */
+  Span<HexVertexId> neighbours(HexVertexId vertex) const {
+    return {neighbours_.data() + neighbour_offsets_[vertex], neighbours_.data() + neighbour_offsets_[vertex + 1]};
+  }
+
+  /**
+   * @param vertex Vertex ID.
+   * @return The distances (in meters) to the direct neighbours of |vertex|, in the same order as neighbours().
+   */
+  Span<uint32_t> neighbour_distances(HexVertexId vertex) const {
+    return {neighbour_distances_.data() + neighbour_offsets_[vertex],
+            neighbour_distances_.data() + neighbour_offsets_[vertex + 1]};
+  }
+
+  /**
+   * @param vertex Vertex ID.
+   * @return The indirect neighbours of |vertex|.
+   */
+  Span<HexVertexId> indirect_neighbours(HexVertexId vertex) const {
+    return {indirect_neighbours_.data() + indirect_offsets_[vertex],
+            indirect_neighbours_.data() + indirect_offsets_[vertex + 1]};
+  }
+
+  /**
+   * The index of the first direct edge of |vertex|. Direct edge i of |vertex| has the index neighbour_offset(vertex) + i,
+   * which allows per-edge data to be stored in flat arrays of size neighbour_edge_count().
+   * @param vertex Vertex ID.
+   * @return The edge index of the first direct edge of |vertex|.
+   */
+  uint32_t neighbour_offset(HexVertexId vertex) const { return neighbour_offsets_[vertex]; }
+
+  /**
+   * The index of the first indirect edge of |vertex|, see neighbour_offset().
+   * @param vertex Vertex ID.
+   * @return The edge index of the first indirect edge of |vertex|.
+   */
+  uint32_t indirect_offset(HexVertexId vertex) const { return indirect_offsets_[vertex]; }
+
+  /**
+   * @return The memory used by the graph arrays in bytes.
+   */
+  size_t memory_usage() const;
+
+ private:
+  /// neighbours_[neighbour_offsets_[v], neighbour_offsets_[v + 1]) are the direct neighbours of v.
+  std::vector<uint32_t> neighbour_offsets_;
+  std::vector<HexVertexId> neighbours_;
+  /// Distances in meters, parallel to neighbours_.
+  std::vector<uint32_t> neighbour_distances_;
+  /// indirect_neighbours_[indirect_offsets_[v], indirect_offsets_[v + 1]) are the indirect neighbours of v.
+  std::vector<uint32_t> indirect_offsets_;
+  std::vector<HexVertexId> indirect_neighbours_;
+};
+
+#endif  // PLANET_HEXGRAPH_H_
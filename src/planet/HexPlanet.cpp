@@ -1,17 +1,28 @@
 // Copyright 2017 UBC Sailbot
 
 #include "planet/HexPlanet.h"
+#include "planet/HexPlanetFormat.h"
+#include "common/GeneralDefs.h"
+#include "common/MappedFile.h"
+#include "common/ParallelFor.h"
 #include "common/ProgressBar.h"
 
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <utility>
 
 #include "logic/StandardCalc.h"
 
 HexPlanet::HexPlanet(const std::string& stored_planet_filename) {
+  if (IsBinaryFile(stored_planet_filename)) {
+    ReadBinary(MappedFile(stored_planet_filename));
+    return;
+  }
+
   std::filebuf fb;
   if (fb.open(stored_planet_filename, std::ios::in)) {
     std::istream is(&fb);
@@ -21,7 +32,8 @@ HexPlanet::HexPlanet(const std::string& stored_planet_filename) {
 }
 
 
-HexPlanet::HexPlanet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth) {
+HexPlanet::HexPlanet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth, unsigned thread_count)
+    : thread_count_(thread_count) {
   // Setup for progress bar
   ProgressBar progress_bar;
   int total_num_steps = 8;  // Number of major steps in this function
@@ -69,6 +81,7 @@ HexPlanet::HexPlanet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth
 
   // Initialize the indirect (but close) neighbours for each vertex
   ComputeIndirectVertexNeighbours(indirect_neighbour_depth);
+  BuildQueryStructures();
   progress_bar.flush();
 }
 
@@ -194,10 +207,192 @@ void HexPlanet::Read(std::istream &is) {
       triangles_.push_back(HexTriangle(x - 1, y - 1, z - 1));
     }
   }
+
+  BuildQueryStructures();
+}
+
+void HexPlanet::WriteBinaryToFile(const std::string& output_planet_filename) const {
+  std::ofstream os(output_planet_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os) {
+    throw std::runtime_error("Unable to open " + output_planet_filename + " for writing");
+  }
+  WriteBinary(os);
+  if (!os) {
+    throw std::runtime_error("Failed to write " + output_planet_filename);
+  }
+}
+
+void HexPlanet::WriteBinary(std::ostream &o) const {
+  using hex_planet_format::Align;
+  constexpr size_t kMaxNeighbours = HexVertex::kMaxHexVertexNeighbourCount;
+  const uint64_t vertex_count = vertices_.size();
+  const uint64_t triangle_count = triangles_.size();
+
+  // Flatten the mesh into the arrays that will be written
+  std::vector<float> positions;
+  std::vector<double> coordinates;
+  std::vector<uint32_t> neighbour_counts;
+  std::vector<HexVertexId> neighbours;
+  std::vector<uint32_t> neighbour_distances;
+  std::vector<uint64_t> indirect_offsets;
+  std::vector<HexVertexId> indirect_neighbours;
+  std::vector<HexVertexId> triangles;
+  positions.reserve(3 * vertex_count);
+  coordinates.reserve(2 * vertex_count);
+  neighbour_counts.reserve(vertex_count);
+  neighbours.reserve(kMaxNeighbours * vertex_count);
+  neighbour_distances.reserve(kMaxNeighbours * vertex_count);
+  indirect_offsets.reserve(vertex_count + 1);
+  triangles.reserve(3 * triangle_count);
+
+  indirect_offsets.push_back(0);
+  for (const HexVertex &vertex : vertices_) {
+    const Eigen::Vector3f normal = vertex.normal();
+    positions.insert(positions.end(), {normal[0], normal[1], normal[2]});
+    coordinates.insert(coordinates.end(), {vertex.coordinate.latitude(), vertex.coordinate.longitude()});
+    neighbour_counts.push_back(vertex.neighbour_count);
+    neighbours.insert(neighbours.end(), vertex.neighbours.begin(), vertex.neighbours.end());
+    neighbour_distances.insert(neighbour_distances.end(), vertex.neighbour_distances.begin(),
+                               vertex.neighbour_distances.end());
+    indirect_neighbours.insert(indirect_neighbours.end(), vertex.indirect_neighbours.begin(),
+                               vertex.indirect_neighbours.end());
+    indirect_offsets.push_back(indirect_neighbours.size());
+  }
+  for (const HexTriangle &triangle : triangles_) {
+    triangles.insert(triangles.end(), {triangle.vertex_a, triangle.vertex_b, triangle.vertex_c});
+  }
+
+  // Lay out the arrays after the header
+  hex_planet_format::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, hex_planet_format::kMagic, sizeof(header.magic));
+  header.version = hex_planet_format::kVersion;
+  header.subdivision_level = subdivision_level_;
+  header.vertex_count = vertex_count;
+  header.triangle_count = triangle_count;
+  header.indirect_neighbour_count = indirect_neighbours.size();
+
+  uint64_t offset = Align(sizeof(header));
+  auto place = [&offset](uint64_t bytes) {
+    uint64_t placed = offset;
+    offset = Align(offset + bytes);
+    return placed;
+  };
+  header.positions_offset = place(positions.size() * sizeof(float));
+  header.coordinates_offset = place(coordinates.size() * sizeof(double));
+  header.neighbour_counts_offset = place(neighbour_counts.size() * sizeof(uint32_t));
+  header.neighbours_offset = place(neighbours.size() * sizeof(HexVertexId));
+  header.neighbour_distances_offset = place(neighbour_distances.size() * sizeof(uint32_t));
+  header.indirect_offsets_offset = place(indirect_offsets.size() * sizeof(uint64_t));
+  header.indirect_neighbours_offset = place(indirect_neighbours.size() * sizeof(HexVertexId));
+  header.triangles_offset = place(triangles.size() * sizeof(HexVertexId));
+
+  // Write the header and each array, padding up to the next offset
+  uint64_t written = 0;
+  auto write_at = [&o, &written](uint64_t at, const void *data, uint64_t bytes) {
+    static const char kPadding[hex_planet_format::kAlignment] = {0};
+    while (written < at) {
+      uint64_t padding = std::min<uint64_t>(at - written, sizeof(kPadding));
+      o.write(kPadding, padding);
+      written += padding;
+    }
+    o.write(static_cast<const char *>(data), bytes);
+    written += bytes;
+  };
+  write_at(0, &header, sizeof(header));
+  write_at(header.positions_offset, positions.data(), positions.size() * sizeof(float));
+  write_at(header.coordinates_offset, coordinates.data(), coordinates.size() * sizeof(double));
+  write_at(header.neighbour_counts_offset, neighbour_counts.data(), neighbour_counts.size() * sizeof(uint32_t));
+  write_at(header.neighbours_offset, neighbours.data(), neighbours.size() * sizeof(HexVertexId));
+  write_at(header.neighbour_distances_offset, neighbour_distances.data(),
+           neighbour_distances.size() * sizeof(uint32_t));
+  write_at(header.indirect_offsets_offset, indirect_offsets.data(), indirect_offsets.size() * sizeof(uint64_t));
+  write_at(header.indirect_neighbours_offset, indirect_neighbours.data(),
+           indirect_neighbours.size() * sizeof(HexVertexId));
+  write_at(header.triangles_offset, triangles.data(), triangles.size() * sizeof(HexVertexId));
+}
+
+void HexPlanet::ReadBinary(const MappedFile &file) {
+  constexpr size_t kMaxNeighbours = HexVertex::kMaxHexVertexNeighbourCount;
+
+  const hex_planet_format::Header &header = *file.at<hex_planet_format::Header>(0, 1);
+  if (!hex_planet_format::IsValidHeader(header)) {
+    throw std::runtime_error("Not a binary planet file (or unsupported version).");
+  }
+
+  const uint64_t vertex_count = header.vertex_count;
+  const float *positions = file.at<float>(header.positions_offset, 3 * vertex_count);
+  const double *coordinates = file.at<double>(header.coordinates_offset, 2 * vertex_count);
+  const uint32_t *neighbour_counts = file.at<uint32_t>(header.neighbour_counts_offset, vertex_count);
+  const HexVertexId *neighbours = file.at<HexVertexId>(header.neighbours_offset, kMaxNeighbours * vertex_count);
+  const uint32_t *neighbour_distances =
+      file.at<uint32_t>(header.neighbour_distances_offset, kMaxNeighbours * vertex_count);
+  const uint64_t *indirect_offsets = file.at<uint64_t>(header.indirect_offsets_offset, vertex_count + 1);
+  const HexVertexId *indirect_neighbours =
+      file.at<HexVertexId>(header.indirect_neighbours_offset, header.indirect_neighbour_count);
+  const HexVertexId *triangles = file.at<HexVertexId>(header.triangles_offset, 3 * header.triangle_count);
+
+  if (indirect_offsets[vertex_count] != header.indirect_neighbour_count) {
+    throw std::runtime_error("Binary planet file has inconsistent indirect neighbour offsets.");
+  }
+
+  subdivision_level_ = static_cast<uint8_t>(header.subdivision_level);
+
+  // The IDs index vertices_ and the neighbour arrays, so a corrupt file must not get past here
+  auto is_valid_id = [vertex_count](HexVertexId id) { return id < vertex_count; };
+
+  vertices_.clear();
+  vertices_.reserve(vertex_count);
+  for (uint64_t i = 0; i < vertex_count; i++) {
+    HexVertex vertex(Eigen::Vector3f(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]));
+    vertex.coordinate = GPSCoordinateFast(coordinates[2 * i], coordinates[2 * i + 1]);
+    if (neighbour_counts[i] > kMaxNeighbours) {
+      throw std::runtime_error("Binary planet file has a vertex with too many neighbours.");
+    }
+    vertex.neighbour_count = neighbour_counts[i];
+    const HexVertexId *vertex_neighbours = neighbours + kMaxNeighbours * i;
+    if (!std::all_of(vertex_neighbours, vertex_neighbours + vertex.neighbour_count, is_valid_id)) {
+      throw std::runtime_error("Binary planet file has an invalid neighbour ID.");
+    }
+    std::copy(vertex_neighbours, vertex_neighbours + kMaxNeighbours, vertex.neighbours.begin());
+    std::copy(neighbour_distances + kMaxNeighbours * i, neighbour_distances + kMaxNeighbours * (i + 1),
+              vertex.neighbour_distances.begin());
+    if (indirect_offsets[i] > indirect_offsets[i + 1] || indirect_offsets[i + 1] > header.indirect_neighbour_count) {
+      throw std::runtime_error("Binary planet file has inconsistent indirect neighbour offsets.");
+    }
+    if (!std::all_of(indirect_neighbours + indirect_offsets[i], indirect_neighbours + indirect_offsets[i + 1],
+                     is_valid_id)) {
+      throw std::runtime_error("Binary planet file has an invalid indirect neighbour ID.");
+    }
+    vertex.indirect_neighbours.assign(indirect_neighbours + indirect_offsets[i],
+                                      indirect_neighbours + indirect_offsets[i + 1]);
+    vertices_.push_back(std::move(vertex));
+  }
+
+  if (!std::all_of(triangles, triangles + 3 * header.triangle_count, is_valid_id)) {
+    throw std::runtime_error("Binary planet file has an invalid triangle vertex ID.");
+  }
+  triangles_.clear();
+  triangles_.reserve(header.triangle_count);
+  for (uint64_t i = 0; i < header.triangle_count; i++) {
+    triangles_.push_back(HexTriangle(triangles[3 * i], triangles[3 * i + 1], triangles[3 * i + 2]));
+  }
+
+  BuildQueryStructures();
+}
+
+bool HexPlanet::IsBinaryFile(const std::string& filename) {
+  std::ifstream is(filename, std::ios::in | std::ios::binary);
+  hex_planet_format::Header header;
+  if (!is.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    return false;
+  }
+  return hex_planet_format::IsValidHeader(header);
 }
 
 void HexPlanet::RepairNormals() {
-  for (HexTriangle &triangle : triangles_) {
+  parallel::For(triangles_.size(), thread_count_, [this](size_t ti) {
+    HexTriangle &triangle = triangles_[ti];
     // Pull three vertices of the triangle
     const Eigen::Vector3f p0 = vertices_[triangle.vertex_a].normal();
     const Eigen::Vector3f p1 = vertices_[triangle.vertex_b].normal();
@@ -217,7 +412,7 @@ void HexPlanet::RepairNormals() {
     } else {
       // No correction necessary
     }
-  }
+  });
 }
 
 void HexPlanet::build_level_0() {
@@ -259,78 +454,97 @@ void HexPlanet::build_level_0() {
   triangles_.push_back(HexTriangle(8, 3, 5));
 }
 
-void HexPlanet::UpdateAdjacencyInfo(const std::pair<uint32_t, uint32_t> &edge,
-                                    uint32_t triangle_index,
-                                    HexPlanet::AdjacencyMap &adjacency_map) {
-  auto i = adjacency_map.find(edge);
-  if (i == adjacency_map.end()) {
-    // Add the edge to the adjacency map (record the first triangle).
-    adjacency_map[edge] = std::make_pair(triangle_index, -1);
-  } else {
-    // Record the second triangle that's attached to the edge.
-    // i->second is the value in the map (a pair of triangle indexes)
-    // the first index was set in create (above)
-    if (i->second.second != kInvalidHexVertexId) {
-      throw std::runtime_error("Adjacency map contains kInvalidHexVertexIdError");
-    }
-    i->second.second = triangle_index;
-  }
-}
+namespace {
+
+/// One side of an edge: the edge's larger vertex and a triangle using the edge. Stored in the smaller vertex's bucket.
+struct HalfEdge {
+  HexVertexId vertex;
+  uint32_t triangle;
+};
+
+}  // namespace
 
 void HexPlanet::Subdivide() {
-  // Generate adjacency info
-  AdjacencyMap adjacency_info;
-  for (uint32_t ti = 0; ti != triangles_.size(); ++ti) {
-    const HexTriangle &t = triangles_[ti];
-    HexVertexPair edge_a_b(std::min(t.vertex_a, t.vertex_b), std::max(t.vertex_a, t.vertex_b));
-    UpdateAdjacencyInfo(edge_a_b, ti, adjacency_info);
-
-    HexVertexPair edge_b_c(std::min(t.vertex_b, t.vertex_c), std::max(t.vertex_b, t.vertex_c));
-    UpdateAdjacencyInfo(edge_b_c, ti, adjacency_info);
-
-    HexVertexPair edge_c_a(std::min(t.vertex_c, t.vertex_a), std::max(t.vertex_c, t.vertex_a));
-    UpdateAdjacencyInfo(edge_c_a, ti, adjacency_info);
+  // Generate adjacency info.
+  // Every triangle side (a, b) is bucketed by min(a, b) with a counting sort, then each bucket (at most 12 entries) is
+  // sorted by max(a, b). Both sides of an edge end up next to each other, edges are visited in (min, max) order and the
+  // whole pass is linear in the number of triangles.
+  const size_t old_vertex_count = vertices_.size();
+  std::vector<uint32_t> bucket_offsets(old_vertex_count + 1, 0);
+  for (const HexTriangle &t : triangles_) {
+    bucket_offsets[std::min(t.vertex_a, t.vertex_b) + 1]++;
+    bucket_offsets[std::min(t.vertex_b, t.vertex_c) + 1]++;
+    bucket_offsets[std::min(t.vertex_c, t.vertex_a) + 1]++;
+  }
+  for (size_t i = 0; i < old_vertex_count; i++) {
+    bucket_offsets[i + 1] += bucket_offsets[i];
   }
 
+  std::vector<HalfEdge> half_edges(bucket_offsets.back());
+  {
+    std::vector<uint32_t> next_slot(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    auto add_half_edge = [&](HexVertexId a, HexVertexId b, uint32_t triangle_index) {
+      half_edges[next_slot[std::min(a, b)]++] = {std::max(a, b), triangle_index};
+    };
+    for (uint32_t ti = 0; ti != triangles_.size(); ++ti) {
+      const HexTriangle &t = triangles_[ti];
+      add_half_edge(t.vertex_a, t.vertex_b, ti);
+      add_half_edge(t.vertex_b, t.vertex_c, ti);
+      add_half_edge(t.vertex_c, t.vertex_a, ti);
+    }
+  }
+
+  // Triangles were added in order, so a stable sort keeps the lower triangle index first on each edge.
+  parallel::For(old_vertex_count, thread_count_, [&](size_t vertex) {
+    std::stable_sort(half_edges.begin() + bucket_offsets[vertex], half_edges.begin() + bucket_offsets[vertex + 1],
+                     [](const HalfEdge &lhs, const HalfEdge &rhs) { return lhs.vertex < rhs.vertex; });
+  });
+
   // For each triangle in the old mesh, create a new vertex at the center
   // Since we know how many elements we will have, resize the vector ahead of time to avoid multiple allocations
-  triangles_.reserve(2 * triangles_.size());
-  for (HexTriangle &ti : triangles_) {
-    // Create a new vert at the center of the triangle
-    ti.tmp_.new_vertex_ = static_cast<uint32_t> (vertices_.size());
-    Eigen::Vector3f new_vertex = ti.GetCenter(vertices_);
+  vertices_.resize(old_vertex_count + triangles_.size(), HexVertex(Eigen::Vector3f::Zero()));
+  parallel::For(triangles_.size(), thread_count_, [this, old_vertex_count](size_t ti) {
+    HexTriangle &triangle = triangles_[ti];
 
-    // Add it to the list of hexes
-    vertices_.push_back(HexVertex(new_vertex));
-  }
+    // Create a new vert at the center of the triangle
+    triangle.tmp_.new_vertex_ = static_cast<uint32_t> (old_vertex_count + ti);
+    vertices_[old_vertex_count + ti].vertex_position = triangle.GetCenter(vertices_);
+  });
 
   // The new mesh that will be created
   std::vector<HexTriangle> new_hex_dual;
-  // As with the vertices, allocate the memory once
-  new_hex_dual.reserve(2 * adjacency_info.size());
+  // As with the vertices, allocate the memory once (every edge is shared by two triangles and yields two triangles)
+  new_hex_dual.reserve(half_edges.size());
 
   // For each edge, create two triangles
-  for (auto ei : adjacency_info) {
-    // Given edge A, B - with neighbour across edge
-    // First triangle is: A, center, neighbour's center
-    // Second triangle is: center, neighbour's center, B
-    if (ei.second.first == kInvalidHexVertexId || ei.second.second == kInvalidHexVertexId) {
-      std::cerr << "Error in adjacency info" << std::endl;
-      continue;
-    }
-
-    const uint32_t a = ei.first.first;
-    const uint32_t b = ei.first.second;
+  for (HexVertexId a = 0; a < old_vertex_count; a++) {
+    const uint32_t bucket_end = bucket_offsets[a + 1];
+    for (uint32_t i = bucket_offsets[a]; i < bucket_end;) {
+      const HexVertexId b = half_edges[i].vertex;
+
+      // Given edge A, B - with neighbour across edge
+      // First triangle is: A, center, neighbour's center
+      // Second triangle is: center, neighbour's center, B
+      if (i + 1 == bucket_end || half_edges[i + 1].vertex != b) {
+        std::cerr << "Error in adjacency info" << std::endl;
+        i++;
+        continue;
+      }
+      if (i + 2 < bucket_end && half_edges[i + 2].vertex == b) {
+        throw std::runtime_error("More than two triangles share an edge.");
+      }
 
-    HexTriangle *t = &triangles_[ei.second.first];
-    HexTriangle *ot = &triangles_[ei.second.second];
+      const HexTriangle &t = triangles_[half_edges[i].triangle];
+      const HexTriangle &ot = triangles_[half_edges[i + 1].triangle];
 
-    new_hex_dual.push_back(HexTriangle(a, t->tmp_.new_vertex_, ot->tmp_.new_vertex_));
-    new_hex_dual.push_back(HexTriangle(t->tmp_.new_vertex_, ot->tmp_.new_vertex_, b));
+      new_hex_dual.push_back(HexTriangle(a, t.tmp_.new_vertex_, ot.tmp_.new_vertex_));
+      new_hex_dual.push_back(HexTriangle(t.tmp_.new_vertex_, ot.tmp_.new_vertex_, b));
+      i += 2;
+    }
   }
 
   // Replace the current set of hexes with the dual
-  triangles_ = new_hex_dual;
+  triangles_ = std::move(new_hex_dual);
 
   // Project back to sphere (push out new vertices)
   ProjectToSphere();
@@ -340,36 +554,41 @@ void HexPlanet::Subdivide() {
 }
 
 void HexPlanet::ProjectToSphere() {
-  for (std::vector<HexVertex>::iterator ti = vertices_.begin(); ti != vertices_.end(); ++ti) {
-    Eigen::Vector3f p = (*ti).vertex_position;
-    p.normalize();
-    (*ti).vertex_position = p;
-  }
+  parallel::For(vertices_.size(), thread_count_, [this](size_t i) {
+    vertices_[i].vertex_position.normalize();
+  });
 }
 
-HexVertexId HexPlanet::HexVertexFromPoint(Eigen::Vector3f surface_position) {
-  HexVertexId best_hex = 0;
-  float best_dot;
-
-  // Normalize
-  surface_position.normalize();
-  best_dot = acosf(vertices_[0].vertex_position.dot(surface_position));
-
-  // Clever cheat -- just use the dot product to find the smallest angle -- and thus the containing hex
-  for (HexVertexId i = 1; i < vertices_.size(); i++) {
-    // Ensure that this stays between [-1, 1]
-    // Slight numerical error to get out of this range makes this d = nan
-    float dot = vertices_[i].vertex_position.dot(surface_position);
-    float clamped_dot = std::max(std::min(dot, 1.0f), -1.0f);
-    float d = acosf(clamped_dot);
-
-    if (d < best_dot) {
-      best_hex = i;
-      best_dot = d;
-    }
-  }
+HexVertexId HexPlanet::HexVertexFromPoint(Eigen::Vector3f surface_position) const {
+  return NearestVertex(surface_position);
+}
+
+HexVertexId HexPlanet::NearestVertex(const Eigen::Vector3f &point) const {
+  return vertex_index_.Nearest(point);
+}
+
+HexVertexId HexPlanet::NearestVertex(const GPSCoordinateFast &coordinate) const {
+  Eigen::Vector3f point;
+  standard_calc::CoordToPoint(coordinate, &point);
+  return NearestVertex(point);
+}
 
-  return best_hex;
+std::vector<HexVertexId> HexPlanet::NearestVertices(const std::vector<Eigen::Vector3f> &points,
+                                                    unsigned thread_count) const {
+  std::vector<HexVertexId> result(points.size());
+  parallel::For(points.size(), thread_count, [&](size_t i) {
+    result[i] = NearestVertex(points[i]);
+  });
+  return result;
+}
+
+std::vector<HexVertexId> HexPlanet::NearestVertices(const std::vector<GPSCoordinateFast> &coordinates,
+                                                    unsigned thread_count) const {
+  std::vector<HexVertexId> result(coordinates.size());
+  parallel::For(coordinates.size(), thread_count, [&](size_t i) {
+    result[i] = NearestVertex(coordinates[i]);
+  });
+  return result;
 }
 
 bool HexPlanet::RayHitPlanet(const Eigen::Vector3f &p, const Eigen::Vector3f &dir, Eigen::Vector3f *result) {
@@ -387,63 +606,135 @@ bool HexPlanet::RayHitPlanet(const Eigen::Vector3f &p, const Eigen::Vector3f &di
   }
 }
 
-uint32_t HexPlanet::DistanceBetweenVertices(HexVertexId source, HexVertexId target) {
+uint32_t HexPlanet::DistanceFromChord(double chord_squared) {
+  // With the chord length d between two unit vectors, the haversine of the central angle is (d / 2)^2.
+  const double a = std::min(chord_squared / 4, 1.0);
+  const double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+
+  // Simply drops the decimal precision, as standard_calc::DistBetweenTwoCoords does.
+  return static_cast<uint32_t> (sailbot::kEarthRadius * c);
+}
+
+uint32_t HexPlanet::DistanceBetweenVertices(HexVertexId source, HexVertexId target) const {
   if (source == target) {
     return 0;
   }
-  std::pair<HexVertexId, HexVertexId> key = {source, target};
-  // Check if the distance has already been computed.
-  auto search = vertex_distances_.find(key);
-  if (search != vertex_distances_.end()) {
-    // The distance already exists, return it.
-    return search->second;
-  } else {
-    // Compute the distance, save it, return it.
-    const GPSCoordinateFast &source_coord = vertices_[source].coordinate;
-    const GPSCoordinateFast &target_coord = vertices_[target].coordinate;
-    uint32_t distance = standard_calc::DistBetweenTwoCoords(source_coord, target_coord);
-    vertex_distances_.insert({key, distance});
-    return distance;
+  const double dx = unit_x_[source] - unit_x_[target];
+  const double dy = unit_y_[source] - unit_y_[target];
+  const double dz = unit_z_[source] - unit_z_[target];
+  return DistanceFromChord(dx * dx + dy * dy + dz * dz);
+}
+
+void HexPlanet::DistancesFromVertex(HexVertexId source, const std::vector<HexVertexId> &targets,
+                                    std::vector<uint32_t> *distances) const {
+  distances->resize(targets.size());
+  DistancesFromVertex(source, targets.data(), targets.size(), distances->data());
+}
+
+void HexPlanet::DistancesFromVertex(HexVertexId source, const HexVertexId *targets, size_t count,
+                                    uint32_t *distances) const {
+  const double x = unit_x_[source];
+  const double y = unit_y_[source];
+  const double z = unit_z_[source];
+  for (size_t i = 0; i < count; i++) {
+    // A zero chord gives a zero distance, so |source| itself needs no special case.
+    const double dx = unit_x_[targets[i]] - x;
+    const double dy = unit_y_[targets[i]] - y;
+    const double dz = unit_z_[targets[i]] - z;
+    distances[i] = DistanceFromChord(dx * dx + dy * dy + dz * dz);
   }
 }
 
+std::vector<uint32_t> HexPlanet::DistancesToVertex(HexVertexId target, unsigned thread_count) const {
+  std::vector<uint32_t> distances(vertices_.size());
+  const double x = unit_x_[target];
+  const double y = unit_y_[target];
+  const double z = unit_z_[target];
+  parallel::ForRange(vertices_.size(), thread_count, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      const double dx = unit_x_[i] - x;
+      const double dy = unit_y_[i] - y;
+      const double dz = unit_z_[i] - z;
+      distances[i] = DistanceFromChord(dx * dx + dy * dy + dz * dz);
+    }
+  });
+  distances[target] = 0;
+  return distances;
+}
+
+void HexPlanet::BuildQueryStructures() {
+  graph_ = HexGraph(vertices_);
+  vertex_index_ = HexVertexIndex(vertices_);
+
+  unit_x_.resize(vertices_.size());
+  unit_y_.resize(vertices_.size());
+  unit_z_.resize(vertices_.size());
+  parallel::For(vertices_.size(), thread_count_, [this](size_t i) {
+    const GPSCoordinateFast &coordinate = vertices_[i].coordinate;
+    const double cos_latitude = cos(coordinate.latitude());
+    unit_x_[i] = cos_latitude * cos(coordinate.longitude());
+    unit_y_[i] = cos_latitude * sin(coordinate.longitude());
+    unit_z_[i] = sin(coordinate.latitude());
+  });
+}
+
 void HexPlanet::ComputeVertexCoordinates() {
-  for (HexVertex &vertex : vertices_) {
+  parallel::For(vertices_.size(), thread_count_, [this](size_t i) {
+    HexVertex &vertex = vertices_[i];
     Eigen::Vector3f cartesian = vertex.normal();
     vertex.coordinate = standard_calc::PointToCoord(cartesian);
-  }
+  });
 }
 
 void HexPlanet::ComputeVertexNeighbours() {
-  std::vector<std::unordered_set<HexVertexId>> neighbour_map;
-  neighbour_map.reserve(vertices_.size());
-
+  // Index the triangles touching each vertex (in triangle order) so every vertex can be processed independently.
+  std::vector<uint32_t> vertex_triangle_offsets(vertices_.size() + 1, 0);
+  for (const auto &triangle : triangles_) {
+    vertex_triangle_offsets[triangle.vertex_a + 1]++;
+    vertex_triangle_offsets[triangle.vertex_b + 1]++;
+    vertex_triangle_offsets[triangle.vertex_c + 1]++;
+  }
   for (size_t i = 0; i < vertices_.size(); i++) {
-    neighbour_map.push_back(std::unordered_set<HexVertexId>(HexVertex::kMaxHexVertexNeighbourCount));
+    vertex_triangle_offsets[i + 1] += vertex_triangle_offsets[i];
   }
-
-  for (const auto &triangle : triangles_) {
-    // Neighbours of a
-    neighbour_map[triangle.vertex_a].insert(triangle.vertex_b);
-    neighbour_map[triangle.vertex_a].insert(triangle.vertex_c);
-    // Neighbours of b
-    neighbour_map[triangle.vertex_b].insert(triangle.vertex_a);
-    neighbour_map[triangle.vertex_b].insert(triangle.vertex_c);
-    // Neighbours of c
-    neighbour_map[triangle.vertex_c].insert(triangle.vertex_a);
-    neighbour_map[triangle.vertex_c].insert(triangle.vertex_b);
+  std::vector<uint32_t> vertex_triangles(vertex_triangle_offsets.back());
+  std::vector<uint32_t> next_slot(vertex_triangle_offsets.begin(), vertex_triangle_offsets.end() - 1);
+  for (uint32_t ti = 0; ti < triangles_.size(); ti++) {
+    const HexTriangle &triangle = triangles_[ti];
+    vertex_triangles[next_slot[triangle.vertex_a]++] = ti;
+    vertex_triangles[next_slot[triangle.vertex_b]++] = ti;
+    vertex_triangles[next_slot[triangle.vertex_c]++] = ti;
   }
 
-  for (HexVertexId i = 0; i < neighbour_map.size(); i++) {
+  parallel::For(vertices_.size(), thread_count_, [&](size_t vertex_index) {
+    const HexVertexId i = static_cast<HexVertexId>(vertex_index);
+    std::unordered_set<HexVertexId> neighbour_set(HexVertex::kMaxHexVertexNeighbourCount);
+
+    // Insert the other two vertices of each triangle in triangle order; the set (and thus the neighbour order) is the
+    // same as when walking over all triangles serially.
+    for (uint32_t slot = vertex_triangle_offsets[i]; slot < vertex_triangle_offsets[i + 1]; slot++) {
+      const HexTriangle &triangle = triangles_[vertex_triangles[slot]];
+      if (triangle.vertex_a == i) {
+        neighbour_set.insert(triangle.vertex_b);
+        neighbour_set.insert(triangle.vertex_c);
+      } else if (triangle.vertex_b == i) {
+        neighbour_set.insert(triangle.vertex_a);
+        neighbour_set.insert(triangle.vertex_c);
+      } else {
+        neighbour_set.insert(triangle.vertex_a);
+        neighbour_set.insert(triangle.vertex_b);
+      }
+    }
+
     // There mustn't be more than 6 neighbours for any vertex.
-    if (neighbour_map[i].size() > HexVertex::kMaxHexVertexNeighbourCount) {
+    if (neighbour_set.size() > HexVertex::kMaxHexVertexNeighbourCount) {
       throw std::runtime_error("There must not be more than 6 neighbours for any vertex.");
     }
 
     HexVertexId j = 0;
 
     // Populate the neighbours array with the candidates.
-    for (HexVertexId c : neighbour_map[i]) {
+    for (HexVertexId c : neighbour_set) {
       vertices_[i].neighbours[j] = c;
       j++;
     }
@@ -455,12 +746,13 @@ void HexPlanet::ComputeVertexNeighbours() {
     for (; j < HexVertex::kMaxHexVertexNeighbourCount; j++) {
       vertices_[i].neighbours[j] = kInvalidHexVertexId;
     }
-  }
+  });
 }
 
 void HexPlanet::ComputeIndirectVertexNeighbours(uint8_t depth) {
-  // TODO(areksredzki): Multithread!
-  for (HexVertexId id = 0; id < vertices_.size(); id++) {
+  // Each vertex only writes its own indirect neighbours and reads the (already computed) direct neighbours of others.
+  parallel::For(vertices_.size(), thread_count_, [this, depth](size_t vertex_index) {
+    const HexVertexId id = static_cast<HexVertexId>(vertex_index);
     HexVertex &vertex = vertices_[id];
 
     std::unordered_set<HexVertexId> neighbour_map;
@@ -480,18 +772,18 @@ void HexPlanet::ComputeIndirectVertexNeighbours(uint8_t depth) {
     for (size_t i = 0; i < vertex.neighbour_count; i++) {
       ComputeIndirectVertexNeighbourHelper(vertex, neighbour_map, vertex.neighbours[i], depth);
     }
-  }
+  });
 }
 
 void HexPlanet::ComputeIndirectVertexNeighbourHelper(HexVertex &vertex,
                                                      std::unordered_set<HexVertexId> &neighbour_map,
                                                      HexVertexId parent_id,
-                                                     uint8_t depth) {
+                                                     uint8_t depth) const {
   if (depth == 0) {
     return;
   }
 
-  HexVertex &neighbour = vertices_[parent_id];
+  const HexVertex &neighbour = vertices_[parent_id];
   for (size_t i = 0; i < neighbour.neighbour_count; i++) {
     HexVertexId indirect_neighbour_candidate = neighbour.neighbours[i];
     // If a neighbour candidate hasn't been seen before (isn't in the neighbour_map), then add it to
@@ -510,11 +802,12 @@ void HexPlanet::ComputeIndirectVertexNeighbourHelper(HexVertex &vertex,
 }
 
 void HexPlanet::ComputeVertexNeighbourDistances() {
-  for (HexVertex &vertex : vertices_) {
+  parallel::For(vertices_.size(), thread_count_, [this](size_t vertex_index) {
+    HexVertex &vertex = vertices_[vertex_index];
     for (size_t i = 0; i < vertex.neighbour_count; i++) {
       HexVertexId neighbour_id = vertex.neighbours[i];
       const HexVertex &target = vertices_[neighbour_id];
       vertex.neighbour_distances[i] = standard_calc::DistBetweenTwoCoords(vertex.coordinate, target.coordinate);
     }
-  }
+  });
 }
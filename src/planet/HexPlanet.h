@@ -7,16 +7,20 @@
 
 #include <vector>
 #include <array>
+#include <string>
 
 #include <Eigen/Dense>
 #include <unordered_set>
 #include <unordered_map>
-#include <boost/unordered_map.hpp>
 
 #include "datatypes/GPSCoordinate.h"
 #include "datatypes/GPSCoordinateFast.h"
 #include "datatypes/HexTriangle.h"
 #include "datatypes/HexVertex.h"
+#include "planet/HexGraph.h"
+#include "planet/HexVertexIndex.h"
+
+class MappedFile;
 
 /**
  * @brief A planet mesh in which most vertices have 6 neighbours, making it look like it's composed of hex tiles.
@@ -26,18 +30,26 @@ class HexPlanet {
  public:
   /// A pair of HexVertexId.
   typedef std::pair<HexVertexId, HexVertexId> HexVertexPair;
-  /// A mapping between edges (HexVertexPair) and a pair of triangles
-  typedef std::map<HexVertexPair, std::pair<uint32_t, uint32_t> > AdjacencyMap;
+
+  /// The default maximum depth for indirect neighbour calculation.
+  static constexpr uint8_t kDefaultIndirectNeighbourDepth = 2;
 
   /**
    * Create a HexPlanet with the given subdivision level.
+   * The per-vertex and per-triangle stages are spread over |thread_count| threads; the resulting planet is identical
+   * for any thread count.
    * @param subdivision_level The subdivision count.
    * @param indirect_neighbour_depth The depth with which indirect neighbours should be computed. 0 for none.
+   * @param thread_count The number of threads used to build the planet. 0 for one per hardware thread.
    */
-  explicit HexPlanet(uint8_t subdivision_level, uint8_t indirect_neighbour_depth = kDefaultIndirectNeighbourDepth);
+  explicit HexPlanet(uint8_t subdivision_level,
+                     uint8_t indirect_neighbour_depth = kDefaultIndirectNeighbourDepth,
+                     unsigned thread_count = 0);
 
   /**
    * Create a HexPlanet from a stored file.
+   * Binary files (see WriteBinaryToFile) are memory-mapped, anything else is parsed as the text format.
+   * @throw std::runtime_error If a binary file is malformed.
    */
   explicit HexPlanet(const std::string& stored_planet_filename);
 
@@ -68,6 +80,15 @@ class HexPlanet {
    */
   const HexTriangle &triangle(size_t triangle_index) const { return triangles_[triangle_index]; }
 
+  /**
+   * Compact adjacency of the planet, built once the planet is generated or read.
+   * Prefer this over vertex() when iterating over edges in hot loops.
+   * The graph is a copy of the adjacency in the vertices, which keep theirs for vertex() and the planet writers, so it
+   * adds graph().memory_usage() bytes to the planet.
+   * @return The planet's graph.
+   */
+  const HexGraph &graph() const { return graph_; }
+
   /**
    * Returns a point on the planet's surface given a ray
    * @param p Ray origin
@@ -83,17 +104,78 @@ class HexPlanet {
    * @param surface_position Position on the surface of the planet.
    * @return The index of the nearest hex.
    */
-  HexVertexId HexVertexFromPoint(Eigen::Vector3f surface_position);
+  HexVertexId HexVertexFromPoint(Eigen::Vector3f surface_position) const;
+
+  /**
+   * Find the vertex nearest to a point, using the planet's spatial index (O(log n) per query).
+   * Ties are broken towards the lower vertex ID.
+   * @param point Any non-zero point, it is projected onto the planet surface.
+   * @return The ID of the nearest vertex.
+   */
+  HexVertexId NearestVertex(const Eigen::Vector3f &point) const;
+
+  /**
+   * Find the vertex nearest to a GPS coordinate.
+   * @param coordinate Coordinate on the planet surface.
+   * @return The ID of the nearest vertex.
+   */
+  HexVertexId NearestVertex(const GPSCoordinateFast &coordinate) const;
+
+  /**
+   * Find the nearest vertex for each of many points.
+   * @param points Points to look up, see NearestVertex().
+   * @param thread_count The number of threads to use. 0 for one per hardware thread.
+   * @return The ID of the nearest vertex of each point, in the same order as |points|.
+   */
+  std::vector<HexVertexId> NearestVertices(const std::vector<Eigen::Vector3f> &points,
+                                           unsigned thread_count = 0) const;
 
   /**
-   * Get the distance (in meters) between two vertices as computed by the Haversine formula.
-   * @warning Use |vertex(source).neighbour_distances| when possible!
-   * Note: The results are cached for improved performance.
+   * Find the nearest vertex for each of many GPS coordinates.
+   * @param coordinates Coordinates to look up.
+   * @param thread_count The number of threads to use. 0 for one per hardware thread.
+   * @return The ID of the nearest vertex of each coordinate, in the same order as |coordinates|.
+   */
+  std::vector<HexVertexId> NearestVertices(const std::vector<GPSCoordinateFast> &coordinates,
+                                           unsigned thread_count = 0) const;
+
+  /**
+   * Get the great circle distance (in meters) between two vertices.
+   * This is the Haversine distance computed in closed form from the chord between the vertices' unit vectors. It
+   * doesn't cache anything, so it's safe to call from several threads.
+   * @warning Use graph().neighbour_distances() for direct neighbours when possible!
    * @param source Source vertex ID.
    * @param target Target vertex ID.
    * @return Distance in meters between source and target.
    */
-  uint32_t DistanceBetweenVertices(HexVertexId source, HexVertexId target);
+  uint32_t DistanceBetweenVertices(HexVertexId source, HexVertexId target) const;
+
+  /**
+   * Get the distances (in meters) from one vertex to many vertices, see DistanceBetweenVertices().
+   * @param source Source vertex ID.
+   * @param targets Target vertex IDs.
+   * @param distances Output, resized to the number of targets.
+   */
+  void DistancesFromVertex(HexVertexId source, const std::vector<HexVertexId> &targets,
+                           std::vector<uint32_t> *distances) const;
+
+  /**
+   * Get the distances (in meters) from one vertex to many vertices, see DistanceBetweenVertices().
+   * @param source Source vertex ID.
+   * @param targets Target vertex IDs.
+   * @param count The number of targets.
+   * @param distances Output, holding at least |count| distances.
+   */
+  void DistancesFromVertex(HexVertexId source, const HexVertexId *targets, size_t count, uint32_t *distances) const;
+
+  /**
+   * Get the distance (in meters) from every vertex to |target|, see DistanceBetweenVertices().
+   * Useful to precompute a heuristic once per query.
+   * @param target Target vertex ID.
+   * @param thread_count The number of threads to use. 0 for one per hardware thread.
+   * @return The distance from vertex i to |target| at index i.
+   */
+  std::vector<uint32_t> DistancesToVertex(HexVertexId target, unsigned thread_count = 0) const;
 
   /**
    * Write the planet mesh to an output file.
@@ -112,28 +194,69 @@ class HexPlanet {
    */
   void Read(std::istream &i);
 
+  /**
+   * Write the planet mesh to a binary file that can later be memory-mapped.
+   * The layout is described in planet/HexPlanetFormat.h.
+   * @param output_planet_filename name of output file
+   * @throw std::runtime_error If the file can't be written.
+   */
+  void WriteBinaryToFile(const std::string& output_planet_filename) const;
+
+  /**
+   * Write the planet mesh in the binary format to an output stream.
+   * @param o Target output stream
+   */
+  void WriteBinary(std::ostream &o) const;
+
+  /**
+   * Read the planet mesh from a memory-mapped binary file.
+   * @param file Mapped binary planet file.
+   * @throw std::runtime_error If the file is malformed.
+   */
+  void ReadBinary(const MappedFile &file);
+
+  /**
+   * @param filename Path of a stored planet.
+   * @return Whether the file is a binary planet file.
+   */
+  static bool IsBinaryFile(const std::string& filename);
+
   /// Vertices
   std::vector<HexVertex> vertices_;
   /// Triangles (and thus the edges)
   std::vector<HexTriangle> triangles_;
 
  protected:
-  /// The default maximum depth for indirect neighbour calculation.
-  static constexpr uint8_t kDefaultIndirectNeighbourDepth = 2;
   /// The maximum number of elements for a neighbour_map size of 19 for kDefaultIndirectNeighbourDepth.
   static constexpr uint8_t kDefaultIndirectNeighbourMapSize = 19;
 
   /// Current subdivision level (0 is an icosahedron).
   uint8_t subdivision_level_ = 0;
 
+  /// The number of threads used while building the planet (0 for one per hardware thread).
+  unsigned thread_count_ = 0;
+
+  /// Compact adjacency built from vertices_.
+  HexGraph graph_;
+
+  /// Nearest vertex lookup built from vertices_.
+  HexVertexIndex vertex_index_;
 
+  /// Unit vectors of the vertices computed in double precision from their coordinates, stored per axis.
+  std::vector<double> unit_x_;
+  std::vector<double> unit_y_;
+  std::vector<double> unit_z_;
 
   /**
-   * Distance cache.
-   * Stores the distance between two vertices keyed a source/target pair as computed by the Haversine formula.
-   * @warning this is not to be used for storing distances between direct neighbours.
+   * Build the query structures (graph, spatial index and unit vectors) once vertices_ is final.
    */
-  boost::unordered_map<HexVertexPair, uint32_t> vertex_distances_;
+  void BuildQueryStructures();
+
+  /**
+   * @param chord_squared Squared chord length between two points on the unit sphere.
+   * @return The great circle distance in meters (truncated).
+   */
+  static uint32_t DistanceFromChord(double chord_squared);
 
   /**
    * Builds the initial icosahedron (20 sided die).
@@ -186,20 +309,12 @@ class HexPlanet {
   void ComputeIndirectVertexNeighbourHelper(HexVertex &vertex,
                                             std::unordered_set<HexVertexId> &neighbour_map,
                                             HexVertexId parent_id,
-                                            uint8_t depth);
+                                            uint8_t depth) const;
 
   /**
    * Compute (and cache) the distance to the neighbours of each vertex.
    */
   void ComputeVertexNeighbourDistances();
-
-  /**
-   * Add one of two triangles that are associated with each edge.
-   * @param edge Edge to associate.
-   * @param triangle_index Triangle index to register.
-   * @param adjacency_map A map between edges and triangle pairs to update.
-   */
-  void UpdateAdjacencyInfo(const HexVertexPair &edge, uint32_t triangle_index, AdjacencyMap &adjacency_map);
 };
 
 #endif  // PLANET_HEXPLANET_H_
@@ -0,0 +1,71 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PLANET_HEXPLANETFORMAT_H_
+#define PLANET_HEXPLANETFORMAT_H_
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Layout of the binary HexPlanet cache.
+ *
+ * The file is a Header followed by flat, 8-byte aligned arrays stored in native (little-endian) byte order.
+ * Every array is located through its offset (in bytes from the start of the file) so that a memory-mapped file can be
+ * used without any per-vertex parsing. Indirect neighbours are packed in CSR form: the indirect neighbours of vertex i
+ * are indirect_neighbours[indirect_offsets[i], indirect_offsets[i + 1]).
+ */
+namespace hex_planet_format {
+
+/// Identifies a binary planet file.
+constexpr char kMagic[8] = {'H', 'E', 'X', 'P', 'L', 'N', 'T', '\0'};
+
+/// Bumped whenever the layout changes.
+constexpr uint32_t kVersion = 1;
+
+/// Alignment of each array in the file.
+constexpr uint64_t kAlignment = 8;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t subdivision_level;
+  uint64_t vertex_count;
+  uint64_t triangle_count;
+  uint64_t indirect_neighbour_count;
+  /// float[3 * vertex_count], unit vertex positions (x, y, z).
+  uint64_t positions_offset;
+  /// double[2 * vertex_count], (latitude, longitude) in radians.
+  uint64_t coordinates_offset;
+  /// uint32_t[vertex_count], number of valid direct neighbours.
+  uint64_t neighbour_counts_offset;
+  /// uint32_t[6 * vertex_count], direct neighbour IDs padded with kInvalidHexVertexId.
+  uint64_t neighbours_offset;
+  /// uint32_t[6 * vertex_count], distances in meters to the direct neighbours.
+  uint64_t neighbour_distances_offset;
+  /// uint64_t[vertex_count + 1], CSR offsets into the indirect neighbour array.
+  uint64_t indirect_offsets_offset;
+  /// uint32_t[indirect_neighbour_count], indirect neighbour IDs.
+  uint64_t indirect_neighbours_offset;
+  /// uint32_t[3 * triangle_count], triangle vertex IDs.
+  uint64_t triangles_offset;
+};
+
+/**
+ * @param offset Byte offset.
+ * @return |offset| rounded up to kAlignment.
+ */
+inline uint64_t Align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/**
+ * @param header Header read from the start of a file.
+ * @return Whether the header identifies a binary planet file of the current version.
+ */
+inline bool IsValidHeader(const Header &header) {
+  return std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion;
+}
+
+}  // namespace hex_planet_format
+
+#endif  // PLANET_HEXPLANETFORMAT_H_
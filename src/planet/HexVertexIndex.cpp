@@ -0,0 +1,89 @@
+// Copyright 2022 UBC Sailbot
+
+#include "planet/HexVertexIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+HexVertexIndex::HexVertexIndex(const std::vector<HexVertex> &vertices) {
+  nodes_.reserve(vertices.size());
+  for (HexVertexId id = 0; id < vertices.size(); id++) {
+    const Eigen::Vector3f &position = vertices[id].vertex_position;
+    nodes_.push_back({position.x(), position.y(), position.z(), id});
+  }
+  Build(0, nodes_.size(), 0);
+}
+
+void HexVertexIndex::Build(size_t begin, size_t end, int axis) {
+  // Iterate on the larger half and recurse on the smaller one to bound the stack depth.
+  while (end - begin > 1) {
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(nodes_.begin() + begin, nodes_.begin() + mid, nodes_.begin() + end,
+                     [axis](const Node &lhs, const Node &rhs) { return lhs.coordinate(axis) < rhs.coordinate(axis); });
+    const int next_axis = (axis + 1) % 3;
+    Build(begin, mid, next_axis);
+    begin = mid + 1;
+    axis = next_axis;
+  }
+}
+
+HexVertexId HexVertexIndex::Nearest(const Eigen::Vector3f &point) const {
+  if (nodes_.empty()) {
+    return kInvalidHexVertexId;
+  }
+
+  const Eigen::Vector3f query = point.normalized();
+  const float q[3] = {query.x(), query.y(), query.z()};
+
+  HexVertexId best_id = kInvalidHexVertexId;
+  float best_distance = std::numeric_limits<float>::infinity();
+
+  // Subtrees still to be searched, along with the squared distance from the query to their splitting plane.
+  // The tree is balanced, so its depth is at most 64 and every level adds at most one deferred subtree.
+  struct Range {
+    size_t begin, end;
+    int axis;
+    float plane_distance;
+  };
+  Range stack[64];
+  size_t stack_size = 0;
+  stack[stack_size++] = {0, nodes_.size(), 0, 0.0f};
+
+  while (stack_size > 0) {
+    Range range = stack[--stack_size];
+    if (range.plane_distance > best_distance) {
+      continue;
+    }
+
+    while (range.begin < range.end) {
+      const size_t mid = range.begin + (range.end - range.begin) / 2;
+      const Node &node = nodes_[mid];
+
+      const float dx = node.x - q[0];
+      const float dy = node.y - q[1];
+      const float dz = node.z - q[2];
+      const float distance = dx * dx + dy * dy + dz * dz;
+      if (distance < best_distance || (distance == best_distance && node.id < best_id)) {
+        best_distance = distance;
+        best_id = node.id;
+      }
+
+      // Descend into the side containing the query, and defer the other side.
+      const float delta = q[range.axis] - node.coordinate(range.axis);
+      const int next_axis = (range.axis + 1) % 3;
+      Range near_side = {range.begin, mid, next_axis, 0.0f};
+      Range far_side = {mid + 1, range.end, next_axis, delta * delta};
+      if (delta > 0) {
+        std::swap(near_side.begin, far_side.begin);
+        std::swap(near_side.end, far_side.end);
+      }
+      if (far_side.begin < far_side.end && far_side.plane_distance <= best_distance) {
+        stack[stack_size++] = far_side;
+      }
+      range = near_side;
+    }
+  }
+
+  return best_id;
+}
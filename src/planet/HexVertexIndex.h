@@ -0,0 +1,68 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PLANET_HEXVERTEXINDEX_H_
+#define PLANET_HEXVERTEXINDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "datatypes/HexDefs.h"
+#include "datatypes/HexVertex.h"
+
+/**
+ * @brief Nearest vertex lookup for a HexPlanet.
+ *
+ * A static, balanced k-d tree over the vertex positions (unit vectors). The tree is stored implicitly: the node of the
+ * range [begin, end) is at the middle of the range and splits on axis (depth % 3), so no child pointers are needed.
+ * Since all vertices lie on the unit sphere, the vertex with the smallest Euclidean distance to a direction is also
+ * the one with the smallest angle to it.
+ */
+class HexVertexIndex {
+ public:
+  HexVertexIndex() = default;
+
+  /**
+   * Build the index over the positions of |vertices|.
+   * @param vertices Vertices of the planet, projected onto the unit sphere.
+   */
+  explicit HexVertexIndex(const std::vector<HexVertex> &vertices);
+
+  /**
+   * Find the vertex closest to a direction. Ties are broken towards the lower vertex ID.
+   * @param point Any non-zero point, it is projected onto the unit sphere.
+   * @return The ID of the nearest vertex, or kInvalidHexVertexId if the index is empty.
+   */
+  HexVertexId Nearest(const Eigen::Vector3f &point) const;
+
+  /**
+   * @return The number of vertices in the index.
+   */
+  size_t size() const { return nodes_.size(); }
+
+  /**
+   * @return The memory used by the index in bytes.
+   */
+  size_t memory_usage() const { return nodes_.capacity() * sizeof(Node); }
+
+ private:
+  struct Node {
+    float x, y, z;
+    HexVertexId id;
+
+    float coordinate(int axis) const { return axis == 0 ? x : (axis == 1 ? y : z); }
+  };
+
+  /**
+   * Arrange nodes_[begin, end) into an implicit k-d subtree.
+   */
+  void Build(size_t begin, size_t end, int axis);
+
+  /// Nodes in implicit k-d tree order.
+  std::vector<Node> nodes_;
+};
+
+#endif  // PLANET_HEXVERTEXINDEX_H_
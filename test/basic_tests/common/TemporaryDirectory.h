@@ -0,0 +1,64 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef COMMON_TEMPORARYDIRECTORY_H_
+#define COMMON_TEMPORARYDIRECTORY_H_
+
+#include <dirent.h>
+#include <stdlib.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+/**
+ * A fresh directory under /tmp for the files written by a test, removed along with its contents on destruction, so
+ * tests neither depend on nor litter the current directory.
+ */
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory() {
+    char path[] = "/tmp/sailbot_testXXXXXX";
+    if (mkdtemp(path) == nullptr) {
+      throw std::runtime_error("Unable to create a temporary directory");
+    }
+    path_ = path;
+  }
+
+  ~TemporaryDirectory() { RemoveAll(path_); }
+
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+  /**
+   * @return The path of the directory.
+   */
+  const std::string &path() const { return path_; }
+
+  /**
+   * @param name A file name.
+   * @return The path of |name| in the directory.
+   */
+  std::string path(const std::string &name) const { return path_ + "/" + name; }
+
+ private:
+  std::string path_;
+
+  /**
+   * Removes |path|, recursing into directories.
+   */
+  static void RemoveAll(const std::string &path) {
+    DIR *dir = opendir(path.c_str());
+    if (dir != nullptr) {
+      while (dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+          RemoveAll(path + "/" + name);
+        }
+      }
+      closedir(dir);
+    }
+    std::remove(path.c_str());
+  }
+};
+
+#endif  // COMMON_TEMPORARYDIRECTORY_H_
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Writes the small GRIB2 wind fixtures of the tests, so they don't need a forecast download.
+
+Each message holds one wind component (10u or 10v) at one forecast step on a regular one degree latitude/longitude
+grid, scanned in rows of increasing latitude, simple packed with a resolution of 1/8 m/s. Values are exact multiples
+of 1/8, so the tests can recompute them. Run from this directory: python3 make_grib_fixtures.py
+"""
+
+import math
+import struct
+
+# GRIB2 parameter numbers of the wind components (discipline 0, category 2).
+PARAMETER_NUMBERS = {'u': 2, 'v': 3}
+# Values are packed as multiples of 2^-BINARY_SCALE.
+BINARY_SCALE = 3
+MISSING = 0xFFFFFFFF
+
+
+def signed(value, octets):
+    """GRIB2 signed integers are in sign and magnitude form."""
+    sign = 1 << (8 * octets - 1)
+    return (sign | -value) if value < 0 else value
+
+
+def section(number, payload):
+    return struct.pack('>IB', 5 + len(payload), number) + payload
+
+
+def message(component, step, south, west, lat_count, lon_count, values):
+    point_count = lat_count * lon_count
+    assert len(values) == point_count
+
+    identification = struct.pack('>HHBBBHBBBBBBB', 7, 0, 2, 0, 1, 2017, 7, 14, 0, 0, 0, 0, 1)
+    grid = struct.pack('>BIBBH', 0, point_count, 0, 0, 0) + struct.pack(
+        '>BBIBIBIIIIIiiBiiIIB',
+        6, 0, 0, 0, 0, 0, 0,                      # Spherical earth of radius 6371229 m
+        lon_count, lat_count, 0, MISSING,         # Ni, Nj, basic angle (microdegrees)
+        south * 10**6, west * 10**6, 0x30,        # La1, Lo1, increments given
+        (south + lat_count - 1) * 10**6, (west + lon_count - 1) * 10**6,
+        10**6, 10**6, 0x40)                       # Di, Dj, rows of increasing latitude
+    product = struct.pack('>HH', 0, 0) + struct.pack(
+        '>BBBBBHBBIBBIBBI',
+        2, PARAMETER_NUMBERS[component], 2, 0, 0, 0, 0,
+        1, step,                                  # Forecast time in hours
+        103, 0, 10,                               # 10 m above ground
+        255, 255, MISSING)
+
+    scaled = [int(round(value * 2**BINARY_SCALE)) for value in values]
+    assert all(abs(x - value * 2**BINARY_SCALE) < 1e-9 for x, value in zip(scaled, values))
+    reference = min(scaled)
+    bits = max(1, math.ceil(math.log2(max(scaled) - reference + 1)))
+    # Values are Y = R + X * 2^E, with the reference value R the smallest one and E = -BINARY_SCALE.
+    representation = struct.pack('>IH', point_count, 0) + struct.pack(
+        '>fHHBB', reference / 2**BINARY_SCALE, signed(-BINARY_SCALE, 2), 0, bits, 0)
+
+    packed = 0
+    for x in scaled:
+        packed = (packed << bits) | (x - reference)
+    padding = -(bits * point_count) % 8
+    data = (packed << padding).to_bytes((bits * point_count + padding) // 8, 'big')
+
+    body = (section(1, identification) + section(3, grid) + section(4, product) + section(5, representation) +
+            section(6, struct.pack('>B', 255)) + section(7, data) + b'7777')
+    return b'GRIB' + struct.pack('>HBBQ', 0xFFFF, 0, 2, 16 + len(body)) + body
+
+
+def grid(south, west, lat_count, lon_count, value):
+    """The values of value(lat, lon) over the grid, in scanning order."""
+    return [value(south + j, west + i) for j in range(lat_count) for i in range(lon_count)]
+
+
+def wind_steps():
+    """Steps out of order, 3 without v and 18 without u: only 0, 6, 12 and 24 have both components."""
+    def u(step):
+        return lambda lat, lon: step / 2 + (lat - 30) * 0.25 + (lon - 220) * 0.125
+
+    def v(step):
+        return lambda lat, lon: -1 - step / 4 - (lon - 220) * 0.125
+
+    components = {'u': u, 'v': v}
+    order = [('v', 12), ('u', 6), ('u', 3), ('u', 0), ('v', 6), ('v', 18), ('u', 12), ('v', 0), ('u', 24), ('v', 24)]
+    return b''.join(message(c, step, 30, 220, 2, 3, grid(30, 220, 2, 3, components[c](step))) for c, step in order)
+
+
+def wind_region():
+    """Four steps over the N48 S21 E235 W203 region of the pathfinding tests."""
+    def u(step):
+        return lambda lat, lon: (lat - 30) * 0.5 + step / 6
+
+    def v(step):
+        return lambda lat, lon: (lon - 220) * 0.25 - step / 12
+
+    return b''.join(message(c, step, 21, 203, 28, 33, grid(21, 203, 28, 33, (u if c == 'u' else v)(step)))
+                    for step in (0, 6, 12, 18) for c in ('u', 'v'))
+
+
+def wind_antimeridian():
+    """One step over [0, 2] x [178, 182] degrees, across the antimeridian."""
+    return (message('u', 0, 0, 178, 3, 5, grid(0, 178, 3, 5, lambda lat, lon: 2 + (lon - 178))) +
+            message('v', 0, 0, 178, 3, 5, grid(0, 178, 3, 5, lambda lat, lon: 1 + lat)))
+
+
+if __name__ == '__main__':
+    for name, contents in (('wind_steps.grb', wind_steps()), ('wind_region.grb', wind_region()),
+                           ('wind_antimeridian.grb', wind_antimeridian())):
+        with open(name, 'wb') as f:
+            f.write(contents)
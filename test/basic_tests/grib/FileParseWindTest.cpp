@@ -4,8 +4,78 @@
 #include "grib/gribParse.h"
 #include <eccodes.h>
 #include <math.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "common/TemporaryDirectory.h"
 // #include "grib/windFileParse.h"
 
+namespace {
+
+/**
+ * @return The path of the test fixture |name|.
+ */
+std::string TestData(const std::string &name) {
+    return std::string(TEST_DATA_DIRECTORY) + "/" + name;
+}
+
+/**
+ * @return The longitude |lon| in [0, 360).
+ */
+double PositiveLongitude(double lon) {
+    return lon < 0 ? lon + 360 : lon;
+}
+
+/**
+ * The u wind component of wind_steps.grb, see make_grib_fixtures.py.
+ */
+double StepsU(int64_t step, double lat, double lon) {
+    return step / 2.0 + (lat - 30) * 0.25 + (PositiveLongitude(lon) - 220) * 0.125;
+}
+
+/**
+ * The v wind component of wind_steps.grb.
+ */
+double StepsV(int64_t step, double lon) {
+    return -1 - step / 4.0 - (PositiveLongitude(lon) - 220) * 0.125;
+}
+
+/**
+ * @return The (lat, lon) centre of each arrow of the wind KML |file_name|, in file order.
+ */
+std::vector<std::pair<double, double>> KmlArrowCenters(const std::string &file_name) {
+    std::ifstream file(file_name);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    const std::string kml = contents.str();
+    auto value_after = [&kml](const std::string &tag, size_t from) {
+        return std::stod(kml.substr(kml.find(tag, from) + tag.size()));
+    };
+
+    std::vector<std::pair<double, double>> centers;
+    for (size_t box = kml.find("<LatLonBox>"); box != std::string::npos; box = kml.find("<LatLonBox>", box + 1)) {
+        centers.emplace_back((value_after("<north>", box) + value_after("<south>", box)) / 2,
+                             (value_after("<east>", box) + value_after("<west>", box)) / 2);
+    }
+    return centers;
+}
+
+/**
+ * Expects |centers| to be at |expected| (lat, lon) positions.
+ */
+void ExpectCenters(const std::vector<std::pair<double, double>> &expected,
+                   const std::vector<std::pair<double, double>> &centers) {
+    ASSERT_EQ(expected.size(), centers.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_NEAR(expected[i].first, centers[i].first, 1e-3);
+        EXPECT_NEAR(expected[i].second, centers[i].second, 1e-3);
+    }
+}
+
+}  // namespace
+
 WindGribParseTest::WindGribParseTest() {}
 
 TEST_F(WindGribParseTest, TestMagnitude) {
@@ -50,3 +120,95 @@ TEST_F(WindGribParseTest, TestAngle) {
     // 0 division 0 case
     EXPECT_EQ(true, isnan(gribParse::calcAngle(0, 0)));
 }
+
+TEST_F(WindGribParseTest, TestParameterOf) {
+    EXPECT_EQ(gribParse::kWind, gribParse::parameterOf("10u"));
+    EXPECT_EQ(gribParse::kWind, gribParse::parameterOf("10v"));
+    EXPECT_EQ(gribParse::kCape, gribParse::parameterOf("cape"));
+    EXPECT_EQ(gribParse::kPressure, gribParse::parameterOf("prmsl"));
+    EXPECT_EQ(0u, gribParse::parameterOf("unknown"));
+    // Names shared by several levels are ambiguous.
+    EXPECT_EQ(0u, gribParse::parameterOf("u"));
+    EXPECT_EQ(0u, gribParse::parameterOf("t"));
+}
+
+TEST_F(WindGribParseTest, TestStepOf) {
+    EXPECT_EQ(0, gribParse::stepOf("0"));
+    EXPECT_EQ(6, gribParse::stepOf("6"));
+    EXPECT_EQ(6, gribParse::stepOf("0-6"));
+    EXPECT_EQ(120, gribParse::stepOf("114-120"));
+}
+
+TEST_F(WindGribParseTest, TestConvertWind) {
+    std::vector<double> u_comp = {10, 1000, -100, 0.514444, -3.5, 7, 0, 0, 1e-12};
+    std::vector<double> v_comp = {10, 100, -600, 0, 2.25, -12, 5, -5, 30};
+    // Directions all around the circle, across the ranges the atan approximation is split into
+    for (int i = 0; i < 3600; i++) {
+        u_comp.push_back(25 * std::cos(i * PI / 1800));
+        v_comp.push_back(25 * std::sin(i * PI / 1800));
+    }
+    std::vector<double> magnitudes(u_comp.size());
+    std::vector<double> angles(u_comp.size());
+
+    gribParse::convertWind(u_comp.data(), v_comp.data(), u_comp.size(), magnitudes.data(), angles.data());
+
+    for (size_t i = 0; i < u_comp.size(); i++) {
+        EXPECT_DOUBLE_EQ(gribParse::calcMagnitude(u_comp[i], v_comp[i]), magnitudes[i]);
+        EXPECT_NEAR(gribParse::calcAngle(u_comp[i], v_comp[i]), angles[i], 1e-12) << u_comp[i] << ", " << v_comp[i];
+    }
+}
+
+TEST_F(WindGribParseTest, TestDecodesPairedSteps) {
+    // Steps 0, 6, 12 and 24 have both wind components. They are out of order, with an unpaired u at 3 and v at 18.
+    const gribParse three_steps(TestData("wind_steps.grb"), 3);
+    EXPECT_EQ((std::vector<int64_t>{0, 6, 12}), three_steps.steps);
+    const gribParse all_steps(TestData("wind_steps.grb"), 8);
+    EXPECT_EQ((std::vector<int64_t>{0, 6, 12, 24}), all_steps.steps);
+
+    for (const gribParse *parsed : {&three_steps, &all_steps}) {
+        ASSERT_EQ(6, parsed->number_of_points_);
+        EXPECT_DOUBLE_EQ(30, parsed->lats[0]);
+        EXPECT_DOUBLE_EQ(31, parsed->lats[5]);
+        EXPECT_DOUBLE_EQ(-140, parsed->lons[0]);
+        EXPECT_DOUBLE_EQ(-138, parsed->lons[5]);
+        for (size_t i = 0; i < parsed->steps.size(); i++) {
+            for (int j = 0; j < parsed->number_of_points_; j++) {
+                const double u = StepsU(parsed->steps[i], parsed->lats[j], parsed->lons[j]);
+                const double v = StepsV(parsed->steps[i], parsed->lons[j]);
+                EXPECT_DOUBLE_EQ(gribParse::calcMagnitude(u, v), parsed->magnitudes[i][j]);
+                EXPECT_DOUBLE_EQ(gribParse::calcAngle(u, v), parsed->angles[i][j]);
+            }
+        }
+    }
+}
+
+TEST_F(WindGribParseTest, TestKmlDecimation) {
+    // A 3 x 5 grid over [0, 2] x [178, 182] degrees, so longitudes wrap from 180 to -179.
+    TemporaryDirectory directory;
+    const std::string kml = directory.path("Wind.kml");
+    const gribParse parsed(TestData("wind_antimeridian.grb"), 1);
+    ASSERT_EQ(15, parsed.number_of_points_);
+
+    // Every other row and column.
+    WindKmlOptions options;
+    options.stride = 2;
+    parsed.saveKML(options, kml);
+    ExpectCenters({{0, 178}, {0, 180}, {0, -178}, {2, 178}, {2, 180}, {2, -178}}, KmlArrowCenters(kml));
+
+    // Only the points with at least the wind speed at (1, 180), where u = 4 and v = 2.
+    options.stride = 1;
+    options.min_wind_speed = gribParse::calcMagnitude(4, 2);
+    parsed.saveKML(options, kml);
+    std::vector<std::pair<double, double>> expected;
+    for (int lat = 0; lat <= 2; lat++) {
+        for (int lon = 178; lon <= 182; lon++) {
+            const double u = 2 + (lon - 178);
+            const double v = 1 + lat;
+            if (u * u + v * v >= 4 * 4 + 2 * 2) {
+                expected.emplace_back(lat, standard_calc::BoundTo180(lon));
+            }
+        }
+    }
+    EXPECT_EQ(8u, expected.size());
+    ExpectCenters(expected, KmlArrowCenters(kml));
+}
@@ -0,0 +1,264 @@
+// Copyright 2022 UBC Sailbot
+
+#include "UrlDownloaderTest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include "grib/UrlDownloader.h"
+
+namespace {
+
+bool FileExists(const std::string &file_name) {
+  struct stat file_stat;
+  return stat(file_name.c_str(), &file_stat) == 0;
+}
+
+/**
+ * @return A strong ETag of |body|.
+ */
+std::string ETagOf(const std::string &body) {
+  return "\"" + std::to_string(std::hash<std::string>()(body)) + "\"";
+}
+
+}  // namespace
+
+UrlDownloaderTest::UrlDownloaderTest()
+    : honor_ranges_(true),
+      modified_(true),
+      interrupt_after_(-1),
+      request_count_(0),
+      last_range_start_(-1),
+      body_("GRIB forecast data standing in for a real GRIB file") {
+  listen_socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = 0;
+  socklen_t address_length = sizeof(address);
+  bind(listen_socket_, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+  listen(listen_socket_, 4);
+  getsockname(listen_socket_, reinterpret_cast<sockaddr *>(&address), &address_length);
+  port_ = ntohs(address.sin_port);
+  server_ = std::thread(&UrlDownloaderTest::Serve, this);
+}
+
+UrlDownloaderTest::~UrlDownloaderTest() {
+  // Wakes up accept()
+  shutdown(listen_socket_, SHUT_RDWR);
+  server_.join();
+  close(listen_socket_);
+}
+
+std::string UrlDownloaderTest::Body() const {
+  std::lock_guard<std::mutex> lock(body_mutex_);
+  return body_;
+}
+
+void UrlDownloaderTest::SetBody(const std::string &body) {
+  std::lock_guard<std::mutex> lock(body_mutex_);
+  body_ = body;
+}
+
+std::string UrlDownloaderTest::ETag() const {
+  return ETagOf(Body());
+}
+
+std::string UrlDownloaderTest::Url(const std::string &path) const {
+  return "http://127.0.0.1:" + std::to_string(port_) + path;
+}
+
+std::string UrlDownloaderTest::ReadFile(const std::string &file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+void UrlDownloaderTest::WriteFile(const std::string &file_name, const std::string &contents) {
+  std::ofstream(file_name, std::ios::binary) << contents;
+}
+
+void UrlDownloaderTest::Serve() {
+  int connection;
+  while ((connection = accept(listen_socket_, nullptr, nullptr)) >= 0) {
+    Respond(connection);
+    close(connection);
+  }
+}
+
+void UrlDownloaderTest::Respond(int connection) {
+  std::string request;
+  char buffer[1024];
+  while (request.find("\r\n\r\n") == std::string::npos) {
+    ssize_t received = recv(connection, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      return;
+    }
+    request.append(buffer, static_cast<size_t>(received));
+  }
+  request_count_++;
+
+  const size_t range = request.find("\r\nRange: bytes=");
+  last_range_start_ = range == std::string::npos ? -1 : std::atol(request.c_str() + range + 15);
+
+  // A range is only for the version of the file named by If-Range, if any
+  const std::string body = Body();
+  const std::string etag = ETagOf(body);
+  const size_t if_range = request.find("\r\nIf-Range: ");
+  const bool range_applies = last_range_start_ >= 0 && honor_ranges_ &&
+      (if_range == std::string::npos || request.compare(if_range + 12, etag.size() + 2, etag + "\r\n") == 0);
+
+  std::string status = "200 OK";
+  std::string headers = "ETag: " + etag + "\r\n";
+  std::string content = body;
+  if (request.compare(0, 19, "GET /forecast.grb H") != 0) {
+    status = "404 Not Found";
+    headers.clear();
+    content.clear();
+  } else if (request.find("If-Modified-Since:") != std::string::npos && !modified_) {
+    status = "304 Not Modified";
+    content.clear();
+  } else if (range_applies) {
+    const size_t start = static_cast<size_t>(last_range_start_);
+    if (start >= body.size()) {
+      status = "416 Range Not Satisfiable";
+      headers += "Content-Range: bytes */" + std::to_string(body.size()) + "\r\n";
+      content.clear();
+    } else {
+      status = "206 Partial Content";
+      headers += "Content-Range: bytes " + std::to_string(start) + "-" + std::to_string(body.size() - 1) + "/" +
+          std::to_string(body.size()) + "\r\n";
+      content = body.substr(start);
+    }
+  }
+
+  std::string response = "HTTP/1.1 " + status + "\r\n" + headers + "Content-Length: " +
+      std::to_string(content.size()) + "\r\nConnection: close\r\n\r\n";
+  const long interrupt_after = interrupt_after_;  // NOLINT(runtime/int)
+  response += interrupt_after >= 0 ? content.substr(0, static_cast<size_t>(interrupt_after)) : content;
+  send(connection, response.data(), response.size(), MSG_NOSIGNAL);
+}
+
+TEST_F(UrlDownloaderTest, DownloadsAtomicallyTest) {
+  const std::string file_name = directory_.path("data.grb");
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(Body(), ReadFile(file_name));
+  EXPECT_FALSE(FileExists(file_name + ".part"));
+  EXPECT_EQ(-1, last_range_start_);
+
+  // Failed downloads throw and leave no file behind.
+  EXPECT_THROW(UrlDownloader::Download(Url("/missing.grb"), directory_.path("missing.grb")), std::runtime_error);
+  EXPECT_FALSE(FileExists(directory_.path("missing.grb")));
+  EXPECT_FALSE(FileExists(directory_.path("missing.grb.part")));
+}
+
+TEST_F(UrlDownloaderTest, ResumesPartialDownloadTest) {
+  const std::string file_name = directory_.path("data.grb");
+  interrupt_after_ = 10;
+  EXPECT_THROW(UrlDownloader::Download(Url(), file_name), std::runtime_error);
+  EXPECT_FALSE(FileExists(file_name));
+  EXPECT_EQ(Body().substr(0, 10), ReadFile(file_name + ".part"));
+
+  interrupt_after_ = -1;
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(10, last_range_start_);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+  EXPECT_FALSE(FileExists(file_name + ".part"));
+  EXPECT_FALSE(FileExists(file_name + ".part.validator"));
+}
+
+TEST_F(UrlDownloaderTest, RestartsChangedDownloadTest) {
+  const std::string file_name = directory_.path("data.grb");
+  interrupt_after_ = 10;
+  EXPECT_THROW(UrlDownloader::Download(Url(), file_name), std::runtime_error);
+
+  // The server generated a different file since, which isn't appended to the old part.
+  interrupt_after_ = -1;
+  SetBody("A different GRIB file generated for the next request");
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(10, last_range_start_);
+  EXPECT_EQ(2, request_count_);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+}
+
+TEST_F(UrlDownloaderTest, RestartsUnresumableDownloadTest) {
+  const std::string file_name = directory_.path("data.grb");
+
+  // Without a validator, the part file can't be resumed.
+  WriteFile(file_name + ".part", "stale");
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(-1, last_range_start_);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+
+  // The server sends the whole file.
+  honor_ranges_ = false;
+  WriteFile(file_name + ".part", "stale");
+  WriteFile(file_name + ".part.validator", ETag());
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(5, last_range_start_);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+
+  // The partial file is already complete, so the range can't be satisfied.
+  honor_ranges_ = true;
+  request_count_ = 0;
+  WriteFile(file_name + ".part", Body());
+  WriteFile(file_name + ".part.validator", ETag());
+  EXPECT_TRUE(UrlDownloader::Download(Url(), file_name));
+  EXPECT_EQ(2, request_count_);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+}
+
+TEST_F(UrlDownloaderTest, CachesForecastCycleTest) {
+  const std::string cache_directory = directory_.path("cache");
+  const std::time_t now = 1500000000;  // 2017-07-14 02:40 UTC
+
+  const std::string file_name = UrlDownloader::CachedDownload(Url(), "N48_S21_E235_W203", now, cache_directory);
+  EXPECT_EQ(cache_directory + "/N48_S21_E235_W203-2017071400.grb", file_name);
+  EXPECT_EQ(Body(), ReadFile(file_name));
+  EXPECT_EQ(1, request_count_);
+
+  // Later in the same cycle, the cached file is used without a request.
+  EXPECT_EQ(file_name, UrlDownloader::CachedDownload(Url(), "N48_S21_E235_W203", now + 3600, cache_directory));
+  EXPECT_EQ(1, request_count_);
+
+  // Other regions are cached separately.
+  EXPECT_NE(file_name, UrlDownloader::CachedDownload(Url(), "N10_S0_E10_W0", now, cache_directory));
+  EXPECT_EQ(2, request_count_);
+}
+
+TEST_F(UrlDownloaderTest, ReusesUnmodifiedForecastTest) {
+  const std::string cache_directory = directory_.path("cache");
+  const std::time_t now = 1500000000;
+  const std::string previous_body = Body();
+  const std::string previous_file_name =
+      UrlDownloader::CachedDownload(Url(), "region", now - 6 * 3600, cache_directory);
+
+  // The next cycle isn't published yet, so the previous file is kept.
+  modified_ = false;
+  SetBody("newer forecast");
+  const std::string file_name = UrlDownloader::CachedDownload(Url(), "region", now, cache_directory);
+  EXPECT_EQ(2, request_count_);
+  EXPECT_NE(previous_file_name, file_name);
+  EXPECT_EQ(previous_body, ReadFile(file_name));
+  EXPECT_FALSE(FileExists(previous_file_name));
+
+  // Once published, the next cycle is downloaded and replaces the previous file.
+  modified_ = true;
+  EXPECT_EQ(Body(), ReadFile(UrlDownloader::CachedDownload(Url(), "region", now + 6 * 3600, cache_directory)));
+  EXPECT_FALSE(FileExists(file_name));
+}
+
+TEST_F(UrlDownloaderTest, ForecastCycleTest) {
+  EXPECT_EQ("1970010100", UrlDownloader::ForecastCycle(0));
+  EXPECT_EQ("2017071400", UrlDownloader::ForecastCycle(1500000000));
+  EXPECT_EQ("2017071406", UrlDownloader::ForecastCycle(1500000000 + 4 * 3600));
+}
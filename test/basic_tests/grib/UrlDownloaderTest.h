@@ -0,0 +1,77 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef GRIB_URLDOWNLOADERTEST_H_
+#define GRIB_URLDOWNLOADERTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "common/TemporaryDirectory.h"
+
+/**
+ * Serves Body() over HTTP on a local port, standing in for the forecast server.
+ */
+class UrlDownloaderTest : public ::testing::Test {
+ protected:
+  UrlDownloaderTest();
+  ~UrlDownloaderTest() override;
+
+  /// Whether range requests are answered with partial content, or ignored.
+  std::atomic<bool> honor_ranges_;
+  /// Whether conditional requests are answered with the body, or 304 Not Modified.
+  std::atomic<bool> modified_;
+  /// The number of body bytes sent before dropping the connection, -1 to send the whole body.
+  std::atomic<long> interrupt_after_;  // NOLINT(runtime/int)
+  /// The number of requests served.
+  std::atomic<int> request_count_;
+  /// The start of the last requested range, -1 if the last request had no range.
+  std::atomic<long> last_range_start_;  // NOLINT(runtime/int)
+  /// Temporary directory for downloaded files.
+  TemporaryDirectory directory_;
+
+  /**
+   * @return The served file.
+   */
+  std::string Body() const;
+
+  /**
+   * Replaces the served file with |body|, which changes its ETag.
+   */
+  void SetBody(const std::string &body);
+
+  /**
+   * @return The ETag of the served file.
+   */
+  std::string ETag() const;
+
+  /**
+   * @return The URL of |path| on the server.
+   */
+  std::string Url(const std::string &path = "/forecast.grb") const;
+
+  /**
+   * @return The contents of |file_name|.
+   */
+  static std::string ReadFile(const std::string &file_name);
+
+  /**
+   * Writes |contents| to |file_name|.
+   */
+  static void WriteFile(const std::string &file_name, const std::string &contents);
+
+ private:
+  mutable std::mutex body_mutex_;
+  std::string body_;
+  int listen_socket_;
+  int port_;
+  std::thread server_;
+
+  void Serve();
+  void Respond(int connection);
+};
+
+#endif  // GRIB_URLDOWNLOADERTEST_H_
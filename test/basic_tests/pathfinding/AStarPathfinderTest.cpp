@@ -2,11 +2,55 @@
 
 #include "AStarPathfinderTest.h"
 
+#include <algorithm>
+
 #include "pathfinding/MockCostCalculator.h"
 #include "pathfinding/AStarPathfinder.h"
+#include "pathfinding/AStarSearch.h"
 #include "pathfinding/NaiveHeuristic.h"
+#include "pathfinding/HaversineCostCalculator.h"
 #include "common/GeneralDefs.h"
 
+namespace {
+
+/**
+ * Haversine costs without a time horizon, which makes the pathfinder use a hash map closed set.
+ */
+class UnboundedHaversineCostCalculator : public HaversineCostCalculator {
+ public:
+  explicit UnboundedHaversineCostCalculator(const HexPlanet &planet) : HaversineCostCalculator(planet) {}
+
+  uint32_t time_horizon() const override { return kUnboundedTimeHorizon; }
+};
+
+/**
+ * Every edge takes one time step, but indirect neighbours (up to three edges away) cost 5 while direct ones cost 1,
+ * so the cheapest path to a vertex is often slower than the fastest one.
+ */
+class IndirectPenaltyCostCalculator : public CostCalculator {
+ public:
+  /**
+   * @param time_horizon The time horizon to report, 0 (dense closed set) or kUnboundedTimeHorizon (hash map).
+   */
+  IndirectPenaltyCostCalculator(const HexPlanet &planet, uint32_t time_horizon)
+      : CostCalculator(planet), time_horizon_(time_horizon) {}
+
+  Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override {
+    const HexGraph::Span<HexVertexId> neighbours = planet_.graph().neighbours(source);
+    const bool direct = std::find(neighbours.begin(), neighbours.end(), target) != neighbours.end();
+    return {direct ? 1u : 5u, start_time + 1};
+  }
+
+  bool is_indirect_neighbour_safe() const override { return true; }
+
+  uint32_t time_horizon() const override { return time_horizon_; }
+
+ private:
+  uint32_t time_horizon_;
+};
+
+}  // namespace
+
 const std::array<HexVertexId, 6> AStarPathfinderTest::kTestPath1 = {{1, 110, 111, 267, 171, 86}};
 
 AStarPathfinderTest::AStarPathfinderTest() :
@@ -79,6 +123,8 @@ TEST_F(AStarPathfinderTest, FindsLowestCostPath) {
   EXPECT_EQ(result.path[3], kTestPath1[3]);
   EXPECT_EQ(result.path[4], kTestPath1[4]);
   EXPECT_EQ(result.path[5], kTestPath1[5]);
+  // Each edge takes one time step.
+  EXPECT_EQ(result.times, std::vector<uint32_t>({0, 1, 2, 3, 4, 5}));
 }
 
 TEST_F(AStarPathfinderTest, WillEventuallyFindTheWay) {
@@ -172,3 +218,169 @@ TEST_F(AStarPathfinderTest, FindsLowestCostPathHaversine) {
   EXPECT_EQ(result.path[4], kTestPath1[4]);
   EXPECT_EQ(result.path[5], kTestPath1[5]);
 }
+
+/**
+ * Check that every open set finds a path of the same cost, and that the open set stats add up.
+ */
+TEST_F(AStarPathfinderTest, OpenSetTypesFindSameCost) {
+  HaversineHeuristic heuristic(planet_4_);
+  HaversineCostCalculator cost_calculator(planet_4_);
+
+  AStarPathfinder binary_pathfinder(planet_4_, heuristic, cost_calculator, 1, 800, false,
+                                    AStarPathfinder::OpenSetType::kBinaryHeap);
+  const auto expected = binary_pathfinder.Run();
+  ASSERT_FALSE(expected.path.empty());
+
+  for (auto open_set_type : {AStarPathfinder::OpenSetType::kBinaryHeap, AStarPathfinder::OpenSetType::kIndexedHeap,
+                             AStarPathfinder::OpenSetType::kRadixHeap}) {
+    AStarPathfinder pathfinder(planet_4_, heuristic, cost_calculator, 1, 800, false, open_set_type);
+    const auto result = pathfinder.Run();
+    EXPECT_EQ(expected.cost, result.cost);
+    ASSERT_FALSE(result.path.empty());
+    EXPECT_EQ(1u, result.path.front());
+    EXPECT_EQ(800u, result.path.back());
+
+    const auto &stats = pathfinder.stats();
+    EXPECT_GT(stats.pushes, 0u);
+    EXPECT_EQ(stats.pushes, stats.pops + stats.open_set_size);
+    if (open_set_type == AStarPathfinder::OpenSetType::kIndexedHeap) {
+      EXPECT_EQ(0u, stats.stale_pops);
+    } else {
+      EXPECT_EQ(0u, stats.decrease_keys);
+    }
+  }
+}
+
+/**
+ * Check that the dense closed set (bounded time horizon) and the hash map closed set find paths of the same cost.
+ */
+TEST_F(AStarPathfinderTest, DenseClosedSetFindsSameCost) {
+  HaversineHeuristic heuristic(planet_4_);
+  HaversineCostCalculator dense_cost_calculator(planet_4_);
+  UnboundedHaversineCostCalculator hash_cost_calculator(planet_4_);
+  ASSERT_EQ(0u, dense_cost_calculator.time_horizon());
+
+  for (HexVertexId target : {100u, 500u, 800u}) {
+    AStarPathfinder dense_pathfinder(planet_4_, heuristic, dense_cost_calculator, 1, target);
+    AStarPathfinder hash_pathfinder(planet_4_, heuristic, hash_cost_calculator, 1, target);
+    const auto dense_result = dense_pathfinder.Run();
+    const auto hash_result = hash_pathfinder.Run();
+
+    EXPECT_EQ(hash_result.cost, dense_result.cost);
+    EXPECT_EQ(hash_result.path.size(), dense_result.path.size());
+    EXPECT_EQ(dense_result.path.size() - 1, dense_result.time);
+    // Merging the time steps can only shrink the explored state space.
+    EXPECT_LE(dense_pathfinder.stats().closed_set_size, hash_pathfinder.stats().closed_set_size);
+  }
+}
+
+/**
+ * Check that with a maximum time, the dense closed set doesn't merge the time steps past the horizon: a later but
+ * cheaper arrival at a vertex has less time left, so it can't stand in for an earlier one.
+ */
+TEST_F(AStarPathfinderTest, DenseClosedSetRespectsMaxTime) {
+  // The fixture planets have no indirect neighbours.
+  const HexPlanet planet(3);
+  NaiveHeuristic heuristic(planet, 0);
+  IndirectPenaltyCostCalculator dense_cost_calculator(planet, 0);
+  IndirectPenaltyCostCalculator hash_cost_calculator(planet, CostCalculator::kUnboundedTimeHorizon);
+  AStarPathfinder::Limits limits;
+  limits.max_time = 4;
+
+  size_t found_count = 0;
+  for (HexVertexId target = 0; target < planet.vertex_count(); target++) {
+    AStarPathfinder dense_pathfinder(planet, heuristic, dense_cost_calculator, 1, target, true,
+                                     AStarPathfinder::OpenSetType::kBinaryHeap, limits);
+    AStarPathfinder hash_pathfinder(planet, heuristic, hash_cost_calculator, 1, target, true,
+                                    AStarPathfinder::OpenSetType::kBinaryHeap, limits);
+    dense_pathfinder.set_show_progress(false);
+    hash_pathfinder.set_show_progress(false);
+    const auto dense_result = dense_pathfinder.Run();
+    const auto hash_result = hash_pathfinder.Run();
+
+    EXPECT_EQ(hash_result.status, dense_result.status) << "target " << target;
+    if (hash_result.status == Pathfinder::Status::kFound) {
+      found_count++;
+      EXPECT_EQ(hash_result.cost, dense_result.cost) << "target " << target;
+      EXPECT_LE(dense_result.time, limits.max_time);
+    }
+  }
+  // Some targets are only reachable in time through indirect neighbours, others not at all.
+  EXPECT_GT(found_count, 0u);
+  EXPECT_LT(found_count, planet.vertex_count());
+}
+
+/**
+ * Check that a target beyond the maximum time is reported as unreachable, with the closest partial path.
+ */
+TEST_F(AStarPathfinderTest, ReportsUnreachableBeyondMaxTime) {
+  HaversineHeuristic heuristic(planet_2_);
+  NaiveCostCalculator cost_calculator(planet_2_);
+  AStarPathfinder::Limits limits;
+  limits.max_time = 3;
+  // The shortest path takes 6 time steps.
+  AStarPathfinder pathfinder(planet_2_, heuristic, cost_calculator, 0, 90, false,
+                             AStarPathfinder::OpenSetType::kBinaryHeap, limits);
+  const auto result = pathfinder.Run();
+
+  EXPECT_EQ(Pathfinder::Status::kUnreachable, result.status);
+  EXPECT_EQ(0u, pathfinder.stats().open_set_size);
+  ASSERT_GT(result.path.size(), static_cast<size_t>(1));
+  EXPECT_LE(result.path.size(), static_cast<size_t>(4));
+  EXPECT_EQ(static_cast<HexVertexId>(0), result.path.front());
+  EXPECT_EQ(result.path.size() - 1, result.time);
+  EXPECT_LT(heuristic.calculate(result.path.back(), 90), heuristic.calculate(0, 90));
+}
+
+/**
+ * Check that the search stops at the maximum number of expansions with a partial path.
+ */
+TEST_F(AStarPathfinderTest, StopsAtMaxExpansions) {
+  HaversineHeuristic heuristic(planet_4_);
+  HaversineCostCalculator cost_calculator(planet_4_);
+  AStarPathfinder::Limits limits;
+  limits.max_expansions = 5;
+  AStarPathfinder pathfinder(planet_4_, heuristic, cost_calculator, 1, 800, false,
+                             AStarPathfinder::OpenSetType::kBinaryHeap, limits);
+  const auto result = pathfinder.Run();
+
+  EXPECT_EQ(Pathfinder::Status::kExpansionLimitExceeded, result.status);
+  EXPECT_EQ(5u, pathfinder.stats().expansions);
+  ASSERT_FALSE(result.path.empty());
+  EXPECT_EQ(static_cast<HexVertexId>(1), result.path.front());
+  EXPECT_NE(static_cast<HexVertexId>(800), result.path.back());
+
+  // Without limits the same search finds the target.
+  AStarPathfinder unlimited_pathfinder(planet_4_, heuristic, cost_calculator, 1, 800);
+  EXPECT_EQ(Pathfinder::Status::kFound, unlimited_pathfinder.Run().status);
+}
+
+/**
+ * Check that the search with statically bound heuristic and cost calculator calls matches the virtual one.
+ */
+TEST_F(AStarPathfinderTest, StaticSearchMatchesVirtualSearch) {
+  HaversineHeuristic heuristic(planet_4_, 800);
+  HaversineCostCalculator cost_calculator(planet_4_);
+
+  for (bool use_indirect_neighbours : {false, true}) {
+    AStarPathfinder virtual_pathfinder(planet_4_, heuristic, cost_calculator, 1, 800, use_indirect_neighbours);
+    AStarSearch<HaversineHeuristic, HaversineCostCalculator> static_pathfinder(planet_4_, heuristic, cost_calculator,
+                                                                               1, 800, use_indirect_neighbours);
+    virtual_pathfinder.set_show_progress(false);
+    static_pathfinder.set_show_progress(false);
+    const auto virtual_result = virtual_pathfinder.Run();
+    const auto static_result = static_pathfinder.Run();
+
+    EXPECT_EQ(virtual_result.cost, static_result.cost);
+    EXPECT_EQ(virtual_result.path, static_result.path);
+    EXPECT_EQ(virtual_result.times, static_result.times);
+    EXPECT_EQ(virtual_pathfinder.stats().expansions, static_pathfinder.stats().expansions);
+  }
+
+  // Statically bound calls would skip the overrides of derived classes.
+  UnboundedHaversineCostCalculator derived_cost_calculator(planet_4_);
+  typedef AStarSearch<HaversineHeuristic, HaversineCostCalculator> HaversineSearch;
+  EXPECT_THROW(HaversineSearch(planet_4_, heuristic, derived_cost_calculator, 1, 800), std::runtime_error);
+  EXPECT_NO_THROW((AStarSearch<HaversineHeuristic, CostCalculator>(planet_4_, heuristic, derived_cost_calculator, 1,
+                                                                   800)));
+}
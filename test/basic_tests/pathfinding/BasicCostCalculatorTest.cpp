@@ -60,3 +60,35 @@ TEST_F(BasicCostCalculatorTest, CalculateCostForInvalidVerticesTest) {
   EXPECT_THROW(calculator.calculate_target(valid_id, kInvalidHexVertexId, kTravelTime),
                std::runtime_error);
 }
+
+/**
+ * Test that the costs of all edges out of a vertex calculated at once match the ones calculated edge by edge.
+ */
+TEST_F(BasicCostCalculatorTest, CalculateAllMatchesSingleEdgesTest) {
+  auto map = std::make_unique<BasicHexMap>(planet_);
+  BasicCostCalculator calculator(planet_, map);
+  const HexGraph &graph = planet_.graph();
+
+  CostCalculator::EdgeResults results;
+  for (HexVertexId source = 0; source < planet_.vertex_count(); source += 7) {
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+    const size_t neighbour_count = graph.neighbour_count(source);
+
+    calculator.calculate_all(source, kTravelTime, false, &results);
+    ASSERT_EQ(neighbour_count, results.costs.size());
+
+    calculator.calculate_all(source, kTravelTime, true, &results);
+    ASSERT_EQ(neighbour_count + indirect_neighbours.size(), results.costs.size());
+    ASSERT_EQ(results.costs.size(), results.times.size());
+    for (size_t i = 0; i < neighbour_count; i++) {
+      const auto result = calculator.calculate_neighbour(source, i, kTravelTime);
+      EXPECT_EQ(result.cost, results.costs[i]);
+      EXPECT_EQ(result.time, results.times[i]);
+    }
+    for (size_t i = 0; i < indirect_neighbours.size(); i++) {
+      const auto result = calculator.calculate_target(source, indirect_neighbours[i], kTravelTime);
+      EXPECT_EQ(result.cost, results.costs[neighbour_count + i]);
+      EXPECT_EQ(result.time, results.times[neighbour_count + i]);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+// Copyright 2022 UBC Sailbot
+
+#include "BatchPathfinderTest.h"
+
+#include <memory>
+#include <vector>
+
+#include <pathfinding/BatchPathfinder.h>
+#include <pathfinding/HaversineCostCalculator.h>
+#include <pathfinding/HaversineHeuristic.h>
+
+BatchPathfinderTest::BatchPathfinderTest() : planet_4_(4, 0) {}
+
+/**
+ * Check that concurrent queries find the same paths as running each query on its own.
+ */
+TEST_F(BatchPathfinderTest, MatchesSequentialRuns) {
+  HaversineCostCalculator cost_calculator(planet_4_);
+  std::vector<BatchPathfinder::Query> queries;
+  const HexVertexId vertex_count = static_cast<HexVertexId>(planet_4_.vertex_count());
+  for (HexVertexId start = 0; start < vertex_count; start += vertex_count / 12) {
+    queries.push_back({start, (start * 7 + 300) % vertex_count});
+  }
+
+  BatchPathfinder batch_pathfinder(planet_4_, cost_calculator, [this](HexVertexId target) {
+    return std::unique_ptr<Heuristic>(new HaversineHeuristic(planet_4_, target, 1));
+  }, false, AStarPathfinder::OpenSetType::kBinaryHeap, Pathfinder::Limits(), 4);
+  const auto results = batch_pathfinder.Run(queries);
+
+  ASSERT_EQ(queries.size(), results.size());
+  for (size_t i = 0; i < queries.size(); i++) {
+    HaversineHeuristic heuristic(planet_4_);
+    AStarPathfinder pathfinder(planet_4_, heuristic, cost_calculator, queries[i].start, queries[i].target);
+    pathfinder.set_show_progress(false);
+    const auto expected = pathfinder.Run();
+
+    EXPECT_TRUE(results[i].error.empty());
+    EXPECT_EQ(Pathfinder::Status::kFound, results[i].result.status);
+    EXPECT_EQ(expected.cost, results[i].result.cost);
+    EXPECT_EQ(expected.path.size(), results[i].result.path.size());
+    EXPECT_EQ(queries[i].start, results[i].result.path.front());
+    EXPECT_EQ(queries[i].target, results[i].result.path.back());
+    EXPECT_EQ(pathfinder.stats().expansions, results[i].stats.expansions);
+  }
+}
+
+/**
+ * Check that an invalid query fails on its own without affecting the others.
+ */
+TEST_F(BatchPathfinderTest, ReportsQueryErrors) {
+  HaversineCostCalculator cost_calculator(planet_4_);
+  BatchPathfinder batch_pathfinder(planet_4_, cost_calculator, [this](HexVertexId target) {
+    return std::unique_ptr<Heuristic>(new HaversineHeuristic(planet_4_, target, 1));
+  }, false, AStarPathfinder::OpenSetType::kBinaryHeap, Pathfinder::Limits(), 2);
+  const auto results = batch_pathfinder.Run({{0, 100}, {0, kInvalidHexVertexId}, {5000, 100}, {100, 0}});
+
+  ASSERT_EQ(4u, results.size());
+  EXPECT_TRUE(results[0].error.empty());
+  EXPECT_FALSE(results[1].error.empty());
+  EXPECT_FALSE(results[2].error.empty());
+  EXPECT_TRUE(results[3].error.empty());
+  EXPECT_EQ(results[0].result.cost, results[3].result.cost);
+}
+
+/**
+ * Check that queries sharing one heuristic find the same paths as running each query on its own.
+ */
+TEST_F(BatchPathfinderTest, SharesHeuristic) {
+  HaversineCostCalculator cost_calculator(planet_4_);
+  HaversineHeuristic heuristic(planet_4_);
+  const std::vector<BatchPathfinder::Query> queries = {{0, 100}, {100, 0}, {5, 600}, {500, 7}};
+
+  BatchPathfinder batch_pathfinder(planet_4_, cost_calculator, heuristic, false,
+                                   AStarPathfinder::OpenSetType::kBinaryHeap, Pathfinder::Limits(), 2);
+  const auto results = batch_pathfinder.Run(queries);
+
+  ASSERT_EQ(queries.size(), results.size());
+  for (size_t i = 0; i < queries.size(); i++) {
+    AStarPathfinder pathfinder(planet_4_, heuristic, cost_calculator, queries[i].start, queries[i].target);
+    pathfinder.set_show_progress(false);
+    const auto expected = pathfinder.Run();
+
+    EXPECT_TRUE(results[i].error.empty());
+    EXPECT_EQ(expected.cost, results[i].result.cost);
+    EXPECT_EQ(pathfinder.stats().expansions, results[i].stats.expansions);
+  }
+}
@@ -0,0 +1,15 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_BATCHPATHFINDERTEST_H_
+#define PATHFINDING_BATCHPATHFINDERTEST_H_
+
+#include <gtest/gtest.h>
+#include <planet/HexPlanet.h>
+
+class BatchPathfinderTest : public ::testing::Test {
+ protected:
+  BatchPathfinderTest();
+  HexPlanet planet_4_;
+};
+
+#endif  // PATHFINDING_BATCHPATHFINDERTEST_H_
@@ -0,0 +1,200 @@
+// Copyright 2022 UBC Sailbot
+
+#include "BidirectionalAStarPathfinderTest.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <pathfinding/AStarPathfinder.h>
+#include <pathfinding/BasicCostCalculator.h>
+#include <pathfinding/BasicHexMap.h>
+#include <pathfinding/BidirectionalAStarPathfinder.h>
+#include <pathfinding/HaversineCostCalculator.h>
+#include <pathfinding/HaversineHeuristic.h>
+#include <pathfinding/NaiveCostCalculator.h>
+#include <pathfinding/NaiveHeuristic.h>
+
+namespace {
+
+/**
+ * Time-independent costs that differ between the two directions of an edge: edges towards higher vertex ids cost 3
+ * and take 2 time steps, the others cost 1 and take 1 time step.
+ */
+class AsymmetricCostCalculator : public CostCalculator {
+ public:
+  explicit AsymmetricCostCalculator(const HexPlanet &planet) : CostCalculator(planet) {}
+
+  Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override {
+    return source < target ? Result{3, start_time + 2} : Result{1, start_time + 1};
+  }
+
+  bool is_indirect_neighbour_safe() const override { return true; }
+
+  uint32_t time_horizon() const override { return 0; }
+};
+
+/**
+ * Check that |result| is a path from |start| to |target| along edges of |planet|, with times consistent with
+ * |cost_calculator|.
+ */
+void ExpectValidPath(const HexPlanet &planet, const CostCalculator &cost_calculator, HexVertexId start,
+                     HexVertexId target, bool use_indirect_neighbours, const Pathfinder::Result &result) {
+  ASSERT_FALSE(result.path.empty());
+  ASSERT_EQ(result.path.size(), result.times.size());
+  EXPECT_EQ(start, result.path.front());
+  EXPECT_EQ(target, result.path.back());
+  EXPECT_EQ(0u, result.times.front());
+  EXPECT_EQ(result.time, result.times.back());
+
+  const HexGraph &graph = planet.graph();
+  for (size_t i = 1; i < result.path.size(); i++) {
+    const HexGraph::Span<HexVertexId> neighbours = graph.neighbours(result.path[i - 1]);
+    const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(result.path[i - 1]);
+    const bool is_neighbour = std::find(neighbours.begin(), neighbours.end(), result.path[i]) != neighbours.end();
+    const bool is_indirect_neighbour = use_indirect_neighbours &&
+        std::find(indirect_neighbours.begin(), indirect_neighbours.end(), result.path[i]) != indirect_neighbours.end();
+    EXPECT_TRUE(is_neighbour || is_indirect_neighbour);
+
+    const CostCalculator::Result edge = cost_calculator.calculate_target(result.path[i - 1], result.path[i],
+                                                                         result.times[i - 1]);
+    EXPECT_EQ(edge.time, result.times[i]);
+  }
+}
+
+}  // namespace
+
+BidirectionalAStarPathfinderTest::BidirectionalAStarPathfinderTest() : planet_5_(5) {}
+
+/**
+ * Check that the bidirectional search finds paths as cheap as the unidirectional one, with and without indirect
+ * neighbours.
+ */
+TEST_F(BidirectionalAStarPathfinderTest, MatchesUnidirectionalCost) {
+  HaversineHeuristic heuristic(planet_5_);
+  HaversineCostCalculator cost_calculator(planet_5_);
+  ASSERT_TRUE(cost_calculator.is_time_independent());
+
+  for (bool use_indirect_neighbours : {false, true}) {
+    for (HexVertexId target : {2u, 100u, 500u, 800u, 2000u}) {
+      AStarPathfinder unidirectional_pathfinder(planet_5_, heuristic, cost_calculator, 1, target,
+                                                use_indirect_neighbours);
+      unidirectional_pathfinder.set_show_progress(false);
+      BidirectionalAStarPathfinder bidirectional_pathfinder(planet_5_, heuristic, cost_calculator, 1, target,
+                                                            use_indirect_neighbours);
+      const auto expected = unidirectional_pathfinder.Run();
+      const auto result = bidirectional_pathfinder.Run();
+
+      EXPECT_EQ(Pathfinder::Status::kFound, result.status);
+      EXPECT_EQ(expected.cost, result.cost);
+      EXPECT_EQ(result.path.size() - 1, result.time);
+      ExpectValidPath(planet_5_, cost_calculator, 1, target, use_indirect_neighbours, result);
+
+      const auto &stats = bidirectional_pathfinder.stats();
+      EXPECT_GT(stats.backward_expansions, 0u);
+      EXPECT_LT(stats.backward_expansions, stats.expansions);
+      EXPECT_EQ(stats.pushes, stats.pops + stats.open_set_size);
+    }
+  }
+}
+
+/**
+ * Check that edges are followed in the right direction by the backward search when costs and durations are asymmetric.
+ */
+TEST_F(BidirectionalAStarPathfinderTest, HandlesAsymmetricCosts) {
+  NaiveHeuristic heuristic(planet_5_, 0);
+  AsymmetricCostCalculator cost_calculator(planet_5_);
+
+  for (bool use_indirect_neighbours : {false, true}) {
+    for (auto query : {std::make_pair(1u, 800u), std::make_pair(800u, 1u), std::make_pair(37u, 2000u)}) {
+      AStarPathfinder unidirectional_pathfinder(planet_5_, heuristic, cost_calculator, query.first, query.second,
+                                                use_indirect_neighbours);
+      unidirectional_pathfinder.set_show_progress(false);
+      BidirectionalAStarPathfinder bidirectional_pathfinder(planet_5_, heuristic, cost_calculator, query.first,
+                                                            query.second, use_indirect_neighbours);
+      const auto expected = unidirectional_pathfinder.Run();
+      const auto result = bidirectional_pathfinder.Run();
+
+      EXPECT_EQ(expected.cost, result.cost);
+      ExpectValidPath(planet_5_, cost_calculator, query.first, query.second, use_indirect_neighbours, result);
+
+      uint32_t path_cost = 0;
+      for (size_t i = 1; i < result.path.size(); i++) {
+        path_cost += cost_calculator.calculate_target(result.path[i - 1], result.path[i], 0).cost;
+      }
+      EXPECT_EQ(result.cost, path_cost);
+    }
+  }
+}
+
+/**
+ * Check that with a weak heuristic, the two searches meet after far fewer expansions than a single search takes.
+ */
+TEST_F(BidirectionalAStarPathfinderTest, SavesExpansions) {
+  NaiveHeuristic heuristic(planet_5_, 0);
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<uint32_t> risk(BasicHexMap::kDefaultRisk, BasicHexMap::kDefaultMaxRisk);
+  std::vector<uint32_t> risks(planet_5_.vertex_count());
+  for (auto &vertex_risk : risks) {
+    vertex_risk = risk(generator);
+  }
+  auto map = std::make_unique<BasicHexMap>(planet_5_, risks);
+  BasicCostCalculator cost_calculator(planet_5_, map);
+
+  AStarPathfinder unidirectional_pathfinder(planet_5_, heuristic, cost_calculator, 1, 800);
+  unidirectional_pathfinder.set_show_progress(false);
+  BidirectionalAStarPathfinder bidirectional_pathfinder(planet_5_, heuristic, cost_calculator, 1, 800);
+  const auto expected = unidirectional_pathfinder.Run();
+  const auto result = bidirectional_pathfinder.Run();
+
+  EXPECT_EQ(expected.cost, result.cost);
+  ExpectValidPath(planet_5_, cost_calculator, 1, 800, false, result);
+  EXPECT_LT(bidirectional_pathfinder.stats().expansions, unidirectional_pathfinder.stats().expansions);
+}
+
+TEST_F(BidirectionalAStarPathfinderTest, ReturnsSingleVertexPathForSameTarget) {
+  HaversineHeuristic heuristic(planet_5_);
+  NaiveCostCalculator cost_calculator(planet_5_);
+  BidirectionalAStarPathfinder pathfinder(planet_5_, heuristic, cost_calculator, 5, 5);
+  const auto result = pathfinder.Run();
+
+  EXPECT_EQ(Pathfinder::Status::kFound, result.status);
+  EXPECT_EQ(0u, result.cost);
+  EXPECT_EQ(0u, result.time);
+  EXPECT_EQ(std::vector<HexVertexId>{5}, result.path);
+}
+
+/**
+ * Check that the search stops at the maximum number of expansions with a partial path from the start.
+ */
+TEST_F(BidirectionalAStarPathfinderTest, StopsAtMaxExpansions) {
+  HaversineHeuristic heuristic(planet_5_);
+  HaversineCostCalculator cost_calculator(planet_5_);
+  Pathfinder::Limits limits;
+  limits.max_expansions = 5;
+  BidirectionalAStarPathfinder pathfinder(planet_5_, heuristic, cost_calculator, 1, 800, false, limits);
+  const auto result = pathfinder.Run();
+
+  EXPECT_EQ(Pathfinder::Status::kExpansionLimitExceeded, result.status);
+  EXPECT_EQ(5u, pathfinder.stats().expansions);
+  ASSERT_FALSE(result.path.empty());
+  EXPECT_EQ(static_cast<HexVertexId>(1), result.path.front());
+  EXPECT_NE(static_cast<HexVertexId>(800), result.path.back());
+}
+
+/**
+ * Check that searches the backward search can't handle are refused.
+ */
+TEST_F(BidirectionalAStarPathfinderTest, RejectsUnsupportedSearches) {
+  HaversineHeuristic heuristic(planet_5_);
+  auto map = std::make_unique<BasicHexMap>(planet_5_);
+  BasicCostCalculator cost_calculator(planet_5_, map);
+  EXPECT_THROW(BidirectionalAStarPathfinder(planet_5_, heuristic, cost_calculator, 1, 800, true), std::runtime_error);
+
+  Pathfinder::Limits limits;
+  limits.max_time = 10;
+  EXPECT_THROW(BidirectionalAStarPathfinder(planet_5_, heuristic, cost_calculator, 1, 800, false, limits),
+               std::runtime_error);
+}
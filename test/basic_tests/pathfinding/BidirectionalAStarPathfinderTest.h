@@ -0,0 +1,15 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_BIDIRECTIONALASTARPATHFINDERTEST_H_
+#define PATHFINDING_BIDIRECTIONALASTARPATHFINDERTEST_H_
+
+#include <gtest/gtest.h>
+#include <planet/HexPlanet.h>
+
+class BidirectionalAStarPathfinderTest : public ::testing::Test {
+ protected:
+  BidirectionalAStarPathfinderTest();
+  HexPlanet planet_5_;
+};
+
+#endif  // PATHFINDING_BIDIRECTIONALASTARPATHFINDERTEST_H_
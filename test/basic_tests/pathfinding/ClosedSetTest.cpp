@@ -0,0 +1,54 @@
+// Copyright 2022 UBC Sailbot
+
+#include "ClosedSetTest.h"
+
+#include <pathfinding/ClosedSet.h>
+
+namespace {
+
+struct TestEntry {
+  uint32_t cost;
+};
+
+}  // namespace
+
+ClosedSetTest::ClosedSetTest() {}
+
+TEST_F(ClosedSetTest, HashMapKeepsTimeStepsApart) {
+  closed_set::HashMap<TestEntry> visited;
+  EXPECT_EQ(nullptr, visited.find({3, 0}));
+
+  TestEntry &entry = visited.insert({3, 0}, {10});
+  EXPECT_EQ(&entry, visited.find({3, 0}));
+  EXPECT_EQ(nullptr, visited.find({3, 1}));
+
+  visited.insert({3, 7}, {20});
+  EXPECT_EQ(20u, visited.find({3, 7})->cost);
+  EXPECT_EQ(2u, visited.size());
+  EXPECT_GT(visited.memory_usage(), 2 * sizeof(TestEntry));
+}
+
+TEST_F(ClosedSetTest, DensePagedMergesTimeStepsFromHorizon) {
+  static constexpr size_t kVertexCount = 10000;
+  closed_set::DensePaged<TestEntry> visited(kVertexCount, 2);
+  EXPECT_EQ(nullptr, visited.find({3, 0}));
+
+  TestEntry &entry = visited.insert({3, 0}, {10});
+  EXPECT_EQ(&entry, visited.find({3, 0}));
+  EXPECT_EQ(nullptr, visited.find({3, 1}));
+  EXPECT_EQ(nullptr, visited.find({4, 0}));
+
+  // Every time step from the horizon on is the same state.
+  TestEntry &late_entry = visited.insert({3, 2}, {20});
+  EXPECT_EQ(&late_entry, visited.find({3, 2}));
+  EXPECT_EQ(&late_entry, visited.find({3, 9}));
+
+  visited.insert({kVertexCount - 1, 5}, {30});
+  EXPECT_EQ(30u, visited.find({kVertexCount - 1, 2})->cost);
+  EXPECT_EQ(3u, visited.size());
+
+  // Only the two pages holding the three states are allocated.
+  const size_t page_size = closed_set::DensePaged<TestEntry>::kPageSize;
+  const size_t page_table_size = (kVertexCount * 3 + page_size - 1) / page_size * sizeof(void *);
+  EXPECT_EQ(2 * page_size * sizeof(TestEntry) + page_table_size, visited.memory_usage());
+}
@@ -0,0 +1,13 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_CLOSEDSETTEST_H_
+#define PATHFINDING_CLOSEDSETTEST_H_
+
+#include <gtest/gtest.h>
+
+class ClosedSetTest : public ::testing::Test {
+ protected:
+  ClosedSetTest();
+};
+
+#endif  // PATHFINDING_CLOSEDSETTEST_H_
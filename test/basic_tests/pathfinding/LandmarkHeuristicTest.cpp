@@ -0,0 +1,278 @@
+// Copyright 2022 UBC Sailbot
+
+#include "LandmarkHeuristicTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <pathfinding/AStarPathfinder.h>
+#include <pathfinding/BasicCostCalculator.h>
+#include <pathfinding/BasicHexMap.h>
+#include <pathfinding/HaversineCostCalculator.h>
+#include <pathfinding/HaversineHeuristic.h>
+#include <pathfinding/LandmarkHeuristic.h>
+#include <pathfinding/NaiveHeuristic.h>
+
+#include "common/TemporaryDirectory.h"
+
+namespace {
+
+/**
+ * Haversine costs with a toll that decreases over time: edges starting at time step t < 2 cost an extra
+ * 1000 * (2 - t).
+ */
+class TollCostCalculator : public HaversineCostCalculator {
+ public:
+  explicit TollCostCalculator(const HexPlanet &planet) : HaversineCostCalculator(planet) {}
+
+  Result calculate_neighbour(HexVertexId source, size_t neighbour, uint32_t start_time) const override {
+    Result result = HaversineCostCalculator::calculate_neighbour(source, neighbour, start_time);
+    result.cost += Toll(start_time);
+    return result;
+  }
+
+  Result calculate_target(HexVertexId source, HexVertexId target, uint32_t start_time) const override {
+    Result result = HaversineCostCalculator::calculate_target(source, target, start_time);
+    result.cost += Toll(start_time);
+    return result;
+  }
+
+  void calculate_all(HexVertexId source, uint32_t start_time, bool include_indirect,
+                     EdgeResults *results) const override {
+    HaversineCostCalculator::calculate_all(source, start_time, include_indirect, results);
+    for (uint32_t &cost : results->costs) {
+      cost += Toll(start_time);
+    }
+  }
+
+  uint32_t time_horizon() const override { return 2; }
+
+ private:
+  static uint32_t Toll(uint32_t start_time) { return 1000 * (2 - std::min(start_time, 2u)); }
+};
+
+/**
+ * Haversine costs identified by a given fingerprint, as if they depended on inputs hashed to it.
+ */
+class FingerprintedCostCalculator : public HaversineCostCalculator {
+ public:
+  FingerprintedCostCalculator(const HexPlanet &planet, uint64_t fingerprint)
+      : HaversineCostCalculator(planet), fingerprint_(fingerprint) {}
+
+  uint64_t fingerprint() const override { return fingerprint_; }
+
+ private:
+  uint64_t fingerprint_;
+};
+
+/**
+ * Costs that may depend on any time step.
+ */
+class UnboundedCostCalculator : public CostCalculator {
+ public:
+  explicit UnboundedCostCalculator(const HexPlanet &planet) : CostCalculator(planet) {}
+
+  Result calculate_target(HexVertexId, HexVertexId, uint32_t start_time) const override {
+    return {start_time + 1, start_time + 1};
+  }
+};
+
+/**
+ * @return The lowest cost from |start| to |target|, found by A* without a heuristic.
+ */
+uint32_t LowestCost(const HexPlanet &planet, const CostCalculator &cost_calculator, HexVertexId start,
+                    HexVertexId target, bool use_indirect_neighbours = false) {
+  NaiveHeuristic heuristic(planet, 0);
+  AStarPathfinder pathfinder(planet, heuristic, cost_calculator, start, target, use_indirect_neighbours);
+  pathfinder.set_show_progress(false);
+  return pathfinder.Run().cost;
+}
+
+/**
+ * @return Costs with a band of high risk around the equator, which the Haversine distances don't account for.
+ */
+std::unique_ptr<BasicCostCalculator> StormCostCalculator(const HexPlanet &planet) {
+  const uint32_t storm_risk = 5 * planet.graph().neighbour_distances(0)[0];
+  std::vector<uint32_t> risks(planet.vertex_count());
+  for (HexVertexId vertex = 0; vertex < planet.vertex_count(); vertex++) {
+    // Latitudes are in radians, the band is about 20 degrees wide on each side.
+    risks[vertex] = std::abs(planet.vertex(vertex).coordinate.latitude()) < 0.35 ? storm_risk : 0;
+  }
+  auto map = std::make_unique<BasicHexMap>(planet, risks);
+  return std::make_unique<BasicCostCalculator>(planet, map);
+}
+
+}  // namespace
+
+LandmarkHeuristicTest::LandmarkHeuristicTest() : planet_5_(5) {}
+
+/**
+ * Check that the bounds are exact from the landmarks and never exceed the lowest costs elsewhere.
+ */
+TEST_F(LandmarkHeuristicTest, IsAdmissible) {
+  const auto cost_calculator = StormCostCalculator(planet_5_);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, *cost_calculator, false);
+  const std::vector<HexVertexId> landmarks = LandmarkHeuristic::SelectLandmarks(planet_5_, 4);
+  const LandmarkHeuristic heuristic(planet_5_, surface, landmarks);
+
+  for (HexVertexId target : {7u, 800u, 2000u}) {
+    EXPECT_EQ(LowestCost(planet_5_, *cost_calculator, landmarks[0], target),
+              heuristic.calculate(landmarks[0], target));
+    EXPECT_EQ(LowestCost(planet_5_, *cost_calculator, target, landmarks[1]),
+              heuristic.calculate(target, landmarks[1]));
+    EXPECT_EQ(0u, heuristic.calculate(target, target));
+
+    for (HexVertexId start : {1u, 500u, 1500u}) {
+      const uint32_t h_cost = heuristic.calculate(start, target);
+      EXPECT_LE(h_cost, LowestCost(planet_5_, *cost_calculator, start, target));
+      EXPECT_GT(h_cost, 0u);
+    }
+  }
+}
+
+/**
+ * Check that A* finds the same paths with far fewer expansions than with the Haversine heuristic when risks dominate
+ * the costs.
+ */
+TEST_F(LandmarkHeuristicTest, SavesExpansions) {
+  const auto cost_calculator = StormCostCalculator(planet_5_);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, *cost_calculator, false);
+  const LandmarkHeuristic landmark_heuristic(planet_5_, surface, LandmarkHeuristic::SelectLandmarks(planet_5_, 8));
+  HaversineHeuristic haversine_heuristic(planet_5_);
+
+  size_t haversine_expansions = 0;
+  size_t landmark_expansions = 0;
+  for (HexVertexId target : {7u, 100u, 800u}) {
+    AStarPathfinder haversine_pathfinder(planet_5_, haversine_heuristic, *cost_calculator, 1, target);
+    haversine_pathfinder.set_show_progress(false);
+    AStarPathfinder landmark_pathfinder(planet_5_, landmark_heuristic, *cost_calculator, 1, target);
+    landmark_pathfinder.set_show_progress(false);
+    const auto expected = haversine_pathfinder.Run();
+    const auto result = landmark_pathfinder.Run();
+
+    EXPECT_EQ(Pathfinder::Status::kFound, result.status);
+    EXPECT_EQ(expected.cost, result.cost);
+    haversine_expansions += haversine_pathfinder.stats().expansions;
+    landmark_expansions += landmark_pathfinder.stats().expansions;
+  }
+  EXPECT_LT(2 * landmark_expansions, haversine_expansions);
+}
+
+/**
+ * Check that tables computed with indirect neighbours bound searches that use them.
+ */
+TEST_F(LandmarkHeuristicTest, HandlesIndirectNeighbours) {
+  HaversineCostCalculator cost_calculator(planet_5_);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, cost_calculator, true);
+  const LandmarkHeuristic heuristic(planet_5_, surface, LandmarkHeuristic::SelectLandmarks(planet_5_, 4));
+  const HexVertexId landmark = heuristic.landmarks()[0];
+
+  for (HexVertexId target : {100u, 800u, 2000u}) {
+    EXPECT_EQ(LowestCost(planet_5_, cost_calculator, landmark, target, true), heuristic.calculate(landmark, target));
+    EXPECT_LE(heuristic.calculate(1, target), LowestCost(planet_5_, cost_calculator, 1, target, true));
+
+    AStarPathfinder pathfinder(planet_5_, heuristic, cost_calculator, 1, target, true);
+    pathfinder.set_show_progress(false);
+    EXPECT_EQ(LowestCost(planet_5_, cost_calculator, 1, target, true), pathfinder.Run().cost);
+  }
+}
+
+/**
+ * Check that time-dependent costs give bounds on the cheapest time step of each edge.
+ */
+TEST_F(LandmarkHeuristicTest, BoundsTimeDependentCosts) {
+  TollCostCalculator cost_calculator(planet_5_);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, cost_calculator, false);
+  const LandmarkHeuristic heuristic(planet_5_, surface, LandmarkHeuristic::SelectLandmarks(planet_5_, 4));
+
+  HaversineCostCalculator toll_free_cost_calculator(planet_5_);
+  for (HexVertexId target : {100u, 2000u}) {
+    const uint32_t h_cost = heuristic.calculate(1, target);
+    EXPECT_LE(h_cost, LowestCost(planet_5_, toll_free_cost_calculator, 1, target));
+    EXPECT_LT(h_cost, LowestCost(planet_5_, cost_calculator, 1, target));
+  }
+
+  UnboundedCostCalculator unbounded_cost_calculator(planet_5_);
+  EXPECT_THROW(LandmarkHeuristic::CostSurface(planet_5_, unbounded_cost_calculator, false), std::runtime_error);
+  auto map = std::make_unique<BasicHexMap>(planet_5_);
+  BasicCostCalculator basic_cost_calculator(planet_5_, map);
+  EXPECT_THROW(LandmarkHeuristic::CostSurface(planet_5_, basic_cost_calculator, true), std::runtime_error);
+}
+
+/**
+ * Check that written tables are read back exactly, and only for the surface they were computed on.
+ */
+TEST_F(LandmarkHeuristicTest, FileRoundTrip) {
+  TemporaryDirectory directory;
+  const std::string filename = directory.path("landmarks.bin");
+  const auto cost_calculator = StormCostCalculator(planet_5_);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, *cost_calculator, false);
+  const LandmarkHeuristic heuristic(planet_5_, surface, LandmarkHeuristic::SelectLandmarks(planet_5_, 3));
+  heuristic.WriteToFile(filename);
+
+  EXPECT_TRUE(LandmarkHeuristic::IsLandmarkFile(filename));
+  const LandmarkHeuristic read_heuristic(planet_5_, filename, surface.fingerprint());
+  EXPECT_EQ(heuristic.landmarks(), read_heuristic.landmarks());
+  for (HexVertexId source = 0; source < planet_5_.vertex_count(); source += 97) {
+    for (HexVertexId target = 0; target < planet_5_.vertex_count(); target += 89) {
+      EXPECT_EQ(heuristic.calculate(source, target), read_heuristic.calculate(source, target));
+    }
+  }
+
+  HaversineCostCalculator other_cost_calculator(planet_5_);
+  const LandmarkHeuristic::CostSurface other_surface(planet_5_, other_cost_calculator, false);
+  EXPECT_NE(surface.fingerprint(), other_surface.fingerprint());
+  EXPECT_THROW(LandmarkHeuristic(planet_5_, filename, other_surface.fingerprint()), std::runtime_error);
+  HexPlanet planet_4(4);
+  EXPECT_THROW(LandmarkHeuristic(planet_4, filename, surface.fingerprint()), std::runtime_error);
+
+  EXPECT_FALSE(LandmarkHeuristic::IsLandmarkFile(directory.path("missing.bin")));
+}
+
+/**
+ * Check that the tables of cost calculators that fingerprint their inputs can be loaded without building a surface.
+ */
+TEST_F(LandmarkHeuristicTest, FingerprintsCostCalculatorInputs) {
+  TemporaryDirectory directory;
+  const std::string filename = directory.path("landmarks.bin");
+  const FingerprintedCostCalculator cost_calculator(planet_5_, 42);
+  const uint64_t fingerprint = LandmarkHeuristic::CostSurface::Fingerprint(planet_5_, cost_calculator, false);
+  const LandmarkHeuristic::CostSurface surface(planet_5_, cost_calculator, false);
+  EXPECT_EQ(fingerprint, surface.fingerprint());
+  LandmarkHeuristic(planet_5_, surface, LandmarkHeuristic::SelectLandmarks(planet_5_, 3)).WriteToFile(filename);
+  EXPECT_EQ(3u, LandmarkHeuristic(planet_5_, filename, fingerprint).landmarks().size());
+
+  // Other inputs or edge sets have other fingerprints.
+  EXPECT_NE(fingerprint, LandmarkHeuristic::CostSurface::Fingerprint(planet_5_, cost_calculator, true));
+  const FingerprintedCostCalculator other_cost_calculator(planet_5_, 43);
+  EXPECT_NE(fingerprint, LandmarkHeuristic::CostSurface::Fingerprint(planet_5_, other_cost_calculator, false));
+
+  // Without a fingerprint of the inputs, only the surface identifies the costs.
+  HaversineCostCalculator haversine_cost_calculator(planet_5_);
+  EXPECT_EQ(CostCalculator::kNoFingerprint,
+            LandmarkHeuristic::CostSurface::Fingerprint(planet_5_, haversine_cost_calculator, false));
+  EXPECT_NE(CostCalculator::kNoFingerprint,
+            LandmarkHeuristic::CostSurface(planet_5_, haversine_cost_calculator, false).fingerprint());
+}
+
+/**
+ * Check that landmarks are distinct candidates spread apart from each other.
+ */
+TEST_F(LandmarkHeuristicTest, SelectsSpreadLandmarks) {
+  const std::vector<HexVertexId> landmarks = LandmarkHeuristic::SelectLandmarks(planet_5_, 6);
+  ASSERT_EQ(6u, landmarks.size());
+  for (size_t i = 0; i < landmarks.size(); i++) {
+    for (size_t j = i + 1; j < landmarks.size(); j++) {
+      // Six points spread over the sphere are at least a quarter of its circumference apart.
+      EXPECT_GT(planet_5_.DistanceBetweenVertices(landmarks[i], landmarks[j]), 9000000u);
+    }
+  }
+
+  const std::vector<HexVertexId> candidates = {3, 10, 20, 40};
+  const std::vector<HexVertexId> candidate_landmarks = LandmarkHeuristic::SelectLandmarks(planet_5_, 10, candidates);
+  ASSERT_EQ(candidates.size(), candidate_landmarks.size());
+  EXPECT_TRUE(std::is_permutation(candidates.begin(), candidates.end(), candidate_landmarks.begin()));
+}
@@ -0,0 +1,15 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_LANDMARKHEURISTICTEST_H_
+#define PATHFINDING_LANDMARKHEURISTICTEST_H_
+
+#include <gtest/gtest.h>
+#include <planet/HexPlanet.h>
+
+class LandmarkHeuristicTest : public ::testing::Test {
+ protected:
+  LandmarkHeuristicTest();
+  HexPlanet planet_5_;
+};
+
+#endif  // PATHFINDING_LANDMARKHEURISTICTEST_H_
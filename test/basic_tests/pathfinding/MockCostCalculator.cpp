@@ -2,7 +2,7 @@
 
 #include "MockCostCalculator.h"
 
-MockCostCalculator::MockCostCalculator(HexPlanet &planet, const MockCostMap &mock_cost_map, uint32_t default_cost)
+MockCostCalculator::MockCostCalculator(const HexPlanet &planet, const MockCostMap &mock_cost_map, uint32_t default_cost)
     : CostCalculator(planet), mock_cost_map_(mock_cost_map), default_cost_(default_cost) {}
 
 CostCalculator::Result MockCostCalculator::calculate_target(HexVertexId source,
@@ -11,7 +11,7 @@ class MockCostCalculator : public CostCalculator {
  public:
   typedef boost::unordered_map<std::tuple<HexVertexId, HexVertexId, uint32_t>, uint32_t> MockCostMap;
 
-  explicit MockCostCalculator(HexPlanet &planet, const MockCostMap &mock_cost_map, uint32_t default_cost = 1);
+  explicit MockCostCalculator(const HexPlanet &planet, const MockCostMap &mock_cost_map, uint32_t default_cost = 1);
 
   /**
    * @param source Source vertex ID.
@@ -0,0 +1,112 @@
+// Copyright 2022 UBC Sailbot
+
+#include "OpenSetTest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <pathfinding/OpenSet.h>
+
+namespace {
+
+/// The number of entries pushed in each test
+constexpr size_t kTestEntryCount = 5000;
+
+struct TestEntry {
+  uint32_t key;
+  uint32_t open_set_index = open_set::kNotQueued;
+};
+
+/**
+ * Push entries with random (but monotone with respect to the pops) keys, interleaved with pops, and check that the
+ * keys come out in order.
+ */
+template<typename OpenSet>
+void CheckPopsInKeyOrder() {
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<uint32_t> key_distribution(0, 100000);
+  std::vector<TestEntry> entries(kTestEntryCount);
+
+  OpenSet open_set;
+  uint32_t last_key = 0;
+  size_t next_entry = 0;
+  size_t popped = 0;
+  while (popped < kTestEntryCount) {
+    // Push a few entries with keys no lower than the last popped one, then pop one.
+    for (size_t i = 0; i < 3 && next_entry < kTestEntryCount; i++, next_entry++) {
+      entries[next_entry].key = last_key + key_distribution(generator);
+      open_set.push(&entries[next_entry], entries[next_entry].key);
+    }
+    const open_set::Item<TestEntry> item = open_set.pop();
+    popped++;
+    EXPECT_EQ(item.entry->key, item.key);
+    EXPECT_LE(last_key, item.key);
+    last_key = item.key;
+  }
+
+  EXPECT_TRUE(open_set.empty());
+  EXPECT_EQ(kTestEntryCount, open_set.pushes());
+}
+
+}  // namespace
+
+OpenSetTest::OpenSetTest() {}
+
+TEST_F(OpenSetTest, BinaryHeapPopsInKeyOrder) {
+  CheckPopsInKeyOrder<open_set::BinaryHeap<TestEntry>>();
+}
+
+TEST_F(OpenSetTest, IndexedHeapPopsInKeyOrder) {
+  CheckPopsInKeyOrder<open_set::IndexedHeap<TestEntry>>();
+}
+
+TEST_F(OpenSetTest, RadixHeapPopsInKeyOrder) {
+  CheckPopsInKeyOrder<open_set::RadixHeap<TestEntry>>();
+}
+
+/**
+ * Check that decreasing keys in an IndexedHeap reorders the entries without adding items.
+ */
+TEST_F(OpenSetTest, IndexedHeapDecreaseKey) {
+  std::vector<TestEntry> entries(100);
+  open_set::IndexedHeap<TestEntry> open_set;
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    entries[i].key = 1000 + i;
+    open_set.push(&entries[i], entries[i].key);
+  }
+
+  // Reverse the order by lowering every key.
+  for (uint32_t i = 0; i < entries.size(); i++) {
+    entries[i].key = 1000 - i;
+    open_set.push(&entries[i], entries[i].key);
+  }
+  EXPECT_EQ(entries.size(), open_set.size());
+  EXPECT_EQ(entries.size(), open_set.pushes());
+  EXPECT_EQ(entries.size(), open_set.decrease_keys());
+
+  for (size_t i = entries.size(); i-- > 0;) {
+    const open_set::Item<TestEntry> item = open_set.pop();
+    EXPECT_EQ(&entries[i], item.entry);
+    EXPECT_EQ(open_set::kNotQueued, item.entry->open_set_index);
+  }
+  EXPECT_TRUE(open_set.empty());
+}
+
+/**
+ * Check that a RadixHeap pops keys below the last popped key (from inconsistent heuristics) next.
+ */
+TEST_F(OpenSetTest, RadixHeapClampsLowKeys) {
+  std::vector<TestEntry> entries = {{50}, {80}, {10}};
+  open_set::RadixHeap<TestEntry> open_set;
+  open_set.push(&entries[0], entries[0].key);
+  open_set.push(&entries[1], entries[1].key);
+  EXPECT_EQ(&entries[0], open_set.pop().entry);
+
+  open_set.push(&entries[2], entries[2].key);
+  const open_set::Item<TestEntry> item = open_set.pop();
+  EXPECT_EQ(&entries[2], item.entry);
+  EXPECT_EQ(10u, item.key);
+  EXPECT_EQ(&entries[1], open_set.pop().entry);
+  EXPECT_TRUE(open_set.empty());
+}
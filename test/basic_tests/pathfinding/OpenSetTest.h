@@ -0,0 +1,13 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PATHFINDING_OPENSETTEST_H_
+#define PATHFINDING_OPENSETTEST_H_
+
+#include <gtest/gtest.h>
+
+class OpenSetTest : public ::testing::Test {
+ protected:
+  OpenSetTest();
+};
+
+#endif  // PATHFINDING_OPENSETTEST_H_
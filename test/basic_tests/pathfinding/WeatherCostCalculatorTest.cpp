@@ -12,6 +12,9 @@ static constexpr uint32_t kTimeSteps = 4;
 /// Default travel time to use in cost calculations
 static constexpr uint32_t kTravelTime = 1;
 
+/// The checked-in GRIB file of wind over the test region, so tests don't download a forecast
+static const char kRegionGrib[] = TEST_DATA_DIRECTORY "/wind_region.grb";
+
 WeatherCostCalculatorTest::WeatherCostCalculatorTest() : planet_(kSizeOfTestPlanet) {}
 
 /**
@@ -61,3 +64,82 @@ TEST_F(WeatherCostCalculatorTest, CalculateCostForInvalidVerticesTest) {
   EXPECT_THROW(calculator.calculate_target(valid_id, kInvalidHexVertexId, kTravelTime),
                std::runtime_error);
 }
+
+/**
+ * Test that the costs of all edges out of a vertex calculated at once match the ones calculated edge by edge.
+ */
+TEST_F(WeatherCostCalculatorTest, CalculateAllMatchesSingleEdgesTest) {
+  auto map = std::make_unique<WeatherHexMap>(planet_, kTimeSteps, 48, 235, 21, 203, false, kRegionGrib);
+  WeatherCostCalculator calculator(planet_, map, 1500);
+  const HexGraph &graph = planet_.graph();
+
+  CostCalculator::EdgeResults results;
+  for (HexVertexId source = 0; source < planet_.vertex_count(); source += 7) {
+    for (uint32_t time = 0; time < kTimeSteps; time++) {
+      const HexGraph::Span<HexVertexId> indirect_neighbours = graph.indirect_neighbours(source);
+      const size_t neighbour_count = graph.neighbour_count(source);
+      calculator.calculate_all(source, time, true, &results);
+      ASSERT_EQ(neighbour_count + indirect_neighbours.size(), results.costs.size());
+      for (size_t i = 0; i < neighbour_count; i++) {
+        const auto result = calculator.calculate_neighbour(source, i, time);
+        EXPECT_EQ(result.cost, results.costs[i]);
+        EXPECT_EQ(result.time, results.times[i]);
+      }
+      for (size_t i = 0; i < indirect_neighbours.size(); i++) {
+        const auto result = calculator.calculate_target(source, indirect_neighbours[i], time);
+        EXPECT_EQ(result.cost, results.costs[neighbour_count + i]);
+        EXPECT_EQ(result.time, results.times[neighbour_count + i]);
+      }
+    }
+  }
+}
+
+/**
+ * Test that the precomputed cost tables give the same costs as computing them from the weather.
+ */
+TEST_F(WeatherCostCalculatorTest, CostTablesMatchComputedCostsTest) {
+  auto computed_map = std::make_unique<WeatherHexMap>(planet_, kTimeSteps, 48, 235, 21, 203, false, kRegionGrib);
+  auto table_map = std::make_unique<WeatherHexMap>(planet_, kTimeSteps, 48, 235, 21, 203, false, kRegionGrib);
+  WeatherCostCalculator computed(planet_, computed_map, 1500);
+  WeatherCostCalculator tabled(planet_, table_map, 1500);
+  tabled.BuildCostTables(2);
+  ASSERT_TRUE(tabled.has_cost_tables());
+  EXPECT_EQ((tabled.time_horizon() + 1) *
+                (planet_.graph().neighbour_edge_count() + planet_.graph().indirect_neighbour_edge_count()) *
+                sizeof(uint32_t),
+            tabled.cost_table_memory_usage());
+
+  const HexGraph &graph = planet_.graph();
+  CostCalculator::EdgeResults computed_results, table_results;
+  for (HexVertexId source = 0; source < planet_.vertex_count(); source += 5) {
+    // Time steps past the horizon use the last table.
+    for (uint32_t time = 0; time <= tabled.time_horizon() + 1; time++) {
+      computed.calculate_all(source, time, true, &computed_results);
+      tabled.calculate_all(source, time, true, &table_results);
+      EXPECT_EQ(computed_results.costs, table_results.costs);
+      EXPECT_EQ(computed_results.times, table_results.times);
+
+      for (size_t i = 0; i < graph.neighbour_count(source); i++) {
+        EXPECT_EQ(computed.calculate_neighbour(source, i, time).cost, tabled.calculate_neighbour(source, i, time).cost);
+      }
+      for (HexVertexId target : graph.indirect_neighbours(source)) {
+        EXPECT_EQ(computed.calculate_target(source, target, time).cost,
+                  tabled.calculate_target(source, target, time).cost);
+      }
+    }
+  }
+  EXPECT_THROW(tabled.calculate_neighbour(0, 6, 0), std::runtime_error);
+}
+
+/**
+ * Test that the wind speed cost has no jumps between its pieces below 22 knots.
+ */
+TEST_F(WeatherCostCalculatorTest, WindSpeedCostIsContinuousTest) {
+  static constexpr double kEpsilon = 1e-9;
+  for (double knots : {4.0, 7.0, 12.0, 15.0}) {
+    EXPECT_NEAR(WeatherCostCalculator::wind_speed_cost(knots - kEpsilon),
+                WeatherCostCalculator::wind_speed_cost(knots + kEpsilon), 1e-6) << knots << " knots";
+  }
+  EXPECT_DOUBLE_EQ(0, WeatherCostCalculator::wind_speed_cost(12));
+  EXPECT_DOUBLE_EQ(5, WeatherCostCalculator::wind_speed_cost(15));
+}
@@ -2,11 +2,100 @@
 
 #include "WeatherHexMapTest.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/TemporaryDirectory.h"
+#include "grib/gribParse.h"
+#include "grib/WeatherSnapshotFormat.h"
+
 WeatherHexMapTest::WeatherHexMapTest() : planet_1_(4) {}
 
 /// The number of time steps used to generate the test |WeatherHexMap|
 static constexpr uint32_t kTimeSteps = 4;
 
+namespace {
+
+/// The forecast region of the synthetic snapshots, in integer degrees (longitudes in [0, 360)).
+constexpr int kNorth = 48, kSouth = 21, kEast = 235, kWest = 203;
+
+/// The checked-in GRIB file of wind over the test region, so tests don't download a forecast.
+const char kRegionGrib[] = TEST_DATA_DIRECTORY "/wind_region.grb";
+
+/**
+ * Writes a weather snapshot of the one degree grid over the test region with wind speeds
+ * |wind_speed|(lat, lon, time step) and no other channel.
+ */
+void WriteSnapshot(const std::string &filename, uint32_t time_steps,
+                   const std::function<float(int, int, uint32_t)> &wind_speed) {
+  using weather_snapshot_format::Align;
+  weather_snapshot_format::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, weather_snapshot_format::kMagic, sizeof(header.magic));
+  header.version = weather_snapshot_format::kVersion;
+  header.channel_count = weather_snapshot_format::kChannelCount;
+  header.north = kNorth;
+  header.south = kSouth;
+  header.east = kEast;
+  header.west = kWest;
+  header.grid_point_count = (kNorth - kSouth + 1) * (kEast - kWest + 1);
+  header.time_step_count = time_steps;
+  header.steps_offset = Align(sizeof(header));
+  const uint64_t wind_speed_offset = Align(header.steps_offset + time_steps * sizeof(int64_t));
+  header.channel_offsets[static_cast<size_t>(WeatherHexMap::Channel::kWindSpeed)] = wind_speed_offset;
+
+  std::vector<char> contents(wind_speed_offset + time_steps * header.grid_point_count * sizeof(float));
+  std::memcpy(contents.data(), &header, sizeof(header));
+  for (uint32_t time = 0; time < time_steps; time++) {
+    const int64_t step = time;
+    std::memcpy(contents.data() + header.steps_offset + time * sizeof(int64_t), &step, sizeof(step));
+    for (int lat = kSouth; lat <= kNorth; lat++) {
+      for (int lon = kWest; lon <= kEast; lon++) {
+        const float value = wind_speed(lat, lon, time);
+        const size_t grid_index = (time * (kNorth - kSouth + 1) + (lat - kSouth)) * (kEast - kWest + 1) + lon - kWest;
+        std::memcpy(contents.data() + wind_speed_offset + grid_index * sizeof(float), &value, sizeof(value));
+      }
+    }
+  }
+  std::ofstream(filename, std::ios::binary).write(contents.data(), contents.size());
+}
+
+/**
+ * @return The coordinate at |lat|, |lon| degrees.
+ */
+GPSCoordinate Coordinate(double lat, double lon) {
+  return GPSCoordinate(static_cast<int32_t>(std::lround(lat * GPSCoordinate::kExactCoordinateScaleFactor)),
+                       static_cast<int32_t>(std::lround(lon * GPSCoordinate::kExactCoordinateScaleFactor)));
+}
+
+/**
+ * @return The snapshot grid index of |lat|, |lon| (longitude in [0, 360)).
+ */
+int32_t GridIndex(int lat, int lon) {
+  return (lat - kSouth) * (kEast - kWest + 1) + lon - kWest;
+}
+
+/**
+ * @return The position |stencil| blends, which bilinear interpolation reproduces exactly.
+ */
+std::pair<double, double> BlendedPosition(const WeatherHexMap::Stencil &stencil) {
+  double lat = 0, lon = 0;
+  for (size_t i = 0; i < WeatherHexMap::kStencilSize; i++) {
+    lat += stencil.weights[i] * (kSouth + stencil.grid_indices[i] / (kEast - kWest + 1));
+    lon += stencil.weights[i] * (kWest + stencil.grid_indices[i] % (kEast - kWest + 1));
+  }
+  return {lat, lon};
+}
+
+}  // namespace
+
 /**
  * Test stored |WeatherDatum|s.
  */
@@ -30,3 +119,220 @@ TEST_F(WeatherHexMapTest, GetRiskForInvalidVertexOrTimeTest) {
   EXPECT_THROW(map.get_weather(kInvalidHexVertexId, 0), std::runtime_error);
   EXPECT_THROW(map.get_weather(static_cast<HexVertexId>(planet_1_.vertex_count()), 0), std::runtime_error);
 }
+
+/**
+ * Test that only the wind channels are stored, as floats, and that the others read as 0.
+ */
+TEST_F(WeatherHexMapTest, StoresOnlyWindChannelsTest) {
+  WeatherHexMap map(planet_1_, kTimeSteps, kNorth, kEast, kSouth, kWest, false, kRegionGrib);
+
+  EXPECT_TRUE(map.has_channel(WeatherHexMap::Channel::kWindSpeed));
+  EXPECT_TRUE(map.has_channel(WeatherHexMap::Channel::kWindDirection));
+  EXPECT_FALSE(map.has_channel(WeatherHexMap::Channel::kCurrentSpeed));
+  EXPECT_FALSE(map.has_channel(WeatherHexMap::Channel::kCurrentDirection));
+  EXPECT_FALSE(map.has_channel(WeatherHexMap::Channel::kWaveHeight));
+
+  const WeatherDatum datum = map.get_weather(0, 1);
+  EXPECT_FLOAT_EQ(map.get(WeatherHexMap::Channel::kWindSpeed, 0, 1), datum.wind_speed);
+  EXPECT_EQ(0.0, datum.current_speed);
+  EXPECT_EQ(0.0, datum.wave_height);
+  // Times past the last time step read the last one.
+  EXPECT_EQ(map.get(WeatherHexMap::Channel::kWindSpeed, 0, kTimeSteps - 1),
+            map.get(WeatherHexMap::Channel::kWindSpeed, 0, kTimeSteps + 5));
+}
+
+/**
+ * Test that vertices are only mapped to the weather grid when they are looked up.
+ */
+TEST_F(WeatherHexMapTest, MapsVerticesLazilyTest) {
+  // Several tiles.
+  const HexPlanet planet(5);
+  WeatherHexMap map(planet, kTimeSteps, kNorth, kEast, kSouth, kWest, false, kRegionGrib);
+  const size_t initial_memory = map.memory_usage();
+
+  // Find a vertex in the forecast region without looking it up.
+  HexVertexId in_region_vertex = kInvalidHexVertexId;
+  for (HexVertexId vertex_id = 0; vertex_id < planet.vertex_count(); vertex_id++) {
+    const auto &coord = planet.vertex(vertex_id).coordinate;
+    const int lat = coord.round_to_int_latitude();
+    const int lon = (coord.round_to_int_longitude() + 360) % 360;
+    if (lat >= kSouth && lat <= kNorth && lon >= kWest && lon <= kEast) {
+      in_region_vertex = vertex_id;
+      break;
+    }
+  }
+  ASSERT_NE(kInvalidHexVertexId, in_region_vertex);
+
+  // Looking it up maps exactly one tile.
+  map.get(WeatherHexMap::Channel::kWindSpeed, in_region_vertex, 0);
+  EXPECT_EQ(initial_memory + WeatherHexMap::kTileSize * sizeof(WeatherHexMap::Stencil), map.memory_usage());
+
+  // Vertices outside of the forecast region have a constant high wind speed.
+  size_t out_of_region_count = 0;
+  for (HexVertexId vertex_id = 0; vertex_id < planet.vertex_count(); vertex_id++) {
+    const float wind_speed = map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, 0);
+    if (wind_speed == WeatherHexMap::kOutOfRegionWindSpeed) {
+      out_of_region_count++;
+      EXPECT_EQ(0.0f, map.get(WeatherHexMap::Channel::kWindDirection, vertex_id, 0));
+    }
+  }
+  EXPECT_GT(out_of_region_count, 0u);
+  EXPECT_LT(out_of_region_count, planet.vertex_count());
+}
+
+/**
+ * Test that a map read from a weather snapshot matches the one read from the GRIB file it was saved from.
+ */
+TEST_F(WeatherHexMapTest, ReadsSnapshotTest) {
+  TemporaryDirectory directory;
+  const std::string grib = std::string(TEST_DATA_DIRECTORY) + "/wind_region.grb";
+  const std::string snapshot = directory.path("weather.snap");
+  WeatherHexMap grib_map(planet_1_, kTimeSteps, 48, 235, 21, 203, false, grib);
+  gribParse(grib, kTimeSteps).saveSnapshot(snapshot);
+  ASSERT_TRUE(WeatherHexMap::IsSnapshotFile(snapshot));
+  EXPECT_FALSE(WeatherHexMap::IsSnapshotFile(grib));
+
+  WeatherHexMap snapshot_map(planet_1_, kTimeSteps, 48, 235, 21, 203, false, snapshot);
+  EXPECT_TRUE(snapshot_map.has_channel(WeatherHexMap::Channel::kWindSpeed));
+  EXPECT_FALSE(snapshot_map.has_channel(WeatherHexMap::Channel::kWaveHeight));
+  for (HexVertexId vertex = 0; vertex < planet_1_.vertex_count(); vertex++) {
+    for (uint32_t time = 0; time < kTimeSteps; time++) {
+      EXPECT_EQ(grib_map.get(WeatherHexMap::Channel::kWindSpeed, vertex, time),
+                snapshot_map.get(WeatherHexMap::Channel::kWindSpeed, vertex, time));
+      EXPECT_EQ(grib_map.get(WeatherHexMap::Channel::kWindDirection, vertex, time),
+                snapshot_map.get(WeatherHexMap::Channel::kWindDirection, vertex, time));
+    }
+  }
+
+  // The snapshot must cover the requested region.
+  EXPECT_THROW(WeatherHexMap(planet_1_, kTimeSteps, 40, 235, 21, 203, false, snapshot), std::runtime_error);
+}
+
+/**
+ * Test that maps of the same weather have the same fingerprint, and other weather or interpolation another one.
+ */
+TEST_F(WeatherHexMapTest, FingerprintsWeatherTest) {
+  TemporaryDirectory directory;
+  WriteSnapshot(directory.path("a.snap"), kTimeSteps, [](int lat, int, uint32_t) { return static_cast<float>(lat); });
+  WriteSnapshot(directory.path("b.snap"), kTimeSteps, [](int lat, int, uint32_t) { return static_cast<float>(lat); });
+  WriteSnapshot(directory.path("c.snap"), kTimeSteps, [](int lat, int, uint32_t time) {
+    return static_cast<float>(lat + (time == kTimeSteps - 1 ? 1 : 0));
+  });
+  auto map = [&](const std::string &name, WeatherHexMap::Interpolation interpolation) {
+    return std::make_unique<WeatherHexMap>(planet_1_, kTimeSteps, kNorth, kEast, kSouth, kWest, false,
+                                           directory.path(name), false, "", WindKmlOptions(), interpolation);
+  };
+
+  const uint64_t fingerprint = map("a.snap", WeatherHexMap::Interpolation::kNearest)->fingerprint();
+  EXPECT_EQ(fingerprint, map("b.snap", WeatherHexMap::Interpolation::kNearest)->fingerprint());
+  EXPECT_NE(fingerprint, map("c.snap", WeatherHexMap::Interpolation::kNearest)->fingerprint());
+  EXPECT_NE(fingerprint, map("a.snap", WeatherHexMap::Interpolation::kBilinear)->fingerprint());
+}
+
+/**
+ * Test that bilinear stencils weigh a grid node fully at the node, blend the four surrounding grid points with weights
+ * that sum to 1 in between, and clamp to the edges of the grid.
+ */
+TEST_F(WeatherHexMapTest, ComputesBilinearStencilTest) {
+  TemporaryDirectory directory;
+  const std::string snapshot = directory.path("weather.snap");
+  WriteSnapshot(snapshot, kTimeSteps, [](int lat, int lon, uint32_t) { return static_cast<float>(lat + 2 * lon); });
+  WeatherHexMap map(planet_1_, kTimeSteps, kNorth, kEast, kSouth, kWest, false, snapshot, false, "",
+                    WindKmlOptions(), WeatherHexMap::Interpolation::kBilinear);
+
+  // Exact at a grid node.
+  WeatherHexMap::Stencil stencil = map.ComputeStencil(Coordinate(30, -140));
+  EXPECT_EQ(GridIndex(30, 220), stencil.grid_indices[0]);
+  EXPECT_EQ(1.0f, stencil.weights[0]);
+  EXPECT_EQ(0.0f, stencil.weights[1]);
+  EXPECT_EQ(0.0f, stencil.weights[2]);
+  EXPECT_EQ(0.0f, stencil.weights[3]);
+
+  // In between, the cell around the position.
+  stencil = map.ComputeStencil(Coordinate(30.25, -139.5));
+  EXPECT_EQ(GridIndex(30, 220), stencil.grid_indices[0]);
+  EXPECT_EQ(GridIndex(30, 221), stencil.grid_indices[1]);
+  EXPECT_EQ(GridIndex(31, 220), stencil.grid_indices[2]);
+  EXPECT_EQ(GridIndex(31, 221), stencil.grid_indices[3]);
+  EXPECT_FLOAT_EQ(0.375f, stencil.weights[0]);
+  EXPECT_FLOAT_EQ(0.375f, stencil.weights[1]);
+  EXPECT_FLOAT_EQ(0.125f, stencil.weights[2]);
+  EXPECT_FLOAT_EQ(0.125f, stencil.weights[3]);
+
+  // Past the edges (but rounding into the region), clamped to them.
+  stencil = map.ComputeStencil(Coordinate(48.3, -140));
+  EXPECT_EQ(GridIndex(48, 220), stencil.grid_indices[2]);
+  EXPECT_FLOAT_EQ(1.0f, stencil.weights[2]);
+  stencil = map.ComputeStencil(Coordinate(48.4, -124.6));
+  EXPECT_EQ(GridIndex(48, 235), stencil.grid_indices[3]);
+  EXPECT_FLOAT_EQ(1.0f, stencil.weights[3]);
+  stencil = map.ComputeStencil(Coordinate(20.6, -157.4));
+  EXPECT_EQ(GridIndex(21, 203), stencil.grid_indices[0]);
+  EXPECT_FLOAT_EQ(1.0f, stencil.weights[0]);
+
+  // Outside of the region.
+  EXPECT_EQ(WeatherHexMap::kOutOfRegion, map.ComputeStencil(Coordinate(49, -140)).grid_indices[0]);
+  EXPECT_EQ(WeatherHexMap::kOutOfRegion, map.ComputeStencil(Coordinate(30, -120)).grid_indices[0]);
+
+  // Every vertex in the region blends grid points with weights that sum to 1, which reproduce the (clamped) position
+  // and so the linear wind speeds of the snapshot.
+  size_t in_region_count = 0;
+  for (HexVertexId vertex_id = 0; vertex_id < planet_1_.vertex_count(); vertex_id++) {
+    const GPSCoordinate &coord = planet_1_.vertex(vertex_id).coordinate;
+    stencil = map.ComputeStencil(coord);
+    if (stencil.grid_indices[0] == WeatherHexMap::kOutOfRegion) {
+      continue;
+    }
+    in_region_count++;
+
+    float weight_sum = 0;
+    for (size_t i = 0; i < WeatherHexMap::kStencilSize; i++) {
+      EXPECT_GE(stencil.weights[i], 0.0f);
+      EXPECT_GE(stencil.grid_indices[i], 0);
+      EXPECT_LT(stencil.grid_indices[i], GridIndex(kNorth, kEast) + 1);
+      weight_sum += stencil.weights[i];
+    }
+    EXPECT_NEAR(1.0f, weight_sum, 1e-6f);
+
+    const double lat = static_cast<double>(coord.latitude_exact()) / GPSCoordinate::kExactCoordinateScaleFactor;
+    double lon = static_cast<double>(coord.longitude_exact()) / GPSCoordinate::kExactCoordinateScaleFactor;
+    lon = lon < 0 ? lon + 360 : lon;
+    // Within the precision of the float weights.
+    const std::pair<double, double> position = BlendedPosition(stencil);
+    EXPECT_NEAR(std::min<double>(std::max<double>(lat, kSouth), kNorth), position.first, 1e-4);
+    EXPECT_NEAR(std::min<double>(std::max<double>(lon, kWest), kEast), position.second, 1e-4);
+    EXPECT_NEAR(position.first + 2 * position.second, map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, 0),
+                1e-3);
+  }
+  EXPECT_GT(in_region_count, 0u);
+}
+
+/**
+ * Test that pathfinder time steps in between forecast steps blend the two surrounding forecast steps linearly.
+ */
+TEST_F(WeatherHexMapTest, BlendsForecastStepsTest) {
+  TemporaryDirectory directory;
+  const std::string snapshot = directory.path("weather.snap");
+  WriteSnapshot(snapshot, kTimeSteps, [](int lat, int, uint32_t time) { return static_cast<float>(lat + 10 * time); });
+  constexpr uint32_t kStepsPerForecast = 4;
+  WeatherHexMap map(planet_1_, kTimeSteps, kNorth, kEast, kSouth, kWest, false, snapshot, false, "",
+                    WindKmlOptions(), WeatherHexMap::Interpolation::kNearest, kStepsPerForecast);
+  EXPECT_EQ((kTimeSteps - 1) * kStepsPerForecast, map.time_horizon());
+
+  for (HexVertexId vertex_id = 0; vertex_id < planet_1_.vertex_count(); vertex_id++) {
+    const float wind_speed = map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, 0);
+    if (wind_speed == WeatherHexMap::kOutOfRegionWindSpeed) {
+      EXPECT_EQ(wind_speed, map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, 5));
+      continue;
+    }
+
+    for (uint32_t time = 0; time <= map.time_horizon(); time++) {
+      const float expected = wind_speed + 10.0f * time / kStepsPerForecast;
+      EXPECT_FLOAT_EQ(expected, map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, time));
+      EXPECT_FLOAT_EQ(expected, map.get_weather(vertex_id, time).wind_speed);
+    }
+    // Times past the last forecast step read the last one.
+    EXPECT_FLOAT_EQ(wind_speed + 10.0f * (kTimeSteps - 1),
+                    map.get(WeatherHexMap::Channel::kWindSpeed, vertex_id, map.time_horizon() + 3));
+  }
+}
@@ -0,0 +1,49 @@
+// Copyright 2022 UBC Sailbot
+
+#include "HexGraphTest.h"
+
+#include <planet/HexPlanet.h>
+
+/// The planet subdivision count used for tests
+static constexpr uint8_t kTestPlanetSize = 4;
+
+HexGraphTest::HexGraphTest() {}
+
+/**
+ * Check that the compact graph of a planet has exactly the same adjacency (in the same order) as its vertices.
+ */
+TEST_F(HexGraphTest, MatchesPlanetVerticesTest) {
+  HexPlanet hex_planet = HexPlanet(kTestPlanetSize);
+  const HexGraph &graph = hex_planet.graph();
+
+  ASSERT_EQ(hex_planet.vertex_count(), graph.vertex_count());
+
+  size_t neighbour_edge_count = 0;
+  size_t indirect_neighbour_edge_count = 0;
+  for (HexVertexId i = 0; i < hex_planet.vertex_count(); i++) {
+    const HexVertex &vertex = hex_planet.vertex(i);
+
+    auto neighbours = graph.neighbours(i);
+    auto neighbour_distances = graph.neighbour_distances(i);
+    ASSERT_EQ(vertex.neighbour_count, graph.neighbour_count(i));
+    ASSERT_EQ(vertex.neighbour_count, neighbours.size());
+    ASSERT_EQ(vertex.neighbour_count, neighbour_distances.size());
+    EXPECT_EQ(neighbour_edge_count, graph.neighbour_offset(i));
+    for (size_t j = 0; j < vertex.neighbour_count; j++) {
+      EXPECT_EQ(vertex.neighbours[j], neighbours[j]);
+      EXPECT_EQ(vertex.neighbour_distances[j], neighbour_distances[j]);
+    }
+
+    auto indirect_neighbours = graph.indirect_neighbours(i);
+    EXPECT_EQ(indirect_neighbour_edge_count, graph.indirect_offset(i));
+    EXPECT_EQ(vertex.indirect_neighbours, std::vector<HexVertexId>(indirect_neighbours.begin(),
+                                                                   indirect_neighbours.end()));
+
+    neighbour_edge_count += neighbours.size();
+    indirect_neighbour_edge_count += indirect_neighbours.size();
+  }
+
+  EXPECT_EQ(neighbour_edge_count, graph.neighbour_edge_count());
+  EXPECT_EQ(indirect_neighbour_edge_count, graph.indirect_neighbour_edge_count());
+  EXPECT_GT(graph.memory_usage(), 0u);
+}
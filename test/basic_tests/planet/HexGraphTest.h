@@ -0,0 +1,13 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PLANET_HEXGRAPHTEST_H_
+#define PLANET_HEXGRAPHTEST_H_
+
+#include <gtest/gtest.h>
+
+class HexGraphTest : public ::testing::Test {
+ protected:
+  HexGraphTest();
+};
+
+#endif  // PLANET_HEXGRAPHTEST_H_
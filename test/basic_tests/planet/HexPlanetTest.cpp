@@ -2,7 +2,18 @@
 
 #include "HexPlanetTest.h"
 
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
 #include <planet/HexPlanet.h>
+#include <planet/HexPlanetFormat.h>
+#include <logic/StandardCalc.h>
+
+#include "common/TemporaryDirectory.h"
 
 /// The planet subdivision count used for tests
 static constexpr uint8_t kTestPlanetSize = 6;
@@ -101,3 +112,136 @@ TEST_F(HexPlanetTest, ComputeIndirectVertexNeighboursTest) {
     }
   }
 }
+
+/**
+ * Check that a planet written in the binary format is read back exactly, and that text files aren't mistaken for it.
+ */
+TEST_F(HexPlanetTest, BinaryFileRoundTripTest) {
+  static constexpr uint8_t kTestBinaryPlanetSize = 3;
+  const std::string binary_filename = "hex_planet_test.bin";
+  const std::string text_filename = "hex_planet_test.txt";
+
+  HexPlanet hex_planet = HexPlanet(kTestBinaryPlanetSize);
+  hex_planet.WriteBinaryToFile(binary_filename);
+  hex_planet.WriteToFile(text_filename);
+
+  EXPECT_TRUE(HexPlanet::IsBinaryFile(binary_filename));
+  EXPECT_FALSE(HexPlanet::IsBinaryFile(text_filename));
+  EXPECT_FALSE(HexPlanet::IsBinaryFile("non_existent_planet.bin"));
+
+  HexPlanet stored_planet = HexPlanet(binary_filename);
+  EXPECT_EQ(hex_planet.subdivision_level(), stored_planet.subdivision_level());
+  ASSERT_EQ(hex_planet.vertex_count(), stored_planet.vertex_count());
+  ASSERT_EQ(hex_planet.triangle_count(), stored_planet.triangle_count());
+
+  for (HexVertexId i = 0; i < hex_planet.vertex_count(); i++) {
+    const HexVertex &expected = hex_planet.vertex(i);
+    const HexVertex &actual = stored_planet.vertex(i);
+    EXPECT_EQ(expected.normal(), actual.vertex_position);
+    EXPECT_EQ(expected.coordinate, actual.coordinate);
+    EXPECT_EQ(expected.neighbour_count, actual.neighbour_count);
+    EXPECT_EQ(expected.neighbours, actual.neighbours);
+    EXPECT_EQ(expected.neighbour_distances, actual.neighbour_distances);
+    EXPECT_EQ(expected.indirect_neighbours, actual.indirect_neighbours);
+  }
+
+  for (size_t i = 0; i < hex_planet.triangle_count(); i++) {
+    EXPECT_EQ(hex_planet.triangle(i).vertex_a, stored_planet.triangle(i).vertex_a);
+    EXPECT_EQ(hex_planet.triangle(i).vertex_b, stored_planet.triangle(i).vertex_b);
+    EXPECT_EQ(hex_planet.triangle(i).vertex_c, stored_planet.triangle(i).vertex_c);
+  }
+
+  // The text format is still readable
+  HexPlanet text_planet = HexPlanet(text_filename);
+  EXPECT_EQ(hex_planet.vertex_count(), text_planet.vertex_count());
+  EXPECT_EQ(hex_planet.triangle_count(), text_planet.triangle_count());
+
+  std::remove(binary_filename.c_str());
+  std::remove(text_filename.c_str());
+}
+
+/**
+ * Check that reading a binary planet file with out of range neighbour counts or vertex IDs throws instead of reading
+ * out of bounds.
+ */
+TEST_F(HexPlanetTest, CorruptBinaryFileTest) {
+  TemporaryDirectory directory;
+  const std::string binary_filename = directory.path("planet.bin");
+  HexPlanet(3).WriteBinaryToFile(binary_filename);
+  std::ifstream is(binary_filename, std::ios::binary);
+  const std::string contents((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  hex_planet_format::Header header;
+  std::memcpy(&header, contents.data(), sizeof(header));
+  const uint32_t vertex_count = static_cast<uint32_t>(header.vertex_count);
+
+  // Overwrite the uint32_t at |offset| and read the planet back
+  auto read_corrupted = [&](uint64_t offset, uint32_t value) {
+    std::string corrupted = contents;
+    std::memcpy(&corrupted[offset], &value, sizeof(value));
+    const std::string corrupted_filename = directory.path("corrupted.bin");
+    std::ofstream(corrupted_filename, std::ios::binary).write(corrupted.data(), corrupted.size());
+    HexPlanet planet(corrupted_filename);
+  };
+
+  ASSERT_GT(header.indirect_neighbour_count, 0u);
+  EXPECT_THROW(read_corrupted(header.neighbour_counts_offset, HexVertex::kMaxHexVertexNeighbourCount + 1),
+               std::runtime_error);
+  EXPECT_THROW(read_corrupted(header.neighbours_offset, vertex_count), std::runtime_error);
+  EXPECT_THROW(read_corrupted(header.indirect_neighbours_offset, vertex_count), std::runtime_error);
+  EXPECT_THROW(read_corrupted(header.triangles_offset, vertex_count), std::runtime_error);
+}
+
+/**
+ * Check that building a planet on several threads gives exactly the same planet as building it on one thread.
+ */
+TEST_F(HexPlanetTest, MultithreadedCreationTest) {
+  HexPlanet serial_planet = HexPlanet(kTestPlanetSize, 2, 1);
+  HexPlanet parallel_planet = HexPlanet(kTestPlanetSize, 2, 4);
+  ASSERT_EQ(serial_planet.vertex_count(), parallel_planet.vertex_count());
+  ASSERT_EQ(serial_planet.triangle_count(), parallel_planet.triangle_count());
+
+  for (HexVertexId i = 0; i < serial_planet.vertex_count(); i++) {
+    const HexVertex &expected = serial_planet.vertex(i);
+    const HexVertex &actual = parallel_planet.vertex(i);
+    EXPECT_EQ(expected.vertex_position, actual.vertex_position);
+    EXPECT_EQ(expected.coordinate, actual.coordinate);
+    EXPECT_EQ(expected.neighbour_count, actual.neighbour_count);
+    EXPECT_EQ(expected.neighbours, actual.neighbours);
+    EXPECT_EQ(expected.neighbour_distances, actual.neighbour_distances);
+    EXPECT_EQ(expected.indirect_neighbours, actual.indirect_neighbours);
+  }
+
+  for (size_t i = 0; i < serial_planet.triangle_count(); i++) {
+    EXPECT_EQ(serial_planet.triangle(i).vertex_a, parallel_planet.triangle(i).vertex_a);
+    EXPECT_EQ(serial_planet.triangle(i).vertex_b, parallel_planet.triangle(i).vertex_b);
+    EXPECT_EQ(serial_planet.triangle(i).vertex_c, parallel_planet.triangle(i).vertex_c);
+  }
+}
+
+/**
+ * Check the closed-form vertex distances against the Haversine formula, and the batched variants against single calls.
+ */
+TEST_F(HexPlanetTest, DistanceBetweenVerticesTest) {
+  HexPlanet hex_planet = HexPlanet(kTestPlanetSize, 0);
+  const HexVertexId target = 1234;
+
+  const std::vector<uint32_t> distances_to_target = hex_planet.DistancesToVertex(target, 3);
+  ASSERT_EQ(hex_planet.vertex_count(), distances_to_target.size());
+
+  std::vector<HexVertexId> sources;
+  for (HexVertexId i = 0; i < hex_planet.vertex_count(); i++) {
+    const uint32_t distance = hex_planet.DistanceBetweenVertices(i, target);
+    const uint32_t haversine_distance = standard_calc::DistBetweenTwoCoords(hex_planet.vertex(i).coordinate,
+                                                                            hex_planet.vertex(target).coordinate);
+    // Both truncate to whole meters, so rounding may differ by one.
+    EXPECT_NEAR(haversine_distance, distance, 1);
+    EXPECT_EQ(distance, hex_planet.DistanceBetweenVertices(target, i));
+    EXPECT_EQ(distance, distances_to_target[i]);
+    sources.push_back(i);
+  }
+  EXPECT_EQ(0u, distances_to_target[target]);
+
+  std::vector<uint32_t> distances_from_target;
+  hex_planet.DistancesFromVertex(target, sources, &distances_from_target);
+  EXPECT_EQ(distances_to_target, distances_from_target);
+}
@@ -0,0 +1,72 @@
+// Copyright 2022 UBC Sailbot
+
+#include "HexVertexIndexTest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <planet/HexPlanet.h>
+#include <logic/StandardCalc.h>
+
+/// The planet subdivision count used for tests
+static constexpr uint8_t kTestPlanetSize = 5;
+/// The number of random points to look up
+static constexpr size_t kTestPointCount = 2000;
+
+HexVertexIndexTest::HexVertexIndexTest() {}
+
+/**
+ * @return The largest dot product between |point| and any vertex, found by a linear scan.
+ */
+static float BruteForceBestDot(const HexPlanet &planet, const Eigen::Vector3f &point) {
+  const Eigen::Vector3f direction = point.normalized();
+  float best_dot = -2.0f;
+  for (HexVertexId i = 0; i < planet.vertex_count(); i++) {
+    best_dot = std::max(best_dot, planet.vertex(i).vertex_position.dot(direction));
+  }
+  return best_dot;
+}
+
+/**
+ * Check that the spatial index finds the nearest vertex (up to float rounding) for random points.
+ */
+TEST_F(HexVertexIndexTest, MatchesBruteForceTest) {
+  HexPlanet hex_planet = HexPlanet(kTestPlanetSize, 0);
+
+  std::mt19937 generator(42);
+  std::normal_distribution<float> distribution;
+  for (size_t i = 0; i < kTestPointCount; i++) {
+    const Eigen::Vector3f point(distribution(generator), distribution(generator), distribution(generator));
+    const HexVertexId nearest = hex_planet.NearestVertex(point);
+    ASSERT_LT(nearest, hex_planet.vertex_count());
+    const float nearest_dot = hex_planet.vertex(nearest).vertex_position.dot(point.normalized());
+    EXPECT_NEAR(BruteForceBestDot(hex_planet, point), nearest_dot, 1e-6);
+  }
+}
+
+/**
+ * Check that every vertex is its own nearest vertex, and that the batched lookups agree with single lookups.
+ */
+TEST_F(HexVertexIndexTest, VertexLookupTest) {
+  HexPlanet hex_planet = HexPlanet(kTestPlanetSize, 0);
+
+  std::vector<Eigen::Vector3f> points;
+  std::vector<GPSCoordinateFast> coordinates;
+  for (HexVertexId i = 0; i < hex_planet.vertex_count(); i++) {
+    const HexVertex &vertex = hex_planet.vertex(i);
+    EXPECT_EQ(i, hex_planet.NearestVertex(vertex.vertex_position));
+    points.push_back(vertex.vertex_position);
+    coordinates.push_back(vertex.coordinate);
+  }
+
+  const std::vector<HexVertexId> point_ids = hex_planet.NearestVertices(points, 3);
+  const std::vector<HexVertexId> coordinate_ids = hex_planet.NearestVertices(coordinates, 3);
+  ASSERT_EQ(points.size(), point_ids.size());
+  ASSERT_EQ(coordinates.size(), coordinate_ids.size());
+  for (HexVertexId i = 0; i < hex_planet.vertex_count(); i++) {
+    EXPECT_EQ(i, point_ids[i]);
+    EXPECT_EQ(hex_planet.NearestVertex(coordinates[i]), coordinate_ids[i]);
+    EXPECT_EQ(i, coordinate_ids[i]);
+  }
+}
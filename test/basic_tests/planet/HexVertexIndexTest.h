@@ -0,0 +1,13 @@
+// Copyright 2022 UBC Sailbot
+
+#ifndef PLANET_HEXVERTEXINDEXTEST_H_
+#define PLANET_HEXVERTEXINDEXTEST_H_
+
+#include <gtest/gtest.h>
+
+class HexVertexIndexTest : public ::testing::Test {
+ protected:
+  HexVertexIndexTest();
+};
+
+#endif  // PLANET_HEXVERTEXINDEXTEST_H_